@@ -0,0 +1,50 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "../src/model/collision_detector.h"
+
+using namespace collision_detector;
+using namespace geom;
+using namespace std::literals;
+
+namespace {
+// Сцена, похожая на игровую: собаки идут вдоль осей, трофеев примерно столько же,
+// сколько собак, плюс несколько офисов. Плотность постоянная - сторона карты
+// растёт как корень из числа собак
+ItemGatherer MakeScene(size_t gatherers) {
+    std::mt19937 gen{42};
+    const double map_size = 10.0 * std::sqrt(static_cast<double>(gatherers));
+    std::uniform_real_distribution<double> coord{0.0, map_size};
+    std::uniform_real_distribution<double> step{-0.5, 0.5};
+    ItemGatherer scene;
+    for (size_t i = 0; i < gatherers; ++i) {
+        scene.Add(Item{.position{coord(gen), coord(gen)}, .width = 0.0});
+    }
+    for (size_t i = 0; i < 10; ++i) {
+        scene.Add(Item{.position{coord(gen), coord(gen)}, .width = 0.25});
+    }
+    for (size_t g = 0; g < gatherers; ++g) {
+        Point2D start{coord(gen), coord(gen)};
+        Point2D end = start;
+        (g % 2 ? end.x : end.y) += step(gen);
+        scene.Add(Gatherer{.start_pos = start, .end_pos = end, .width = 0.3});
+    }
+    return scene;
+}
+}  // namespace
+
+TEST_CASE("FindGatherEvents: grid vs brute force", "[.][benchmark]") {
+    for (size_t gatherers : {10u, 100u, 1000u, 10000u}) {
+        const auto scene = MakeScene(gatherers);
+        const auto suffix = " "s + std::to_string(gatherers) + " gatherers"s;
+        BENCHMARK("brute force"s + suffix) {
+            return FindGatherEventsBruteForce(scene);
+        };
+        BENCHMARK("grid"s + suffix) {
+            return FindGatherEvents(scene);
+        };
+    }
+}
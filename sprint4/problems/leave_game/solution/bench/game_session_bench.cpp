@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/coordinator.h"
+#include "../src/model/model.h"
+
+using namespace model;
+using namespace std::literals;
+namespace net = boost::asio;
+
+namespace {
+// Карта-решётка: дороги через каждые 10 единиц, один офис, два типа трофеев
+Map MakeGridMap(int cells, const std::string& id = "bench"s) {
+    Map map{Map::Id{id}, id, DefaultMapParam{.dog_speed = 4.0, .bag_capacity = 3}};
+    const Coord size = cells * 10;
+    for (Coord c = 0; c <= size; c += 10) {
+        map.AddRoad(Road(Road::HORIZONTAL, Point{0, c}, size, map.GetRoadOffset()));
+        map.AddRoad(Road(Road::VERTICAL, Point{c, 0}, size, map.GetRoadOffset()));
+    }
+    map.AddOffice(Office(Office::Id{"o0"s}, Point{10, 10}, Offset{0, 0}));
+    map.AddLoot(1);
+    map.AddLoot(2);
+    return map;
+}
+}  // namespace
+
+TEST_CASE("GameSession::Tick with 10k dogs", "[.][benchmark]") {
+    const Map map = MakeGridMap(20);
+    GameSession session{std::make_shared<const MapIndex>(map), true, LootGeneratorConfig{.period = 5s, .probability = 0.5}};
+    std::vector<Dog::Id> dogs;
+    for (int i = 0; i < 10000; ++i) {
+        dogs.push_back(session.AddDog("dog"s + std::to_string(i)));
+    }
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> move{0, 4};
+    BENCHMARK("tick 50ms") {
+        for (size_t i = gen() % 10; i < dogs.size(); i += 10) {
+            session.MoveDog(dogs[i], static_cast<Move>(move(gen)));
+        }
+        session.Tick(50ms);
+    };
+}
+
+// Серверный тик: Coordinator раздаёт сессии по strand'ам, параллельность
+// задаётся числом потоков io_context (его и меняет бенчмарк)
+TEST_CASE("Coordinator::Tick latency vs session count", "[.][benchmark]") {
+    constexpr int DOGS_PER_SESSION = 2000;
+    std::vector<unsigned> thread_counts{1, 2, 4};
+    if (const auto hardware = std::thread::hardware_concurrency(); hardware > thread_counts.back())
+        thread_counts.push_back(hardware);
+    for (unsigned threads : thread_counts) {
+        for (int sessions : {1, 2, 4, 8, 16}) {
+            // собаки не успевают уйти из игры за время замера
+            Game game{GameParam{.dog_retirement_time = 24h,
+                .loot_generator_config_ = LootGeneratorConfig{.period = 5s, .probability = 0.5}}};
+            for (int i = 0; i < sessions; ++i) {
+                game.AddMap(MakeGridMap(20, "map"s + std::to_string(i)));
+            }
+            game.BuildMapIndexes();
+            std::mt19937 gen{42};
+            std::uniform_int_distribution<int> move{0, 3};
+            for (const auto& map : game.GetMaps()) {
+                auto* session = game.AddGameSession(map.GetId());
+                for (int d = 0; d < DOGS_PER_SESSION; ++d) {
+                    session->MoveDog(session->AddDog("dog"s), static_cast<Move>(move(gen)));
+                }
+            }
+            app::App game_app{game, {1, ""s}};
+            net::io_context ioc{static_cast<int>(threads)};
+            auto work = net::make_work_guard(ioc);
+            std::vector<std::jthread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&ioc] { ioc.run(); });
+            }
+            auto coordinator = std::make_shared<app::Coordinator>(ioc, game_app);
+            BENCHMARK(std::to_string(threads) + " threads, "s + std::to_string(sessions) + " sessions"s) {
+                std::promise<void> ticked;
+                coordinator->Tick(50ms, [&ticked] { ticked.set_value(); });
+                ticked.get_future().wait();
+            };
+            work.reset();
+            ioc.stop();
+        }
+    }
+}
+
+TEST_CASE("Idle dogs lookup with 10k dogs", "[.][benchmark]") {
+    const Map map = MakeGridMap(20);
+    GameSession session{std::make_shared<const MapIndex>(map), true, LootGeneratorConfig{.period = 5s, .probability = 0.5}};
+    std::vector<Dog::Id> dogs;
+    for (int i = 0; i < 10000; ++i) {
+        dogs.push_back(session.AddDog("dog"s + std::to_string(i)));
+    }
+    session.Tick(50ms);
+    // обычный тик: уходить некому
+    BENCHMARK("full scan") {
+        size_t idle = 0;
+        for (const auto& dog : session.GetDogs())
+            idle += dog.GetStayTime() >= 60s;
+        return idle;
+    };
+    BENCHMARK("TakeIdleDogs") {
+        return session.TakeIdleDogs(60s).size();
+    };
+}
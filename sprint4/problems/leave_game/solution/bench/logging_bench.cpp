@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+#include "../src/log.h"
+
+using namespace server_logging;
+using namespace std::literals;
+
+namespace {
+constexpr int THREADS = 4;
+constexpr int REQUESTS_PER_THREAD = 50'000;
+
+double ThreadCpuSeconds() {
+    rusage usage{};
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// Каждый поток пишет запрос и ответ, как сессия на один HTTP-запрос.
+// Возвращает суммарное процессорное время пишущих потоков
+template <typename Log>
+double LogRequests(Log& log) {
+    const auto address = net::ip::make_address("192.168.1.15");
+    std::vector<double> cpu(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t] {
+            const auto start = ThreadCpuSeconds();
+            for (int i = 0; i < REQUESTS_PER_THREAD; ++i) {
+                log.Request(address, "/api/v1/game/state?since=12345"sv, http::verb::get);
+                log.Response(i % 7, 200, "application/json"sv);
+            }
+            cpu[t] = ThreadCpuSeconds() - start;
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    double total = 0;
+    for (double seconds : cpu)
+        total += seconds;
+    return total;
+}
+
+constexpr uint64_t RECORDS = 2ull * THREADS * REQUESTS_PER_THREAD;
+
+void Report(std::string_view name, double seconds, double io_cpu, uint64_t written) {
+    std::cout << name << ": " << written / seconds / 1e6 << " M records/s written, "
+        << io_cpu / RECORDS * 1e9 << " ns of I/O thread CPU per record, "
+        << RECORDS - written << " of " << RECORDS << " lost\n";
+}
+
+template <typename Fn>
+double Seconds(Fn&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BenchAsync(std::string_view name, const AsyncLogConfig& config, std::ostream& os) {
+    double io_cpu = 0;
+    uint64_t written = 0;
+    const auto seconds = Seconds([&] {
+        AsyncLog log{config, os};
+        io_cpu = LogRequests(log);
+        // время включает вывод оставшихся записей
+        log.Flush();
+        const auto stats = log.GetStats();
+        written = stats.written;
+        CHECK(stats.written + stats.dropped + stats.sampled == RECORDS);
+    });
+    Report(name, seconds, io_cpu, written);
+}
+}  // namespace
+
+TEST_CASE("Request logging: Boost.Log vs asynchronous ring buffer", "[.][benchmark]") {
+    std::ofstream null_stream{"/dev/null"};
+    InitBoostLogFilter(null_stream);
+
+    double io_cpu = 0;
+    const auto sync_seconds = Seconds([&] {
+        io_cpu = LogRequests(LOGSRV());
+    });
+    Report("Boost.Log + json::object", sync_seconds, io_cpu, RECORDS);
+
+    AsyncLogConfig config;
+    BenchAsync("ring buffer, 4096 records, drop", config, null_stream);
+    config.buffer_records = 1 << 16;
+    BenchAsync("ring buffer, 65536 records, drop", config, null_stream);
+    config.buffer_records = 4096;
+    config.overflow = Overflow::Sample;
+    config.sample_rate = 16;
+    BenchAsync("ring buffer, 4096 records, sample", config, null_stream);
+
+    AsyncLog log{AsyncLogConfig{}, null_stream};
+    BENCHMARK("AsyncLog::Response, one thread") {
+        log.Response(3, 200, "application/json"sv);
+    };
+}
@@ -0,0 +1,67 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../src/metrics.h"
+
+using namespace metrics;
+using namespace std::literals;
+
+namespace {
+constexpr int THREADS = 4;
+constexpr int UPDATES_PER_THREAD = 1'000'000;
+
+// Счётчики без шардов: все потоки пишут в одни ячейки
+struct Shared {
+    std::array<std::atomic<uint64_t>, 16> cells{};
+    void Observe(uint64_t value) {
+        size_t interval = 0;
+        while (interval < 13 && value > (100u << interval))
+            ++interval;
+        cells[interval].fetch_add(1, std::memory_order_relaxed);
+        cells[15].fetch_add(value, std::memory_order_relaxed);
+    }
+};
+
+template <typename Fn>
+double NsPerUpdate(Fn&& fn) {
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&fn] {
+            for (int i = 0; i < UPDATES_PER_THREAD; ++i)
+                fn(i);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    const std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+    return time.count() / UPDATES_PER_THREAD;
+}
+}  // namespace
+
+TEST_CASE("Metrics: sharded counters vs shared atomics", "[.][benchmark]") {
+    auto registry = std::make_unique<Registry>();
+    auto shared = std::make_unique<Shared>();
+
+    const auto sharded_ns = NsPerUpdate([&](int i) {
+        registry->ObserveRequest(defs::TypeRequest::State, 200, std::chrono::microseconds{i & 1023});
+    });
+    const auto shared_ns = NsPerUpdate([&](int i) {
+        shared->Observe(static_cast<uint64_t>(i & 1023));
+    });
+    std::cout << THREADS << " threads, ns per histogram update: sharded " << sharded_ns
+        << ", shared atomics " << shared_ns << '\n';
+    CHECK(registry->Format().find("game_server_request_duration_seconds_count{endpoint=\"state\",code=\"200\"} 4000000")
+        != std::string::npos);
+
+    BENCHMARK("ObserveRequest, one thread") {
+        registry->ObserveRequest(defs::TypeRequest::Join, 200, 700us);
+    };
+    BENCHMARK("Format") {
+        return registry->Format().size();
+    };
+}
@@ -0,0 +1,45 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <thread>
+
+#include "../src/db/retired_players_writer.h"
+
+using namespace app;
+using namespace std::literals;
+
+namespace {
+// Postgres с задержкой на транзакцию и на строку, без сети
+class SlowRepository : public RetiredPlayerRepository {
+public:
+    static constexpr auto TRANSACTION_TIME = 50us;
+    static constexpr auto ROW_TIME = 1us;
+
+    void Save(const RetiredPlayer&) override {
+        std::this_thread::sleep_for(TRANSACTION_TIME + ROW_TIME);
+    }
+    void Save(const RetiredPlayers& retired_players) override {
+        std::this_thread::sleep_for(TRANSACTION_TIME + ROW_TIME * retired_players.size());
+    }
+    RetiredPlayers Get(unsigned, unsigned) override {
+        return {};
+    }
+};
+}  // namespace
+
+// Этап удаления игроков в тике, когда за тик уходит 1000 игроков
+TEST_CASE("Retirement burst of 1000 players", "[.][benchmark]") {
+    RetiredPlayers burst;
+    for (int i = 0; i < 1000; ++i)
+        burst.emplace_back(PlayerId::New(), "dog"s + std::to_string(i), i, 60s);
+    SlowRepository repository;
+
+    BENCHMARK("synchronous insert per player") {
+        for (const auto& retired_player : burst)
+            repository.Save(retired_player);
+    };
+    RetiredPlayersWriter writer{repository};
+    BENCHMARK("write-behind queue") {
+        writer.Push(burst);
+    };
+    writer.Flush(60s);
+}
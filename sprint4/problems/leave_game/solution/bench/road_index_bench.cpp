@@ -0,0 +1,92 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+
+#include "../src/model/model.h"
+
+using namespace model;
+
+namespace {
+constexpr Coord MAP_SIZE = 10000;
+constexpr Coord ROAD_STEP = 100;
+constexpr size_t QUERIES = 1000;
+
+// Прежняя схема: по записи на каждую целочисленную клетку каждой дороги
+struct PointHash {
+    size_t operator()(const Point& p) const {
+        return std::hash<Coord>()(p.x) ^ (std::hash<Coord>()(p.y) << 1);
+    }
+};
+struct PointEqual {
+    bool operator()(const Point& l, const Point& r) const {
+        return l.x == r.x && l.y == r.y;
+    }
+};
+using CellRoadMap = std::unordered_multimap<Point, const Road*, PointHash, PointEqual>;
+
+CellRoadMap BuildCellRoadMap(const Map::Roads& roads) {
+    CellRoadMap road_map;
+    for (const auto& road : roads) {
+        auto start = road.GetStart();
+        auto end = road.GetEnd();
+        if (road.IsHorizontal()) {
+            for (auto x = std::min(start.x, end.x); x <= std::max(start.x, end.x); ++x)
+                road_map.emplace(Point{x, start.y}, &road);
+        } else {
+            for (auto y = std::min(start.y, end.y); y <= std::max(start.y, end.y); ++y)
+                road_map.emplace(Point{start.x, y}, &road);
+        }
+    }
+    return road_map;
+}
+
+// Узел списка: значение, указатель на следующий узел и сохранённый хеш
+size_t CellRoadMapMemory(const CellRoadMap& road_map) {
+    return road_map.size() * (sizeof(CellRoadMap::value_type) + 2 * sizeof(void*))
+        + road_map.bucket_count() * sizeof(void*);
+}
+}  // namespace
+
+TEST_CASE("Road index on a 10000x10000 map", "[.][benchmark]") {
+    Map::Roads roads;
+    for (Coord c = 0; c <= MAP_SIZE; c += ROAD_STEP) {
+        roads.emplace_back(Road::HORIZONTAL, Point{0, c}, MAP_SIZE, 0.4);
+        roads.emplace_back(Road::VERTICAL, Point{c, 0}, MAP_SIZE, 0.4);
+    }
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<Coord> along{0, MAP_SIZE};
+    std::uniform_int_distribution<Coord> line{0, MAP_SIZE / ROAD_STEP};
+    std::vector<Point> cells;
+    for (size_t i = 0; i < QUERIES; ++i) {
+        if (i % 2 == 0)
+            cells.push_back(Point{along(gen), line(gen) * ROAD_STEP});
+        else
+            cells.push_back(Point{line(gen) * ROAD_STEP, along(gen)});
+    }
+
+    const RoadIndex index{roads, 0.4};
+    const CellRoadMap road_map = BuildCellRoadMap(roads);
+    std::cout << roads.size() << " roads, " << road_map.size() << " road cells\n"
+        << "road index memory:   " << index.MemoryUsage() << " bytes\n"
+        << "cell multimap memory: ~" << CellRoadMapMemory(road_map) << " bytes\n";
+
+    BENCHMARK("build road index") {
+        return RoadIndex{roads, 0.4};
+    };
+    BENCHMARK("road index: 1000 lookups") {
+        size_t found = 0;
+        for (auto cell : cells)
+            found += index.RoadsAt(cell).size();
+        return found;
+    };
+    BENCHMARK("cell multimap: 1000 lookups") {
+        size_t found = 0;
+        for (auto cell : cells) {
+            auto [first, last] = road_map.equal_range(cell);
+            found += static_cast<size_t>(std::distance(first, last));
+        }
+        return found;
+    };
+}
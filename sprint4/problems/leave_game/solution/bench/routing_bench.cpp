@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/request_handler/uri_api.h"
+
+using namespace uri_api;
+using namespace std::literals;
+
+// Счётчик выделений памяти: маршрутизация не должна выделять память
+namespace {
+size_t allocations = 0;
+}  // namespace
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc{};
+}
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+// Обработчики без работы: измеряется только маршрутизация
+struct Owner {
+    size_t calls = 0;
+    StringResponse Body(std::string_view body) {
+        calls += body.size() + 1;
+        return StringResponse{};
+    }
+};
+
+using BenchRoutes = Router<Owner,
+    Route<Endpoint::JOIN_GAME, TypeRequest::Join, Match::Exact, PostOnly, NoAuthorization, BodyArg, &Owner::Body>,
+    Route<Endpoint::PLAYERS_LIST, TypeRequest::Players, Match::Exact, GetHead, NoAuthorization, BodyArg, &Owner::Body>,
+    Route<Endpoint::MAPS, TypeRequest::Maps, Match::Prefix, GetHead, NoAuthorization, PathArg, &Owner::Body>,
+    Route<Endpoint::GAME_STATE, TypeRequest::State, Match::Exact, GetHead, NoAuthorization, QueryArg, &Owner::Body>,
+    Route<Endpoint::GAME_ACTION, TypeRequest::Action, Match::Exact, PostOnly, NoAuthorization, BodyArg, &Owner::Body>,
+    Route<Endpoint::RECORDS, TypeRequest::Records, Match::Exact, GetHead, NoAuthorization, QueryArg, &Owner::Body>,
+    Route<Endpoint::GAME_TICK, TypeRequest::Tick, Match::Exact, PostOnly, NoAuthorization, BodyArg, &Owner::Body>
+>;
+
+// Прежняя схема: строка пути, unordered_map<std::string, ...> и обработчик
+// в std::function
+struct LegacyElement {
+    std::vector<http::verb> methods;
+    std::function<StringResponse(std::string_view)> process;
+};
+
+struct Case {
+    http::verb method;
+    std::string_view target;
+};
+const std::vector<Case> CASES{
+    {http::verb::post, "/api/v1/game/join"sv},
+    {http::verb::get, "/api/v1/game/players"sv},
+    {http::verb::get, "/api/v1/maps"sv},
+    {http::verb::get, "/api/v1/maps/map1"sv},
+    {http::verb::get, "/api/v1/game/state"sv},
+    {http::verb::post, "/api/v1/game/player/action"sv},
+    {http::verb::get, "/api/v1/game/records"sv},
+    {http::verb::post, "/api/v1/game/tick"sv},
+};
+}  // namespace
+
+TEST_CASE("API routing: compile-time table vs unordered_map", "[.][benchmark]") {
+    Owner owner;
+    std::vector<StringRequest> requests;
+    std::vector<RequestTarget> targets;
+    for (const auto& c : CASES) {
+        requests.emplace_back(c.method, c.target, 11);
+        targets.emplace_back(c.target);
+    }
+
+    std::unordered_map<std::string, LegacyElement> legacy;
+    for (auto path : {Endpoint::JOIN_GAME, Endpoint::PLAYERS_LIST, Endpoint::MAPS, Endpoint::GAME_STATE,
+            Endpoint::GAME_ACTION, Endpoint::RECORDS, Endpoint::GAME_TICK}) {
+        legacy.emplace(std::string(path), LegacyElement{{http::verb::get, http::verb::head, http::verb::post},
+            [&owner](std::string_view body) { return owner.Body(body); }});
+    }
+    auto legacy_dispatch = [&](const StringRequest& req, const RequestTarget& target) {
+        std::string path{target.Path()};
+        if (path.starts_with(Endpoint::MAPS))
+            path = std::string{Endpoint::MAPS};
+        auto it = legacy.find(path);
+        if (it == legacy.end())
+            return StringResponse{http::status::bad_request, 11};
+        const auto& methods = it->second.methods;
+        if (std::find(methods.begin(), methods.end(), req.method()) == methods.end())
+            return StringResponse{http::status::method_not_allowed, 11};
+        return it->second.process(req.body());
+    };
+
+    const auto count_allocations = [&](auto&& dispatch) {
+        const auto before = allocations;
+        for (size_t i = 0; i < requests.size(); ++i)
+            dispatch(requests[i], targets[i]);
+        return allocations - before;
+    };
+    const auto table_allocations = count_allocations([&](const auto& req, const auto& target) {
+        return BenchRoutes::Dispatch(owner, req, target);
+    });
+    const auto legacy_allocations = count_allocations(legacy_dispatch);
+    std::cout << "allocations per " << requests.size() << " requests: table "
+        << table_allocations << ", unordered_map " << legacy_allocations << '\n';
+    CHECK(table_allocations == 0);
+
+    BENCHMARK("compile-time table: find") {
+        size_t sum = 0;
+        for (const auto& target : targets)
+            sum += BenchRoutes::Find(target.Path());
+        return sum;
+    };
+    BENCHMARK("unordered_map: find") {
+        size_t sum = 0;
+        for (const auto& target : targets) {
+            std::string path{target.Path()};
+            if (path.starts_with(Endpoint::MAPS))
+                path = std::string{Endpoint::MAPS};
+            sum += legacy.count(path);
+        }
+        return sum;
+    };
+    BENCHMARK("compile-time table: dispatch") {
+        for (size_t i = 0; i < requests.size(); ++i)
+            BenchRoutes::Dispatch(owner, requests[i], targets[i]);
+        return owner.calls;
+    };
+    BENCHMARK("unordered_map + std::function: dispatch") {
+        for (size_t i = 0; i < requests.size(); ++i)
+            legacy_dispatch(requests[i], targets[i]);
+        return owner.calls;
+    };
+}
@@ -0,0 +1,70 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/app.h"
+#include "../src/binary_state.h"
+
+using namespace model;
+using namespace std::literals;
+
+namespace {
+Map MakeGridMap(int cells) {
+    Map map{Map::Id{"bench"s}, "bench"s, DefaultMapParam{.dog_speed = 4.0, .bag_capacity = 3}};
+    const Coord size = cells * 10;
+    for (Coord c = 0; c <= size; c += 10) {
+        map.AddRoad(Road(Road::HORIZONTAL, Point{0, c}, size, map.GetRoadOffset()));
+        map.AddRoad(Road(Road::VERTICAL, Point{c, 0}, size, map.GetRoadOffset()));
+    }
+    map.AddOffice(Office(Office::Id{"o0"s}, Point{10, 10}, Offset{0, 0}));
+    map.AddLoot(1);
+    map.AddLoot(2);
+    return map;
+}
+
+// Снимок с тем же состоянием, но без закэшированных тел ответа
+std::shared_ptr<SessionSnapshot> CopyState(const SessionSnapshot& source) {
+    auto snapshot = std::make_shared<SessionSnapshot>();
+    snapshot->version = source.version;
+    snapshot->dogs = source.dogs;
+    snapshot->loots = source.loots;
+    return snapshot;
+}
+}  // namespace
+
+TEST_CASE("Game state encoding: JSON vs binary, 10k dogs", "[.][benchmark]") {
+    constexpr int DOGS = 10000;
+    const Map map = MakeGridMap(20);
+    GameSession session{std::make_shared<const MapIndex>(map), true,
+        LootGeneratorConfig{.period = 1s, .probability = 0.9}};
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> move{0, 3};
+    for (int i = 0; i < DOGS; ++i)
+        session.MoveDog(session.AddDog("dog"s + std::to_string(i)), static_cast<Move>(move(gen)));
+    for (int i = 0; i < 20; ++i)
+        session.Tick(500ms);
+    const auto source = session.GetSnapshot();
+
+    const auto json_size = app::App::GetStateBody(*CopyState(*source)).size();
+    const auto binary_size = app::BinaryState::Encode(*source).size();
+    std::cout << source->dogs.size() << " dogs, " << source->loots.size() << " lost objects\n"
+        << "json:   " << json_size << " bytes, " << json_size / source->dogs.size() << " bytes/dog\n"
+        << "binary: " << binary_size << " bytes, " << binary_size / source->dogs.size() << " bytes/dog\n"
+        << "ns/dog = mean / " << source->dogs.size() << '\n';
+
+    BENCHMARK_ADVANCED("json")(Catch::Benchmark::Chronometer meter) {
+        std::vector<std::shared_ptr<SessionSnapshot>> snapshots;
+        for (int i = 0; i < meter.runs(); ++i)
+            snapshots.push_back(CopyState(*source));
+        meter.measure([&snapshots](int i) {
+            return app::App::GetStateBody(*snapshots[i]).size();
+        });
+    };
+    BENCHMARK("binary") {
+        return app::BinaryState::Encode(*source).size();
+    };
+}
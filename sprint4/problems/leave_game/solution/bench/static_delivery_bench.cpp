@@ -0,0 +1,127 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "../src/file_range_body.h"
+
+using namespace http_server;
+namespace fs = std::filesystem;
+
+namespace {
+constexpr uint64_t FILE_SIZE = 64 * 1024 * 1024;
+
+struct TempFile {
+    fs::path path = fs::temp_directory_path() / ("static_delivery_" + std::to_string(::getpid()));
+    TempFile() {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        std::vector<char> chunk(1024 * 1024);
+        for (size_t i = 0; i < chunk.size(); ++i)
+            chunk[i] = static_cast<char>(i * 31);
+        for (uint64_t written = 0; written < FILE_SIZE; written += chunk.size())
+            out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+    ~TempFile() {
+        fs::remove(path);
+    }
+};
+
+// Соединение через loopback: отдельный поток вычитывает всё, что пишет сервер
+struct Loopback {
+    net::io_context ioc;
+    tcp::socket server{ioc};
+    tcp::socket client{ioc};
+    std::thread reader;
+
+    Loopback() {
+        tcp::acceptor acceptor{ioc, tcp::endpoint{net::ip::address_v4::loopback(), 0}};
+        client.connect(acceptor.local_endpoint());
+        acceptor.accept(server);
+        reader = std::thread([this] {
+            std::vector<char> buffer(256 * 1024);
+            sys::error_code ec;
+            while (!ec)
+                client.read_some(net::buffer(buffer), ec);
+        });
+    }
+    ~Loopback() {
+        server.shutdown(tcp::socket::shutdown_send);
+        reader.join();
+    }
+    void Run() {
+        ioc.restart();
+        ioc.run();
+    }
+};
+
+void ServeFileBody(Loopback& loopback, const fs::path& path) {
+    http::response<http::file_body> res{http::status::ok, 11};
+    sys::error_code ec;
+    res.body().open(path.c_str(), beast::file_mode::scan, ec);
+    REQUIRE_FALSE(ec);
+    res.prepare_payload();
+    http::async_write(loopback.server, res, [](beast::error_code ec, std::size_t) {
+        REQUIRE_FALSE(ec);
+    });
+    loopback.Run();
+}
+
+void ServeSendFile(Loopback& loopback, const fs::path& path) {
+    http::response<FileRangeBody> res{http::status::ok, 11};
+    sys::error_code ec;
+    res.body().file.open(path.c_str(), beast::file_mode::scan, ec);
+    REQUIRE_FALSE(ec);
+    res.body().size = FILE_SIZE;
+    res.content_length(FILE_SIZE);
+    http::response_serializer<FileRangeBody> serializer{res};
+    http::async_write_header(loopback.server, serializer, [&](beast::error_code ec, std::size_t) {
+        REQUIRE_FALSE(ec);
+        AsyncSendFile(loopback.server, res.body().file.native_handle(), 0, FILE_SIZE,
+            [](beast::error_code ec, uint64_t sent) {
+                REQUIRE_FALSE(ec);
+                REQUIRE(sent == FILE_SIZE);
+            });
+    });
+    loopback.Run();
+}
+
+// Процессорное время потока, отправляющего файл (user + system)
+double ThreadCpuSeconds() {
+    rusage usage{};
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+template <typename Serve>
+void ReportCpuPerGb(std::string_view name, Loopback& loopback, const fs::path& path, Serve serve) {
+    constexpr int TRANSFERS = 16;
+    const auto start_cpu = ThreadCpuSeconds();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TRANSFERS; ++i)
+        serve(loopback, path);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double gb = static_cast<double>(FILE_SIZE) * TRANSFERS / (1024.0 * 1024 * 1024);
+    std::cout << name << ": " << gb / seconds << " GB/s, "
+        << (ThreadCpuSeconds() - start_cpu) / gb << " CPU s/GB\n";
+}
+}  // namespace
+
+TEST_CASE("Static delivery: file_body vs sendfile, 64 MiB file", "[.][benchmark]") {
+    TempFile file;
+    Loopback loopback;
+    ReportCpuPerGb("file_body", loopback, file.path, ServeFileBody);
+    ReportCpuPerGb("sendfile ", loopback, file.path, ServeSendFile);
+
+    BENCHMARK("file_body") {
+        ServeFileBody(loopback, file.path);
+    };
+    BENCHMARK("sendfile") {
+        ServeSendFile(loopback, file.path);
+    };
+}
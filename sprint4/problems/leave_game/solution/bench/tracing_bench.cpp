@@ -0,0 +1,39 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include "../src/util/trace.h"
+
+using namespace util;
+using namespace std::literals;
+
+namespace {
+// Работа внутри интервала - немного арифметики, чтобы цикл не свернулся
+uint64_t Work(uint64_t value) {
+    for (int i = 0; i < 16; ++i)
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    return value;
+}
+}  // namespace
+
+TEST_CASE("Trace spans: disabled and enabled overhead", "[.][benchmark]") {
+    auto& tracer = TRACER();
+    tracer.Disable();
+    uint64_t value = 1;
+
+    BENCHMARK("no span") {
+        return value = Work(value);
+    };
+    BENCHMARK("disabled span") {
+        TraceSpan span{"handler"sv, "http"sv};
+        return value = Work(value);
+    };
+    tracer.Enable();
+    BENCHMARK("enabled span") {
+        TraceSpan span{"handler"sv, "http"sv};
+        return value = Work(value);
+    };
+    BENCHMARK("Dump, 64K events") {
+        return tracer.Dump().size();
+    };
+    tracer.Disable();
+}
@@ -1,5 +1,9 @@
 #include "app.h"
+#include <algorithm>
 #include <boost/format.hpp>
+#include "binary_state.h"
+#include "util/gzip.h"
+#include "util/trace.h"
 #include "log.h"
 #include "request_handler/defs.h"
 
@@ -30,17 +34,14 @@ std::string ModelToJson::GetMaps() const {
     return serialize(obj);
 }
 
-std::string ModelToJson::GetMap(std::string_view nameMap) const {
-    model::Map::Id idmap{nameMap.data()};
+std::string ModelToJson::GetMap(const model::Map& map) const {
     js::object mapEl;
-    if (auto map = game_.FindMap({ idmap }); map != nullptr) {
-        mapEl["id"] = *map->GetId();
-        mapEl["name"] = map->GetName();
-        mapEl["roads"] = GetRoads(map->GetRoads());
-        mapEl["buildings"] = GetBuildings(map->GetBuildings());
-        mapEl["offices"]   = GetOffice(map->GetOffices());
-        mapEl["lootTypes"] = ToJsonValue(game_.GetLootTypes(map->GetId()));
-    }
+    mapEl["id"] = *map.GetId();
+    mapEl["name"] = map.GetName();
+    mapEl["roads"] = GetRoads(map.GetRoads());
+    mapEl["buildings"] = GetBuildings(map.GetBuildings());
+    mapEl["offices"]   = GetOffice(map.GetOffices());
+    mapEl["lootTypes"] = ToJsonValue(game_.GetLootTypes(map.GetId()));
     return serialize(mapEl);
 }
 
@@ -98,6 +99,32 @@ js::value ModelToJson::ToJsonValue(std::string_view json_body)
     return jv;
 }
 
+namespace {
+std::string MakeETag(std::string_view body, std::string_view suffix) {
+    return (boost::format("\"%08x-%x%s\"") % util::Crc32(body) % body.size() % suffix).str();
+}
+}  // namespace
+
+PrecomputedBody::PrecomputedBody(std::string text)
+    : body(std::move(text))
+    , gzip(util::GzipCompress(body))
+    , etag(MakeETag(body, ""sv))
+    , gzip_etag(MakeETag(body, "-gzip"sv)) {
+}
+
+MapBodies::MapBodies(const model::Game& game) {
+    ModelToJson jmodel(game);
+    maps_ = std::make_shared<const PrecomputedBody>(jmodel.GetMaps());
+    for (const auto& map : game.GetMaps())
+        map_.emplace(*map.GetId(), std::make_shared<const PrecomputedBody>(jmodel.GetMap(map)));
+}
+
+std::shared_ptr<const PrecomputedBody> MapBodies::GetMap(std::string_view id) const {
+    if (auto it = map_.find(id); it != map_.end())
+        return it->second;
+    return nullptr;
+}
+
 model::Game& App::GetGameModel() {
     return game_;
 }
@@ -114,27 +141,45 @@ PlayerTokens& App::EditPlayerTokens() {
     return player_tokens_;
 }
 
-void App::RetirPlayers(milliseconds delta) {
-    auto players = players_.GetPlayers();
-    std::vector<PlayerId> to_delete;
-    for (auto it = players.begin(); it != players.end(); ++it) {
-        auto player = *it->second;
-        auto dog = *player.GetDog();
-        if (dog.GetStayTime() >= game_.GetDogRetirementTime()) {
-            RetiredPlayer retired_player{player.GetId(), dog.GetName(), 
-                dog.GetScore(), dog.GetLifetime() };
-            db_.GetRetiredPlayers().Save(retired_player);
-            to_delete.push_back(player.GetId());
-        }
+RetiredPlayers App::RetireIdleDogs(model::GameSession& session) {
+    RetiredPlayers retired_players;
+    for (const auto& dog_id : session.TakeIdleDogs(game_.GetDogRetirementTime())) {
+        auto player = players_.FindPlayerByDog(&session, dog_id);
+        if (!player)
+            continue;
+        auto dog = session.FindDog(dog_id);
+        retired_players.emplace_back(player->GetId(), dog->GetName(),
+            dog->GetScore(), dog->GetLifetime());
+        session.DeleteDog(dog_id);
     }
-    for (auto& id : to_delete) {
-        for (auto& session : game_.GetGameSessions()) {
-            auto dog_id = players_.FindPlayer(id)->GetDog()->GetId();
-            session.DeleteDog(dog_id);
-        }
-        player_tokens_.DeleteToken(id);
-        players_.DeletePlayer(id);
+    return retired_players;
+}
+
+void App::CompleteRetirement(const RetiredPlayers& retired_players) {
+    for (const auto& retired_player : retired_players) {
+        // токен удаляется раньше игрока: PlayerTokens::Resolve полагается на этот порядок
+        player_tokens_.DeleteToken(retired_player.GetId());
+        players_.DeletePlayer(retired_player.GetId());
     }
+    // запись в базу - в потоке базы, тик её не ждёт
+    db_.GetRetiredPlayersWriter().Push(retired_players);
+}
+
+bool App::FlushRetiredPlayers(milliseconds timeout) {
+    return db_.GetRetiredPlayersWriter().Flush(timeout);
+}
+
+RetiredPlayers App::GetPendingRetiredPlayers() const {
+    return db_.GetRetiredPlayersWriter().GetPending();
+}
+
+void App::RestoreRetiredPlayers(RetiredPlayers retired_players) {
+    // уже записанные до остановки игроки база пропускает (ON CONFLICT)
+    db_.GetRetiredPlayersWriter().Push(std::move(retired_players));
+}
+
+std::optional<PlayerRef> App::ResolveToken(const Token& token) const {
+    return player_tokens_.Resolve(token);
 }
 
 const PlayerTokens& App::GetPlayerTokens() const {
@@ -143,47 +188,52 @@ const PlayerTokens& App::GetPlayerTokens() const {
 
 std::pair<std::string, bool>
 App::GetMapBodyJson(std::string_view mapName) const {
-    ModelToJson jmodel(game_);
-    std::string body;
-    if (mapName.empty()) {
-        body = jmodel.GetMaps();
-    }
-    else {
-        // if map not found
-        body = jmodel.GetMap(mapName);
-        if (body.size() == 2) { 
-            // if body is "" (empty)
-            return std::make_pair(JsonMessage(ErrorCode::MAP_NOT_FOUND, 
-                ErrorMessage::MAP_NOT_FOUND), false);
-        }
-    }
-    return std::make_pair(std::move(body), true);
+    auto body = mapName.empty() ? map_bodies_.GetMaps() : map_bodies_.GetMap(mapName);
+    if (!body)
+        return std::make_pair(JsonMessage(ErrorCode::MAP_NOT_FOUND, 
+            ErrorMessage::MAP_NOT_FOUND), false);
+    return std::make_pair(body->body, true);
 }
 //
-std::pair<std::string, JoinError>
-App::ResponseJoin(std::string_view jsonBody) {
-    auto parseError = std::make_pair(
-        JsonMessage(ErrorCode::INVALID_ARGUMENT, ErrorMessage::JOIN_GAME_PARSE),
-        JoinError::BadJson
-    );
+std::optional<std::pair<std::string, std::string>>
+App::ParseJoin(std::string_view jsonBody) const {
     js::error_code ec;
     js::string_view jb{jsonBody.data(), jsonBody.size()};
-    std::string resp;
-    std::string userName;
-    std::string mapId;
     js::value const jv = js::parse(jb, ec);
     if (ec)
-        return parseError;
+        return std::nullopt;
     try {
-        userName = jv.at("userName").as_string();
-        mapId = jv.at("mapId").as_string();
+        return std::make_pair(std::string(jv.at("userName").as_string()),
+            std::string(jv.at("mapId").as_string()));
     }
     catch (const std::system_error&) {
-        return parseError;
+        return std::nullopt;
     }
     catch (const std::out_of_range&) {
-        return parseError;
+        return std::nullopt;
     }
+}
+
+model::GameSession* App::JoinTargetSession(std::string_view jsonBody) {
+    auto join = ParseJoin(jsonBody);
+    if (!join || join->first.empty())
+        return nullptr;
+    model::Map::Id map_id{join->second};
+    if (game_.FindMap(map_id) == nullptr)
+        return nullptr;
+    return game_.FindOrAddGameSession(map_id);
+}
+
+std::pair<std::string, JoinError>
+App::ResponseJoin(std::string_view jsonBody) {
+    auto parseError = std::make_pair(
+        JsonMessage(ErrorCode::INVALID_ARGUMENT, ErrorMessage::JOIN_GAME_PARSE),
+        JoinError::BadJson
+    );
+    auto join = ParseJoin(jsonBody);
+    if (!join)
+        return parseError;
+    const auto& [userName, mapId] = *join;
     if (userName.empty())
         return std::make_pair(
             JsonMessage(ErrorCode::INVALID_ARGUMENT, ErrorMessage::INVALID_NAME),
@@ -199,7 +249,7 @@ App::ResponseJoin(std::string_view jsonBody) {
     js::object msg;
     auto player = GetPlayer(userName, mapId);
     std::string token = *player_tokens_.AddPlayer(player);
-    auto id = *player->GetDog()->GetId();
+    auto id = *player->GetDogId();
     msg["authToken"] = token;
     msg["playerId"]  = id;
     return std::make_pair(
@@ -221,8 +271,13 @@ App::ActionMove(const Token& token, std::string_view jsonBody) {
             error_code::InvalidArgument
         );
     }    
-    Player* player = player_tokens_.FindPlayer(token);
-    player->Move(move);
+    auto player = player_tokens_.Resolve(token);
+    if (!player)
+        return std::make_pair(
+            JsonMessage(ErrorCode::UNKNOWN_TOKEN, ErrorMessage::UNKNOWN_TOKEN),
+            error_code::UnknownToken
+        );
+    player->session->PushMove(player->dog_id, MoveFromString(move));
     js::object msg;
     return std::make_pair(
         std::move(serialize(msg)),
@@ -230,9 +285,7 @@ App::ActionMove(const Token& token, std::string_view jsonBody) {
     );
 }
 
-std::pair<std::string, error_code> 
-App::Tick(std::string_view jsonBody) {
-    milliseconds time_delta_mc;
+std::optional<milliseconds> App::ParseTickDelta(std::string_view jsonBody) const {
     try {
         auto jv = js::parse(to_booststr(jsonBody));
         auto jv_time_delta = jv.at("timeDelta");
@@ -246,43 +299,53 @@ App::Tick(std::string_view jsonBody) {
         }
         if (mc == 0)
             throw std::out_of_range{ThrowMessage::TIME_NOT_ZERO};
-        time_delta_mc = milliseconds(mc);
+        return milliseconds(mc);
     }
     catch (...) {
-        return std::make_pair(
-            JsonMessage(ErrorCode::INVALID_ARGUMENT, 
-                ErrorMessage::FAIL_PARSE_TICK_JSON),
-            error_code::InvalidArgument
-        );
-    }    
-    game_.Tick(time_delta_mc);
-    js::object msg;
+        return std::nullopt;
+    }
+}
+
+std::pair<std::string, error_code> 
+App::Tick([[maybe_unused]] std::string_view jsonBody) {
+    // тик вне strand'ов сессий недопустим, корректный запрос сюда не доходит
     return std::make_pair(
-        std::move(serialize(msg)),
-        error_code::None        
+        JsonMessage(ErrorCode::INVALID_ARGUMENT, 
+            ErrorMessage::FAIL_PARSE_TICK_JSON),
+        error_code::InvalidArgument
     );
 }
 
 std::pair<std::string, error_code> 
 App::GetPlayers(const Token& token) const {
-    js::object msg;
-    Player* player = player_tokens_.FindPlayer(token);
-    auto session = player->GetSession();
-    const auto &dogs = session->GetDogs();
-    for (const auto& [dog_id, dog] : dogs) {
-        js::object jname;
-        jname["name"] = to_booststr(dog.GetName());
-        msg[std::to_string(*dog.GetId())] = jname;
-    }
+    auto player = player_tokens_.Resolve(token);
+    if (!player)
+        return std::make_pair(
+            JsonMessage(ErrorCode::UNKNOWN_TOKEN, ErrorMessage::UNKNOWN_TOKEN),
+            error_code::UnknownToken
+        );
+    auto snapshot = player->session->GetSnapshot();
+    const auto& roster = *snapshot->roster;
     return std::make_pair(
-        std::move(serialize(msg)),
+        roster.body.Get([&roster] { return SerializeRoster(roster); }),
         error_code::None
     );
 }
 
-auto App::GetJsonDogBag(const model::Dog &dog) const {
+std::string App::SerializeRoster(const model::SessionSnapshot::Roster& roster) {
+    util::TraceSpan span{"serialize_roster"sv, "serialize"sv};
+    js::object msg;
+    for (const auto& [dog_id, name] : roster.dogs) {
+        js::object jname;
+        jname["name"] = to_booststr(name);
+        msg[std::to_string(*dog_id)] = jname;
+    }
+    return serialize(msg);
+}
+
+js::array App::GetJsonDogBag(const std::vector<model::Loot>& bag) {
     js::array jarr;
-    for (const auto& loot : dog.GetLoots()) {
+    for (const auto& loot : bag) {
         js::object val;
         val["id"] = *loot.id;
         val["type"] = loot.type;
@@ -293,40 +356,97 @@ auto App::GetJsonDogBag(const model::Dog &dog) const {
 
 std::pair<std::string, error_code> 
 App::GetState(const Token& token) const {
-    auto put_array = [](const auto &x, const auto &y) {
-        js::array jarr;
-        jarr.emplace_back(x);
-        jarr.emplace_back(y);
-        return jarr;
+    auto [snapshot, err] = GetSessionSnapshot(token);
+    if (err != error_code::None)
+        return std::make_pair(
+            JsonMessage(ErrorCode::UNKNOWN_TOKEN, ErrorMessage::UNKNOWN_TOKEN),
+            err
+        );
+    return std::make_pair(GetStateBody(*snapshot), error_code::None);
+}
+
+std::pair<std::shared_ptr<const model::SessionSnapshot>, error_code>
+App::GetSessionSnapshot(const Token& token) const {
+    auto player = player_tokens_.Resolve(token);
+    if (!player)
+        return std::make_pair(nullptr, error_code::UnknownToken);
+    return std::make_pair(player->session->GetSnapshot(), error_code::None);
+}
+
+const std::string& App::GetStateBody(const model::SessionSnapshot& snapshot) {
+    return snapshot.state_body.Get([&snapshot] { return SerializeState(snapshot); });
+}
+
+const std::string& App::GetStateBinary(const model::SessionSnapshot& snapshot) {
+    return snapshot.state_binary.Get([&snapshot] {
+        util::TraceSpan span{"encode_state"sv, "serialize"sv};
+        return BinaryState::Encode(snapshot);
+    });
+}
+
+std::string App::GetStateDelta(const model::SessionSnapshot& snapshot, uint64_t since) {
+    if (!snapshot.CoversSince(since))
+        return GetStateBody(snapshot);
+    util::TraceSpan span{"serialize_delta"sv, "serialize"sv};
+    js::object dogs;
+    for (const auto& dog : snapshot.dogs) {
+        if (dog.changed_at > since)
+            dogs[std::to_string(*dog.id)] = DogStateToJson(dog);
+    }
+    js::object loots;
+    for (const auto& loot : snapshot.loots) {
+        if (loot.added_at > since)
+            loots[std::to_string(*loot.loot.id)] = LootToJson(loot.loot);
+    }
+    // удаления упорядочены по версии, нужны только более новые, чем since
+    auto removed_after = [since](const auto& removals) {
+        js::array ids;
+        auto it = std::partition_point(removals.begin(), removals.end(),
+            [since](const auto& removal) { return removal.version <= since; });
+        for (; it != removals.end(); ++it)
+            ids.emplace_back(*it->id);
+        return ids;
     };
-    Player* player = player_tokens_.FindPlayer(token);
+    js::object delta;
+    delta["since"] = since;
+    delta["players"] = std::move(dogs);
+    delta["lostObjects"] = std::move(loots);
+    delta["removedPlayers"] = removed_after(snapshot.removed_dogs);
+    delta["removedLostObjects"] = removed_after(snapshot.removed_loots);
+    return serialize(delta);
+}
+
+js::object App::DogStateToJson(const model::SessionSnapshot::DogState& dog) {
+    js::object dog_param;
+    dog_param["pos"] = js::array{dog.pos.x, dog.pos.y};
+    dog_param["speed"] = js::array{dog.speed.x, dog.speed.y};
+    dog_param["dir"] = model::DirectionToString(dog.dir);
+    dog_param["bag"] = GetJsonDogBag(dog.bag);
+    dog_param["score"] = dog.score;
+    return dog_param;
+}
+
+js::object App::LootToJson(const model::Loot& loot) {
+    js::object object;
+    object["type"] = loot.type; 
+    object["pos"] = js::array{loot.pos.x, loot.pos.y};
+    return object;
+}
+
+std::string App::SerializeState(const model::SessionSnapshot& snapshot) {
+    util::TraceSpan span{"serialize_state"sv, "serialize"sv};
     js::object state;
-    auto session = player->GetSession();
-    const auto &dogs = session->GetDogs();
-    for (const auto &[dog_id, dog] : dogs) {
-        js::object dog_param;
-        dog_param["pos"] = put_array(dog.GetPoint().x, dog.GetPoint().y);
-        dog_param["speed"] = put_array(dog.GetSpeed().x, dog.GetSpeed().y);
-        dog_param["dir"] = dog.GetDirection();
-        dog_param["bag"] = GetJsonDogBag(dog);
-        dog_param["score"] = dog.GetScore();
-        state[std::to_string(*dog.GetId())] = dog_param;
+    for (const auto& dog : snapshot.dogs) {
+        state[std::to_string(*dog.id)] = DogStateToJson(dog);
     }
     js::object players;
     players["players"] = state;
     js::object js_loot_type;
-    const auto& loots = session->GetLoots();
-    for (const auto& loot : loots) {
-        js::object object;
-        object["type"] = loot.type; 
-        object["pos"] = put_array(loot.pos.x, loot.pos.y);
-        js_loot_type[std::to_string(*loot.id)] = object;
+    for (const auto& loot : snapshot.loots) {
+        js_loot_type[std::to_string(*loot.loot.id)] = LootToJson(loot.loot);
     }
     players["lostObjects"] = js_loot_type;
-    return std::make_pair(
-        std::move(serialize(players)),
-        error_code::None
-    );
+    return serialize(players);
 }
 
 std::pair<std::string, error_code> 
@@ -376,11 +496,9 @@ Player* App::GetPlayer(const Token& token) const {
 
 Player* App::GetPlayer(std::string_view nickName, std::string_view mapId) {
     model::Map::Id map_id{mapId.data()};
-    auto session = game_.FindGameSession(map_id);
-    if (session == nullptr)
-        session = game_.AddGameSession(map_id);
-    model::Dog* dog = session->AddDog(nickName);
-    auto player = players_.Add(app::PlayerId::New(), dog, session);
+    auto session = game_.FindOrAddGameSession(map_id);
+    auto dog_id = session->AddDog(nickName);
+    auto player = players_.Add(app::PlayerId::New(), dog_id, session);
     return player;
 }
 
@@ -4,6 +4,7 @@
 #include <boost/asio/strand.hpp>
 #include <string>
 #include <random>
+#include <unordered_map>
 #include "model/model.h"
 #include "util/token.h"
 #include "ticker.h"
@@ -41,7 +42,7 @@ public:
         : game_{ game } {
     }
     std::string GetMaps() const;
-    std::string GetMap(std::string_view nameMap) const;
+    std::string GetMap(const model::Map& map) const;
 private:
     const model::Game& game_;
     static js::array GetRoads(const model::Map::Roads& roads);
@@ -52,11 +53,42 @@ private:
 
 std::string JsonMessage(std::string_view code, std::string_view message);
 
+// Готовое тело ответа: строится один раз вместе со сжатой копией
+// и отдаётся без копирования
+struct PrecomputedBody {
+    std::string body;
+    std::string gzip;
+    // сильные ETag по содержимому, у каждого представления свой
+    std::string etag;
+    std::string gzip_etag;
+
+    explicit PrecomputedBody(std::string body);
+};
+
+// Тела ответов /maps и /maps/{id}. Карты не меняются во время работы,
+// поэтому все тела строятся при запуске, а запрос карты - поиск в хеш-таблице
+class MapBodies {
+public:
+    explicit MapBodies(const model::Game& game);
+
+    std::shared_ptr<const PrecomputedBody> GetMaps() const {
+        return maps_;
+    }
+    // nullptr - карты нет
+    std::shared_ptr<const PrecomputedBody> GetMap(std::string_view id) const;
+
+private:
+    std::shared_ptr<const PrecomputedBody> maps_;
+    // ключи ссылаются на id карт в Game, который живёт дольше App
+    std::unordered_map<std::string_view, std::shared_ptr<const PrecomputedBody>> map_;
+};
+
 class App
 {
 public:
     explicit App(model::Game& game, const AppConfig& config)
         : game_{ game }
+        , map_bodies_{ game }
         , db_{ config.capacity, config.db_url } {
     }
     model::Game& GetGameModel();
@@ -64,26 +96,69 @@ public:
     const PlayerTokens& GetPlayerTokens() const;
     Players& EditPlayers();
     PlayerTokens& EditPlayerTokens();
-    void RetirPlayers(milliseconds delta);
+    // Удаление простаивающих игроков выполняет тик координатора в два шага.
+    // Первый - для одной сессии на её strand: убирает собак, простоявших
+    // dogRetirementTime, и возвращает результаты их игроков
+    RetiredPlayers RetireIdleDogs(model::GameSession& session);
+    // Второй - в strand координатора: удаляет игроков и токены и ставит
+    // результаты в очередь записи в базу
+    void CompleteRetirement(const RetiredPlayers& retired_players);
+    // Ждёт записи в базу результатов, ушедших до вызова. false - не дождались
+    bool FlushRetiredPlayers(milliseconds timeout);
+    // Результаты, ещё не записанные в базу. Сохраняются в файле состояния:
+    // игроков в состоянии уже нет
+    RetiredPlayers GetPendingRetiredPlayers() const;
+    // Ставит в очередь записи результаты, загруженные из файла состояния
+    void RestoreRetiredPlayers(RetiredPlayers retired_players);
+    // Сессия и собака игрока по токену, потокобезопасно
+    std::optional<PlayerRef> ResolveToken(const Token& token) const;
+    // Сессия, в которую войдёт игрок по запросу join (создаётся при необходимости).
+    // nullptr - запрос некорректен, его обработка не затрагивает сессий
+    model::GameSession* JoinTargetSession(std::string_view jsonBody);
+    std::optional<milliseconds> ParseTickDelta(std::string_view jsonBody) const;
 
     std::pair<std::string, bool> GetMapBodyJson(std::string_view requestTarget) const;
+    const MapBodies& GetMapBodies() const noexcept {
+        return map_bodies_;
+    }
     std::pair<std::string, JoinError> ResponseJoin(std::string_view jsonBody);
     std::pair<std::string, error_code> ActionMove(
         const Token& token, std::string_view jsonBody);
+    // Тик по запросу выполняет Coordinator; сюда доходит только тело,
+    // которое не удалось разобрать, и ответом служит ошибка разбора
     std::pair<std::string, error_code> Tick(std::string_view jsonBody);
     std::pair<std::string, error_code> GetPlayers(const Token& token) const;
     std::pair<std::string, error_code> GetState(const Token& token) const;
+    // Снимок сессии игрока: по его версии строится ETag ответа state
+    std::pair<std::shared_ptr<const model::SessionSnapshot>, error_code>
+        GetSessionSnapshot(const Token& token) const;
+    // Полное состояние, сериализуется один раз на снимок
+    static const std::string& GetStateBody(const model::SessionSnapshot& snapshot);
+    // Полное состояние в двоичном виде, кодируется один раз на снимок
+    static const std::string& GetStateBinary(const model::SessionSnapshot& snapshot);
+    // Изменения после версии since: изменившиеся и новые собаки, появившиеся
+    // трофеи, id ушедших собак и подобранных трофеев. Если история снимка
+    // не покрывает since, возвращается полное состояние (без поля "since")
+    static std::string GetStateDelta(const model::SessionSnapshot& snapshot, uint64_t since);
     std::pair<std::string, error_code> CheckToken(const Token& token) const;
     std::pair<std::string, error_code> GetRecords(unsigned start, unsigned max_items);
 
 private:
     model::Game& game_;
+    MapBodies map_bodies_;
     Players players_;
     PlayerTokens player_tokens_;
     postgres::Database db_;
     Player* GetPlayer(const Token& token) const;
     Player* GetPlayer(std::string_view nick, std::string_view mapId);
-    auto GetJsonDogBag(const model::Dog& dog) const;
+    // Тела ответов state и players строятся по снимку сессии один раз
+    // и кэшируются в нём самом
+    static std::string SerializeState(const model::SessionSnapshot& snapshot);
+    static js::object DogStateToJson(const model::SessionSnapshot::DogState& dog);
+    static js::object LootToJson(const model::Loot& loot);
+    static std::string SerializeRoster(const model::SessionSnapshot::Roster& roster);
+    static js::array GetJsonDogBag(const std::vector<model::Loot>& bag);
+    std::optional<std::pair<std::string, std::string>> ParseJoin(std::string_view jsonBody) const;
 };
 }
 
@@ -0,0 +1,360 @@
+#include "async_log.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <iterator>
+
+namespace server_logging {
+using namespace std::literals;
+using namespace std::chrono;
+
+namespace {
+std::atomic<uint64_t> next_log_id{1};
+
+// Экранирование строки так же, как это делает boost::json::serialize
+void AppendJsonString(std::string& out, std::string_view str) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    out += '"';
+    for (char c : str) {
+        switch (c) {
+        case '"': out += "\\\""sv; break;
+        case '\\': out += "\\\\"sv; break;
+        case '\b': out += "\\b"sv; break;
+        case '\f': out += "\\f"sv; break;
+        case '\n': out += "\\n"sv; break;
+        case '\r': out += "\\r"sv; break;
+        case '\t': out += "\\t"sv; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00"sv;
+                out += HEX[(c >> 4) & 0xf];
+                out += HEX[c & 0xf];
+            } else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+void AppendNumber(std::string& out, long long value) {
+    char buffer[24];
+    const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void AppendRequestData(std::string& out, std::string_view address,
+        std::string_view uri, http::verb method) {
+    const auto method_str = http::to_string(method);
+    out += "{\"address\":"sv;
+    AppendJsonString(out, address);
+    out += ",\"URI\":"sv;
+    AppendJsonString(out, uri);
+    out += ",\"method\":"sv;
+    AppendJsonString(out, std::string_view(method_str.data(), method_str.size()));
+    out += '}';
+}
+
+void AppendResponseData(std::string& out, long long response_time, unsigned status,
+        std::string_view content_type) {
+    out += "{\"response_time\":"sv;
+    AppendNumber(out, response_time);
+    out += ",\"code\":"sv;
+    AppendNumber(out, status);
+    out += ",\"content_type\":"sv;
+    AppendJsonString(out, content_type.empty()
+        ? "null"sv : content_type.substr(0, content_type.find("\\r")));
+    out += '}';
+}
+}  // namespace
+
+// Кольцевой буфер одного потока: пишет только поток-владелец, читает
+// только поток журнала. Индексы растут неограниченно, ячейка - индекс & mask_
+class AsyncLog::Ring {
+public:
+    explicit Ring(size_t capacity)
+        : slots_(capacity)
+        , mask_(capacity - 1) {
+    }
+
+    size_t Capacity() const {
+        return slots_.size();
+    }
+    size_t Used() const {
+        return head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire);
+    }
+    LogRecord& Slot() {
+        return slots_[head_.load(std::memory_order_relaxed) & mask_];
+    }
+    void Commit() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    template <typename Fn>
+    void Consume(Fn&& fn) {
+        const auto head = head_.load(std::memory_order_acquire);
+        auto tail = tail_.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail)
+            fn(slots_[tail & mask_]);
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    // счётчики пишет только владелец, поэтому без fetch_add
+    void CountDropped() {
+        dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    void CountSampled() {
+        sampled.store(sampled.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> sampled{0};
+    uint64_t sample_counter = 0;
+
+private:
+    std::vector<LogRecord> slots_;
+    const size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+AsyncLog::AsyncLog(const AsyncLogConfig& config, std::ostream& os)
+    : config_(config)
+    , capacity_(std::bit_ceil(std::max<size_t>(config.buffer_records, 2)))
+    , id_(next_log_id.fetch_add(1, std::memory_order_relaxed))
+    , os_(os)
+    , thread_([this] { Run(); }) {
+}
+
+AsyncLog::~AsyncLog() {
+    {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+AsyncLog::Ring& AsyncLog::LocalRing() {
+    struct Cache {
+        uint64_t owner = 0;
+        Ring* ring = nullptr;
+    };
+    thread_local Cache cache;
+    if (cache.owner != id_) {
+        auto ring = std::make_shared<Ring>(capacity_);
+        std::lock_guard lock{rings_mutex_};
+        rings_.push_back(ring);
+        cache = {id_, ring.get()};
+    }
+    return *cache.ring;
+}
+
+LogRecord* AsyncLog::Reserve(Ring& ring) {
+    const auto used = ring.Used();
+    if (used >= ring.Capacity()) {
+        ring.CountDropped();
+        return nullptr;
+    }
+    if (config_.overflow == Overflow::Sample && used >= ring.Capacity() - ring.Capacity() / 4
+            && ++ring.sample_counter % std::max(config_.sample_rate, 1u) != 0) {
+        ring.CountSampled();
+        return nullptr;
+    }
+    return &ring.Slot();
+}
+
+void AsyncLog::Commit(Ring& ring) {
+    ring.Commit();
+    // поток журнала будится раньше срока, когда буфер заполнен наполовину
+    if (config_.wake_on_half_full && ring.Used() == ring.Capacity() / 2) {
+        half_full_.store(true, std::memory_order_relaxed);
+        wake_.notify_one();
+    }
+}
+
+void AsyncLog::Request(const net::ip::address& address, std::string_view uri, http::verb method) {
+    if (uri.size() > LogRecord::TEXT_CAPACITY) {
+        std::string data;
+        AppendRequestData(data, address.to_string(), uri, method);
+        return Line(std::move(data), "request received"sv);
+    }
+    auto& ring = LocalRing();
+    auto* record = Reserve(ring);
+    if (!record)
+        return;
+    record->kind = LogRecord::Kind::Request;
+    record->time = system_clock::now();
+    record->address = address;
+    record->method = method;
+    record->text_size = static_cast<uint16_t>(uri.size());
+    std::memcpy(record->text.data(), uri.data(), uri.size());
+    Commit(ring);
+}
+
+void AsyncLog::Response(long long response_time, unsigned status_code, std::string_view content_type) {
+    if (content_type.size() > LogRecord::TEXT_CAPACITY) {
+        std::string data;
+        AppendResponseData(data, response_time, status_code, content_type);
+        return Line(std::move(data), "response sent"sv);
+    }
+    auto& ring = LocalRing();
+    auto* record = Reserve(ring);
+    if (!record)
+        return;
+    record->kind = LogRecord::Kind::Response;
+    record->time = system_clock::now();
+    record->response_time = response_time;
+    record->status = status_code;
+    record->text_size = static_cast<uint16_t>(content_type.size());
+    std::memcpy(record->text.data(), content_type.data(), content_type.size());
+    Commit(ring);
+}
+
+void AsyncLog::Line(std::string data, std::string_view message) {
+    {
+        std::lock_guard lock{mutex_};
+        lines_.push_back({system_clock::now(), std::move(data), std::string(message)});
+    }
+    wake_.notify_one();
+}
+
+void AsyncLog::Flush() {
+    std::unique_lock lock{mutex_};
+    // проход, начавшийся до вызова, мог не увидеть последних записей:
+    // ждём следующий
+    const auto target = started_passes_ + 1;
+    flush_requested_ = true;
+    wake_.notify_one();
+    drained_cv_.wait(lock, [&] {
+        return passes_ >= target;
+    });
+}
+
+AsyncLog::Stats AsyncLog::GetStats() const {
+    Stats stats;
+    stats.written = written_.load(std::memory_order_relaxed);
+    std::lock_guard lock{rings_mutex_};
+    for (const auto& ring : rings_) {
+        stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+        stats.sampled += ring->sampled.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void AsyncLog::Run() {
+    std::vector<PendingLine> lines;
+    std::unique_lock lock{mutex_};
+    while (true) {
+        wake_.wait_for(lock, config_.flush_period, [this] {
+            return stop_ || flush_requested_ || half_full_.load(std::memory_order_relaxed);
+        });
+        half_full_.store(false, std::memory_order_relaxed);
+        const bool stop = stop_;
+        const auto pass = ++started_passes_;
+        flush_requested_ = false;
+        lines.swap(lines_);
+        lock.unlock();
+
+        Drain(lines);
+        lines.clear();
+
+        lock.lock();
+        passes_ = pass;
+        drained_cv_.notify_all();
+        if (stop)
+            return;
+    }
+}
+
+void AsyncLog::Drain(std::vector<PendingLine>& lines) {
+    {
+        std::lock_guard lock{rings_mutex_};
+        if (drain_rings_.size() != rings_.size())
+            drain_rings_ = rings_;
+    }
+    uint64_t written = 0;
+    for (auto& line : lines) {
+        BeginLine(line.time);
+        batch_ += line.data;
+        EndLine(line.message);
+        ++written;
+    }
+    Stats lost;
+    for (auto& ring : drain_rings_) {
+        ring->Consume([&](const LogRecord& record) {
+            FormatRecord(record);
+            ++written;
+        });
+        lost.dropped += ring->dropped.load(std::memory_order_relaxed);
+        lost.sampled += ring->sampled.load(std::memory_order_relaxed);
+    }
+    // потерянные с прошлого прохода записи отмечаются в самом журнале
+    if (lost.dropped != reported_.dropped || lost.sampled != reported_.sampled) {
+        BeginLine(system_clock::now());
+        batch_ += "{\"dropped\":"sv;
+        AppendNumber(batch_, static_cast<long long>(lost.dropped - reported_.dropped));
+        batch_ += ",\"sampled\":"sv;
+        AppendNumber(batch_, static_cast<long long>(lost.sampled - reported_.sampled));
+        batch_ += '}';
+        EndLine("log records lost"sv);
+        reported_ = lost;
+    }
+    if (!batch_.empty()) {
+        os_.write(batch_.data(), static_cast<std::streamsize>(batch_.size()));
+        os_.flush();
+        batch_.clear();
+    }
+    written_.fetch_add(written, std::memory_order_relaxed);
+}
+
+void AsyncLog::FormatRecord(const LogRecord& record) {
+    BeginLine(record.time);
+    switch (record.kind) {
+    case LogRecord::Kind::Request:
+        // запросы подряд обычно приходят с одних и тех же адресов
+        if (record.address != cached_address_ || cached_address_str_.empty()) {
+            cached_address_ = record.address;
+            cached_address_str_ = record.address.to_string();
+        }
+        AppendRequestData(batch_, cached_address_str_, record.Text(), record.method);
+        EndLine("request received"sv);
+        break;
+    case LogRecord::Kind::Response:
+        AppendResponseData(batch_, record.response_time, record.status, record.Text());
+        EndLine("response sent"sv);
+        break;
+    }
+}
+
+// Время в формате to_iso_extended_string: местное, микросекунды только ненулевые
+void AsyncLog::BeginLine(system_clock::time_point time) {
+    const auto second = floor<seconds>(time);
+    if (second != cached_second_ || cached_timestamp_.empty()) {
+        const std::time_t t = system_clock::to_time_t(second);
+        std::tm tm{};
+        localtime_r(&t, &tm);
+        char buffer[32];
+        const auto size = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+        cached_timestamp_.assign(buffer, size);
+        cached_second_ = second;
+    }
+    batch_ += "{\"timestamp\":\""sv;
+    batch_ += cached_timestamp_;
+    if (const auto micro = duration_cast<microseconds>(time - second).count()) {
+        char fraction[8];
+        std::snprintf(fraction, sizeof(fraction), ".%06d", static_cast<int>(micro));
+        batch_ += fraction;
+    }
+    batch_ += "\",\"data\":"sv;
+}
+
+void AsyncLog::EndLine(std::string_view message) {
+    batch_ += ",\"message\":"sv;
+    AppendJsonString(batch_, message);
+    batch_ += "}\n"sv;
+}
+
+}  // namespace server_logging
@@ -0,0 +1,142 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <boost/asio/ip/address.hpp>
+#include <boost/beast/http/verb.hpp>
+
+namespace server_logging {
+
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+
+// Что делать с записью, когда буфер потока заполняется
+enum class Overflow {
+    // новые записи отбрасываются, пока буфер полон
+    Drop,
+    // с заполнения буфера на 3/4 пишется каждая sample_rate-я запись
+    Sample
+};
+
+struct AsyncLogConfig {
+    // записей в буфере каждого потока, округляется вверх до степени двойки
+    size_t buffer_records = 4096;
+    Overflow overflow = Overflow::Drop;
+    unsigned sample_rate = 16;
+    // как часто поток журнала забирает записи из буферов
+    std::chrono::milliseconds flush_period{20};
+    // будить поток журнала раньше, когда буфер заполнен наполовину
+    bool wake_on_half_full = true;
+};
+
+// Запись о запросе или ответе в двоичном виде: JSON из неё собирает поток журнала
+struct LogRecord {
+    static constexpr size_t TEXT_CAPACITY = 192;
+    enum class Kind : uint8_t {
+        Request,
+        Response
+    };
+
+    Kind kind = Kind::Request;
+    http::verb method = http::verb::unknown;
+    uint16_t text_size = 0;
+    unsigned status = 0;
+    long long response_time = 0;
+    std::chrono::system_clock::time_point time;
+    net::ip::address address;
+    // URI запроса или Content-Type ответа
+    std::array<char, TEXT_CAPACITY> text;
+
+    std::string_view Text() const {
+        return {text.data(), text_size};
+    }
+};
+
+// Асинхронный журнал. Потоки ввода-вывода пишут записи в свои кольцевые
+// буферы без блокировок; отдельный поток пачками собирает из них те же
+// JSON-строки, что и синхронный журнал, и выводит их в os
+class AsyncLog {
+public:
+    struct Stats {
+        uint64_t written = 0;
+        // отброшены при полном буфере
+        uint64_t dropped = 0;
+        // отброшены выборкой при Overflow::Sample
+        uint64_t sampled = 0;
+    };
+
+    AsyncLog(const AsyncLogConfig& config, std::ostream& os);
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+    // Выводит оставшиеся записи и останавливает поток журнала
+    ~AsyncLog();
+
+    void Request(const net::ip::address& address, std::string_view uri, http::verb method);
+    void Response(long long response_time, unsigned status_code, std::string_view content_type);
+    // Редкие события и записи, не помещающиеся в LogRecord: data - готовый
+    // JSON, очередь под мьютексом
+    void Line(std::string data, std::string_view message);
+    // Дожидается вывода всего, что записано до вызова
+    void Flush();
+    Stats GetStats() const;
+
+private:
+    class Ring;
+    struct PendingLine {
+        std::chrono::system_clock::time_point time;
+        std::string data;
+        std::string message;
+    };
+
+    const AsyncLogConfig config_;
+    const size_t capacity_;
+    // отличает буферы этого журнала в кэше потока
+    const uint64_t id_;
+    std::ostream& os_;
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_cv_;
+    std::vector<PendingLine> lines_;
+    uint64_t started_passes_ = 0;
+    uint64_t passes_ = 0;
+    bool flush_requested_ = false;
+    bool stop_ = false;
+    // буфер какого-то потока заполнен наполовину, пора вывести записи
+    std::atomic<bool> half_full_{false};
+
+    // изменяются только потоком журнала
+    std::vector<std::shared_ptr<Ring>> drain_rings_;
+    std::string batch_;
+    std::chrono::system_clock::time_point cached_second_;
+    std::string cached_timestamp_;
+    net::ip::address cached_address_;
+    std::string cached_address_str_;
+    Stats reported_;
+    std::atomic<uint64_t> written_{0};
+
+    std::thread thread_;
+
+    Ring& LocalRing();
+    LogRecord* Reserve(Ring& ring);
+    void Commit(Ring& ring);
+    void Run();
+    void Drain(std::vector<PendingLine>& lines);
+    void FormatRecord(const LogRecord& record);
+    void BeginLine(std::chrono::system_clock::time_point time);
+    void EndLine(std::string_view message);
+};
+
+}  // namespace server_logging
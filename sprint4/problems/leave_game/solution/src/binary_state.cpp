@@ -0,0 +1,183 @@
+#include "binary_state.h"
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace app {
+
+namespace {
+
+template <typename T>
+T ToLittleEndian(T value) {
+    if constexpr (std::endian::native == std::endian::big) {
+        T swapped = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            swapped = (swapped << 8) | (value & 0xFF);
+            value >>= 8;
+        }
+        return swapped;
+    }
+    return value;
+}
+
+// Запись в заранее выделенный буфер нужного размера
+class Writer {
+public:
+    explicit Writer(char* out) : out_(out) {
+    }
+    template <typename T>
+    void Put(T value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            Put(std::bit_cast<uint64_t>(static_cast<double>(value)));
+        } else {
+            value = ToLittleEndian(value);
+            std::memcpy(out_, &value, sizeof(value));
+            out_ += sizeof(value);
+        }
+    }
+private:
+    char* out_;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {
+    }
+    template <typename T>
+    T Get() {
+        if constexpr (std::is_floating_point_v<T>) {
+            return std::bit_cast<double>(Get<uint64_t>());
+        } else {
+            if (data_.size() < sizeof(T))
+                throw std::invalid_argument("Binary state is truncated");
+            T value;
+            std::memcpy(&value, data_.data(), sizeof(T));
+            data_.remove_prefix(sizeof(T));
+            return ToLittleEndian(value);
+        }
+    }
+    size_t Remaining() const noexcept {
+        return data_.size();
+    }
+private:
+    std::string_view data_;
+};
+
+uint8_t DirectionToByte(model::Direction dir) {
+    switch (dir) {
+    case model::Direction::NORTH:
+        return 'U';
+    case model::Direction::SOUTH:
+        return 'D';
+    case model::Direction::WEST:
+        return 'L';
+    case model::Direction::EAST:
+        return 'R';
+    }
+    return 'U';
+}
+
+model::Direction DirectionFromByte(uint8_t dir) {
+    switch (dir) {
+    case 'U':
+        return model::Direction::NORTH;
+    case 'D':
+        return model::Direction::SOUTH;
+    case 'L':
+        return model::Direction::WEST;
+    case 'R':
+        return model::Direction::EAST;
+    }
+    throw std::invalid_argument("Invalid dog direction in binary state");
+}
+
+}  // namespace
+
+std::string BinaryState::Encode(const model::SessionSnapshot& snapshot) {
+    size_t size = HEADER_SIZE + snapshot.dogs.size() * DOG_SIZE + snapshot.loots.size() * LOOT_SIZE;
+    for (const auto& dog : snapshot.dogs) {
+        if (dog.bag.size() > std::numeric_limits<uint16_t>::max())
+            throw std::length_error("Dog bag is too large for binary state");
+        size += dog.bag.size() * BAG_ITEM_SIZE;
+    }
+    std::string data(size, '\0');
+    Writer out{data.data()};
+    out.Put(MAGIC);
+    out.Put(static_cast<uint32_t>(snapshot.dogs.size()));
+    out.Put(static_cast<uint32_t>(snapshot.loots.size()));
+    out.Put(uint32_t{0});
+    out.Put(snapshot.version);
+    for (const auto& dog : snapshot.dogs) {
+        out.Put(static_cast<uint64_t>(*dog.id));
+        out.Put(dog.pos.x);
+        out.Put(dog.pos.y);
+        out.Put(dog.speed.x);
+        out.Put(dog.speed.y);
+        out.Put(static_cast<uint32_t>(dog.score));
+        out.Put(DirectionToByte(dog.dir));
+        out.Put(uint8_t{0});
+        out.Put(static_cast<uint16_t>(dog.bag.size()));
+        for (const auto& loot : dog.bag) {
+            out.Put(static_cast<uint32_t>(*loot.id));
+            out.Put(static_cast<uint32_t>(loot.type));
+        }
+    }
+    for (const auto& state : snapshot.loots) {
+        out.Put(static_cast<uint32_t>(*state.loot.id));
+        out.Put(static_cast<uint32_t>(state.loot.type));
+        out.Put(state.loot.pos.x);
+        out.Put(state.loot.pos.y);
+    }
+    return data;
+}
+
+BinaryState::State BinaryState::Decode(std::string_view data) {
+    Reader in{data};
+    if (in.Get<uint32_t>() != MAGIC)
+        throw std::invalid_argument("Not a binary game state");
+    const auto dog_count = in.Get<uint32_t>();
+    const auto loot_count = in.Get<uint32_t>();
+    in.Get<uint32_t>();
+    State state;
+    state.version = in.Get<uint64_t>();
+    // число записей проверяется до выделения памяти под них
+    if (in.Remaining() < dog_count * DOG_SIZE + loot_count * LOOT_SIZE)
+        throw std::invalid_argument("Binary state is truncated");
+    state.dogs.reserve(dog_count);
+    for (uint32_t i = 0; i < dog_count; ++i) {
+        // у идентификатора нет конструктора по умолчанию, остальные поля
+        // инициализируются явно и заполняются ниже в порядке записи
+        auto& dog = state.dogs.emplace_back(model::SessionSnapshot::DogState{
+            .id = model::Dog::Id{in.Get<uint64_t>()},
+            .pos = {}, .speed = {}, .dir = {}, .bag = {}, .score = 0, .changed_at = 0});
+        dog.pos.x = in.Get<double>();
+        dog.pos.y = in.Get<double>();
+        dog.speed.x = in.Get<double>();
+        dog.speed.y = in.Get<double>();
+        dog.score = in.Get<uint32_t>();
+        dog.dir = DirectionFromByte(in.Get<uint8_t>());
+        in.Get<uint8_t>();
+        const auto bag_size = in.Get<uint16_t>();
+        dog.bag.reserve(bag_size);
+        for (uint16_t j = 0; j < bag_size; ++j) {
+            auto& loot = dog.bag.emplace_back();
+            loot.id = model::Loot::Id{in.Get<uint32_t>()};
+            loot.type = in.Get<uint32_t>();
+        }
+    }
+    state.loots.reserve(loot_count);
+    for (uint32_t i = 0; i < loot_count; ++i) {
+        auto& loot = state.loots.emplace_back();
+        loot.id = model::Loot::Id{in.Get<uint32_t>()};
+        loot.type = in.Get<uint32_t>();
+        loot.pos.x = in.Get<double>();
+        loot.pos.y = in.Get<double>();
+    }
+    if (in.Remaining() != 0)
+        throw std::invalid_argument("Unexpected data after binary state");
+    return state;
+}
+
+}  // namespace app
@@ -0,0 +1,50 @@
+#pragma once
+#include "sdk.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "model/model.h"
+
+namespace app {
+
+// Двоичное представление состояния сессии (application/x-game-state).
+// Все поля - little-endian фиксированной ширины, вещественные - IEEE 754 double.
+//
+//   заголовок, 24 байта:
+//     u32 magic "GST1" | u32 число собак | u32 число трофеев | u32 0 | u64 версия снимка
+//   собака, 48 байт, затем её рюкзак:
+//     u64 id | f64 x | f64 y | f64 vx | f64 vy | u32 score | u8 dir ('U','D','L','R')
+//     | u8 0 | u16 число предметов в рюкзаке
+//   предмет рюкзака, 8 байт:
+//     u32 id | u32 type
+//   трофей на карте, 24 байта:
+//     u32 id | u32 type | f64 x | f64 y
+//
+// Собаки и трофеи идут в порядке снимка, как в JSON-ответе state.
+class BinaryState {
+public:
+    BinaryState() = delete;
+
+    static constexpr std::string_view CONTENT_TYPE = "application/x-game-state";
+    static constexpr uint32_t MAGIC = 0x31545347;  // "GST1"
+    static constexpr size_t HEADER_SIZE = 24;
+    static constexpr size_t DOG_SIZE = 48;
+    static constexpr size_t BAG_ITEM_SIZE = 8;
+    static constexpr size_t LOOT_SIZE = 24;
+
+    // Состояние, восстановленное из двоичного представления.
+    // У предметов рюкзака координаты не передаются и равны нулю
+    struct State {
+        uint64_t version = 0;
+        std::vector<model::SessionSnapshot::DogState> dogs;
+        std::vector<model::Loot> loots;
+    };
+
+    static std::string Encode(const model::SessionSnapshot& snapshot);
+    // Эталонный декодер. Бросает std::invalid_argument на повреждённых данных
+    static State Decode(std::string_view data);
+};
+
+}  // namespace app
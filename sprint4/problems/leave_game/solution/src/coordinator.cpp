@@ -0,0 +1,106 @@
+#include "coordinator.h"
+#include <iterator>
+#include <mutex>
+
+#include "metrics.h"
+#include "util/trace.h"
+
+namespace app {
+
+Coordinator::Coordinator(net::io_context& ioc, App& app, std::shared_ptr<ticker::TickProfiler> profiler)
+    : ioc_(ioc)
+    , strand_(net::make_strand(ioc))
+    , app_(app)
+    , profiler_(std::move(profiler)) {
+}
+
+Coordinator::Strand Coordinator::GetSessionStrand(const model::GameSession* session) {
+    {
+        std::shared_lock lock{strands_mutex_};
+        if (auto it = session_strands_.find(session); it != session_strands_.end())
+            return it->second;
+    }
+    std::unique_lock lock{strands_mutex_};
+    auto [it, inserted] = session_strands_.try_emplace(session, net::make_strand(ioc_));
+    return it->second;
+}
+
+void Coordinator::Tick(milliseconds delta, Done done) {
+    net::dispatch(strand_, [self = shared_from_this(), delta, done = std::move(done)]() mutable {
+        auto& pending = self->pending_ticks_;
+        // тики таймера без обработчика завершения склеиваются, чтобы очередь
+        // не росла, если тик не укладывается в период
+        if (!done && !pending.empty() && !pending.back().done) {
+            pending.back().delta += delta;
+            self->profiler_->RecordCoalesced();
+        } else
+            pending.push_back(PendingTick{delta, std::move(done)});
+        if (!self->ticking_)
+            self->RunNextTick();
+    });
+}
+
+void Coordinator::RunNextTick() {
+    if (pending_ticks_.empty()) {
+        ticking_ = false;
+        return;
+    }
+    ticking_ = true;
+    auto tick = std::move(pending_ticks_.front());
+    pending_ticks_.pop_front();
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    ForEachSession<SessionTick>(
+        [this, delta = tick.delta](model::GameSession& session) {
+            SessionTick result;
+            session.Tick(delta);
+            const auto retire_start = Clock::now();
+            result.retired = app_.RetireIdleDogs(session);
+            const auto retire_end = Clock::now();
+            result.times.retirement = retire_end - retire_start;
+            if (util::Tracer::Enabled())
+                TRACER().Record(ticker::RETIRE_PHASE_NAME, "tick", retire_start, retire_end);
+            result.times.session = *session.MapId();
+            result.times.phases = session.GetLastTickTimings();
+            return result;
+        },
+        [self = shared_from_this(), tick = std::move(tick), start](std::vector<SessionTick> results) {
+            ticker::TickTimes times;
+            auto stage_start = start;
+            auto finish = [&](ticker::Stage stage, Clock::time_point now = Clock::now()) {
+                const auto index = static_cast<size_t>(stage);
+                times.stages[index] = now - stage_start;
+                if (util::Tracer::Enabled())
+                    TRACER().Record(ticker::STAGE_NAMES[index], "tick", stage_start, now);
+                stage_start = now;
+            };
+            finish(ticker::Stage::Sessions);
+            RetiredPlayers retired_players;
+            times.sessions.reserve(results.size());
+            for (auto& result : results) {
+                std::move(result.retired.begin(), result.retired.end(), std::back_inserter(retired_players));
+                times.sessions.push_back(std::move(result.times));
+            }
+            try {
+                self->app_.CompleteRetirement(retired_players);
+                finish(ticker::Stage::Retirement);
+                self->app_.GetGameModel().NotifyTick(tick.delta);
+                finish(ticker::Stage::Notify);
+            } catch (const std::exception& ex) {
+                LOGSRV().Msg("Tick error", ex.what());
+            }
+            const auto end = Clock::now();
+            const auto total = end - start;
+            stage_start = start;
+            finish(ticker::Stage::Total, end);
+            METRICS().ObserveTick(std::chrono::duration_cast<std::chrono::microseconds>(total));
+            self->profiler_->RecordTick(times);
+            if (self->profiler_->SummaryDue(end))
+                LOGSRV().TickProfile(ticker::TickProfiler::ToJson(self->profiler_->GetReport()));
+            if (tick.done)
+                tick.done();
+            self->RunNextTick();
+        });
+}
+
+}  // namespace app
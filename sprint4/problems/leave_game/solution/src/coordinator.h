@@ -0,0 +1,125 @@
+#pragma once
+#include "sdk.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/asio/strand.hpp>
+
+#include "app.h"
+#include "log.h"
+#include "tick_profiler.h"
+
+namespace app {
+namespace net = boost::asio;
+
+// Распределяет работу по strand'ам игровых сессий.
+// Запросы одной сессии выполняются последовательно в её strand, разные
+// сессии обрабатываются параллельно. Работа, затрагивающая все сессии
+// (тик, сохранение, удаление ушедших игроков, таблица рекордов), выполняется
+// в strand координатора: он раздаёт задания сессиям и собирает результаты,
+// когда все сессии ответили.
+class Coordinator : public std::enable_shared_from_this<Coordinator> {
+public:
+    using Strand = net::strand<net::io_context::executor_type>;
+    using Done = std::function<void()>;
+
+    Coordinator(net::io_context& ioc, App& app,
+        std::shared_ptr<ticker::TickProfiler> profiler = std::make_shared<ticker::TickProfiler>());
+    Coordinator(const Coordinator&) = delete;
+    Coordinator& operator=(const Coordinator&) = delete;
+
+    // strand координатора
+    Strand GetStrand() const {
+        return strand_;
+    }
+    // замеры фаз каждого тика
+    const ticker::TickProfiler& GetTickProfiler() const {
+        return *profiler_;
+    }
+    // strand сессии, создаётся при первом обращении
+    Strand GetSessionStrand(const model::GameSession* session);
+
+    // Выполняет тик всех сессий, каждую в своём strand, и удаляет
+    // простаивающих игроков. После того как все сессии отработали,
+    // в strand координатора сохраняются рекорды и вызываются подписчики тика,
+    // затем done. Тики выполняются строго по очереди: пришедший во время
+    // тика запрос ставится в очередь
+    void Tick(milliseconds delta, Done done = {});
+
+    // Вызывает visit для каждой сессии в её strand и передаёт результаты
+    // в done в strand координатора. Порядок результатов совпадает с порядком
+    // сессий в Game::GetGameSessionList
+    template <typename Result>
+    void ForEachSession(std::function<Result(model::GameSession&)> visit,
+            std::function<void(std::vector<Result>)> done);
+
+private:
+    struct PendingTick {
+        milliseconds delta;
+        Done done;
+    };
+    struct SessionTick {
+        RetiredPlayers retired;
+        ticker::SessionTickTimes times;
+    };
+
+    net::io_context& ioc_;
+    Strand strand_;
+    App& app_;
+    std::shared_ptr<ticker::TickProfiler> profiler_;
+    std::shared_mutex strands_mutex_;
+    std::unordered_map<const model::GameSession*, Strand> session_strands_;
+    // доступны только из strand координатора
+    std::deque<PendingTick> pending_ticks_;
+    bool ticking_ = false;
+
+    void RunNextTick();
+};
+
+template <typename Result>
+void Coordinator::ForEachSession(std::function<Result(model::GameSession&)> visit,
+        std::function<void(std::vector<Result>)> done) {
+    struct Join {
+        std::function<Result(model::GameSession&)> visit;
+        std::function<void(std::vector<Result>)> done;
+        std::vector<Result> results;
+        std::atomic<size_t> remaining;
+    };
+    net::dispatch(strand_, [self = shared_from_this(), visit = std::move(visit),
+            done = std::move(done)]() mutable {
+        auto sessions = self->app_.GetGameModel().GetGameSessionList();
+        if (sessions.empty()) {
+            done({});
+            return;
+        }
+        auto join = std::make_shared<Join>();
+        join->visit = std::move(visit);
+        join->done = std::move(done);
+        join->results.resize(sessions.size());
+        join->remaining.store(sessions.size(), std::memory_order_relaxed);
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            auto session = sessions[i];
+            net::post(self->GetSessionStrand(session), [self, join, session, i] {
+                try {
+                    join->results[i] = join->visit(*session);
+                } catch (const std::exception& ex) {
+                    LOGSRV().Msg("Session task error", ex.what());
+                }
+                // последняя завершившаяся сессия передаёт результаты координатору
+                if (join->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    net::post(self->strand_, [join] {
+                        join->done(std::move(join->results));
+                    });
+                }
+            });
+        }
+    });
+}
+
+}  // namespace app
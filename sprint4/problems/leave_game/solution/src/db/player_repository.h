@@ -10,6 +10,8 @@ namespace app {
 class RetiredPlayerRepository {
 public:
     virtual void Save(const app::RetiredPlayer& dog) = 0;
+    // Все игроки одной транзакцией. Повторная запись игрока ничего не меняет
+    virtual void Save(const app::RetiredPlayers& retired_players) = 0;
     virtual app::RetiredPlayers Get(unsigned offset, unsigned limit) = 0;
 
 protected:
@@ -29,6 +29,34 @@ ON CONFLICT (id) DO NOTHING;
     work.commit();
 }
 
+void RetiredPlayerRepositoryImpl::Save(const app::RetiredPlayers& retired_players) {
+    if (retired_players.empty())
+        return;
+    auto conn = conn_pool_.GetConnection();
+    pqxx::work work{*conn};
+    // одна многострочная вставка на пакет, строки экранирует quote
+    std::string query = "INSERT INTO retired_players (id, name, score, play_time_ms) VALUES "s;
+    query.reserve(query.size() + retired_players.size() * 96);
+    bool first = true;
+    for (const auto& retired_player : retired_players) {
+        if (!first)
+            query += ',';
+        first = false;
+        query += '(';
+        query += work.quote(retired_player.GetId().ToString());
+        query += ',';
+        query += work.quote(retired_player.GetName());
+        query += ',';
+        query += std::to_string(retired_player.GetScore());
+        query += ',';
+        query += std::to_string(retired_player.GetPlayTime().count());
+        query += ')';
+    }
+    query += " ON CONFLICT (id) DO NOTHING;"sv;
+    work.exec(query);
+    work.commit();
+}
+
 app::RetiredPlayers RetiredPlayerRepositoryImpl::Get(unsigned offset, unsigned limit) {
     auto conn = conn_pool_.GetConnection();
     pqxx::read_transaction r{*conn};
@@ -4,6 +4,7 @@
 
 #include "player_repository.h"
 #include "pool_connection.h"
+#include "retired_players_writer.h"
 
 namespace postgres {
 
@@ -14,6 +15,7 @@ public:
     }
 
     void Save(const app::RetiredPlayer& retired_player) override;
+    void Save(const app::RetiredPlayers& retired_players) override;
     app::RetiredPlayers Get(unsigned offset, unsigned limit) override;
 
 private:
@@ -28,10 +30,18 @@ public:
     RetiredPlayerRepositoryImpl& GetRetiredPlayers() & {
         return retired_players_;
     }
+    app::RetiredPlayersWriter& GetRetiredPlayersWriter() & {
+        return retired_writer_;
+    }
+    const app::RetiredPlayersWriter& GetRetiredPlayersWriter() const& {
+        return retired_writer_;
+    }
 
 private:
     ConnectionPool conn_pool_;
     RetiredPlayerRepositoryImpl retired_players_{ conn_pool_ };
+    // останавливается первым и дописывает очередь через retired_players_
+    app::RetiredPlayersWriter retired_writer_{ retired_players_ };
 };
 
 }  // namespace postgres
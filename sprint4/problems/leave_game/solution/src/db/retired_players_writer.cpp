@@ -0,0 +1,104 @@
+#include "retired_players_writer.h"
+
+#include <algorithm>
+#include <iterator>
+#include "../log.h"
+
+namespace app {
+using namespace std::literals;
+
+RetiredPlayersWriter::RetiredPlayersWriter(RetiredPlayerRepository& repository)
+    : RetiredPlayersWriter{repository, Config{}} {
+}
+
+RetiredPlayersWriter::RetiredPlayersWriter(RetiredPlayerRepository& repository, Config config)
+    : repository_{repository}
+    , config_{config}
+    , thread_{[this] { Run(); }} {
+}
+
+RetiredPlayersWriter::~RetiredPlayersWriter() {
+    {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    thread_.join();
+}
+
+void RetiredPlayersWriter::Push(RetiredPlayers retired_players) {
+    if (retired_players.empty())
+        return;
+    {
+        std::lock_guard lock{mutex_};
+        stats_.queued += retired_players.size();
+        pending_.insert(pending_.end(), std::make_move_iterator(retired_players.begin()),
+            std::make_move_iterator(retired_players.end()));
+    }
+    work_cv_.notify_one();
+}
+
+bool RetiredPlayersWriter::Flush(milliseconds timeout) {
+    std::unique_lock lock{mutex_};
+    const auto target = stats_.queued;
+    return done_cv_.wait_for(lock, timeout, [this, target] {
+        return stats_.written + stats_.unflushed >= target;
+    });
+}
+
+RetiredPlayers RetiredPlayersWriter::GetPending() const {
+    std::lock_guard lock{mutex_};
+    return RetiredPlayers(pending_.begin(), pending_.end());
+}
+
+RetiredPlayersWriter::Stats RetiredPlayersWriter::GetStats() const {
+    std::lock_guard lock{mutex_};
+    return stats_;
+}
+
+void RetiredPlayersWriter::Run() {
+    auto backoff = config_.retry_min;
+    std::unique_lock lock{mutex_};
+    while (true) {
+        work_cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (pending_.empty())
+            return;
+        // пакет остаётся в начале очереди до успешной записи, Push дописывает в конец
+        const auto count = static_cast<std::ptrdiff_t>(
+            std::min(pending_.size(), std::max<size_t>(config_.max_batch, 1)));
+        RetiredPlayers batch(pending_.begin(), pending_.begin() + count);
+        lock.unlock();
+        std::string error;
+        try {
+            repository_.Save(batch);
+        }
+        catch (const std::exception& ex) {
+            error = ex.what();
+        }
+        catch (...) {
+            error = "unknown exception"s;
+        }
+        if (!error.empty())
+            LOGSRV().Msg("Retired players write error"sv, error);
+        lock.lock();
+        if (error.empty()) {
+            pending_.erase(pending_.begin(), pending_.begin() + count);
+            stats_.written += count;
+            ++stats_.batches;
+            backoff = config_.retry_min;
+            done_cv_.notify_all();
+            continue;
+        }
+        ++stats_.failures;
+        if (stop_) {
+            stats_.unflushed += pending_.size();
+            pending_.clear();
+            done_cv_.notify_all();
+            continue;
+        }
+        work_cv_.wait_for(lock, backoff, [this] { return stop_; });
+        backoff = std::min(backoff * 2, config_.retry_max);
+    }
+}
+
+}  // namespace app
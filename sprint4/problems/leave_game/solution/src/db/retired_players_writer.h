@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "player_repository.h"
+
+namespace app {
+
+// Отложенная запись ушедших игроков. Тик только ставит их в очередь, отдельный
+// поток базы пишет очередь пакетами до max_batch игроков, каждый пакет - одна
+// транзакция. Неудачный пакет остаётся в очереди и повторяется с паузой,
+// растущей вдвое от retry_min до retry_max. Деструктор дописывает очередь
+// без пауз, при ошибке базы остаток не записывается: к этому времени он
+// должен быть сохранён в файле состояния (GetPending)
+class RetiredPlayersWriter {
+public:
+    struct Config {
+        size_t max_batch = 500;
+        milliseconds retry_min{100};
+        milliseconds retry_max{5000};
+    };
+    struct Stats {
+        uint64_t queued = 0;
+        uint64_t written = 0;
+        uint64_t batches = 0;
+        uint64_t failures = 0;
+        // остались в очереди при остановке из-за ошибки базы
+        uint64_t unflushed = 0;
+    };
+
+    explicit RetiredPlayersWriter(RetiredPlayerRepository& repository);
+    RetiredPlayersWriter(RetiredPlayerRepository& repository, Config config);
+    RetiredPlayersWriter(const RetiredPlayersWriter&) = delete;
+    RetiredPlayersWriter& operator=(const RetiredPlayersWriter&) = delete;
+    ~RetiredPlayersWriter();
+
+    // Из любого потока, базу не ждёт
+    void Push(RetiredPlayers retired_players);
+    // Ждёт записи игроков, поставленных в очередь до вызова, не дольше timeout.
+    // false - не дождались, например база недоступна
+    bool Flush(milliseconds timeout);
+    // Игроки, ещё не записанные в базу, включая пакет, который пишется сейчас
+    RetiredPlayers GetPending() const;
+    Stats GetStats() const;
+
+private:
+    RetiredPlayerRepository& repository_;
+    const Config config_;
+    mutable std::mutex mutex_;
+    // новые игроки в очереди или остановка
+    std::condition_variable work_cv_;
+    // очередь продвинулась
+    std::condition_variable done_cv_;
+    // начало очереди уходит пакетами, поэтому deque
+    std::deque<RetiredPlayer> pending_;
+    Stats stats_;
+    bool stop_ = false;
+    // запускается последним, после остальных полей
+    std::thread thread_;
+
+    void Run();
+};
+
+}  // namespace app
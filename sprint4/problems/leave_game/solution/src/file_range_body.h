@@ -0,0 +1,169 @@
+#pragma once
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+namespace http_server {
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace sys = boost::system;
+using tcp = net::ip::tcp;
+
+// Тело ответа - участок открытого файла [offset, offset + size).
+// На Linux сессия отправляет его через sendfile(2): данные идут из кэша
+// страниц прямо в сокет, не проходя через буферы процесса. writer читает
+// файл кусками и используется там, где sendfile недоступен
+struct FileRangeBody {
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    struct value_type {
+        beast::file file;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    static uint64_t size(const value_type& body) {
+        return body.size;
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = net::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer(http::header<isRequest, Fields>&, value_type& body)
+            : body_(body) {
+        }
+        void init(beast::error_code& ec) {
+            remain_ = body_.size;
+            if (remain_ > 0)
+                body_.file.seek(body_.offset, ec);
+            else
+                ec = {};
+        }
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+            ec = {};
+            const auto amount = static_cast<size_t>(std::min<uint64_t>(remain_, BUFFER_SIZE));
+            if (amount == 0)
+                return boost::none;
+            const auto read = body_.file.read(buffer_, amount, ec);
+            if (ec)
+                return boost::none;
+            if (read == 0) {
+                // файл укоротился после формирования заголовков
+                ec = http::error::short_read;
+                return boost::none;
+            }
+            remain_ -= read;
+            return std::make_pair(const_buffers_type{buffer_, read}, remain_ > 0);
+        }
+    private:
+        value_type& body_;
+        uint64_t remain_ = 0;
+        char buffer_[BUFFER_SIZE];
+    };
+};
+
+#ifdef __linux__
+// Отправляет size байт файла fd начиная с offset в сокет через sendfile(2).
+// Когда буфер сокета заполнен, ждёт готовности сокета к записи асинхронно,
+// не дольше SEND_TIMEOUT: клиент, переставший читать, получает
+// beast::error::timeout. После каждого куска MAX_CHUNK операция уступает
+// поток через executor сокета. handler(error_code, отправлено байт)
+template <typename Handler>
+class SendFileOp {
+public:
+    // Сколько байт отправляется за один проход: большой файл не занимает
+    // поток целиком, даже когда сокет принимает данные без задержек
+    static constexpr uint64_t MAX_CHUNK = 1024 * 1024;
+    static constexpr std::chrono::seconds SEND_TIMEOUT{30};
+
+    SendFileOp(tcp::socket& socket, int fd, uint64_t offset, uint64_t size, Handler handler)
+        : socket_(socket)
+        , fd_(fd)
+        , offset_(offset)
+        , remain_(size)
+        , timer_(std::make_shared<Timer>(socket.get_executor()))
+        , handler_(std::move(handler)) {
+    }
+
+    void operator()(sys::error_code ec = {}) {
+        timer_->timer.cancel();
+        if (ec == net::error::operation_aborted && timer_->expired)
+            ec = beast::error::timeout;
+        if (!ec && !socket_.native_non_blocking())
+            socket_.native_non_blocking(true, ec);
+        uint64_t chunk_remain = MAX_CHUNK;
+        while (!ec && remain_ > 0) {
+            if (chunk_remain == 0)
+                return net::post(socket_.get_executor(), std::move(*this));
+            off_t offset = static_cast<off_t>(offset_);
+            const auto sent = ::sendfile(socket_.native_handle(), fd_, &offset,
+                static_cast<size_t>(std::min(remain_, chunk_remain)));
+            if (sent > 0) {
+                offset_ += sent;
+                remain_ -= sent;
+                sent_ += sent;
+                chunk_remain -= static_cast<uint64_t>(sent);
+            } else if (sent == 0) {
+                ec = http::error::short_read;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return Wait();
+            } else if (errno != EINTR) {
+                ec.assign(errno, sys::system_category());
+            }
+        }
+        handler_(ec, sent_);
+    }
+
+private:
+    // общий для копий операции: таймер ожидания сокета
+    struct Timer {
+        explicit Timer(const tcp::socket::executor_type& executor)
+            : timer(executor) {
+        }
+        net::steady_timer timer;
+        bool expired = false;
+    };
+
+    tcp::socket& socket_;
+    int fd_;
+    uint64_t offset_;
+    uint64_t remain_;
+    uint64_t sent_ = 0;
+    std::shared_ptr<Timer> timer_;
+    Handler handler_;
+
+    void Wait() {
+        // обработчики таймера и сокета выполняются в strand соединения
+        timer_->timer.expires_after(SEND_TIMEOUT);
+        timer_->timer.async_wait([timer = timer_, &socket = socket_](sys::error_code ec) {
+            // устаревшее срабатывание после перевзвода таймера не отменяет новое ожидание
+            if (ec || timer->timer.expiry() > net::steady_timer::clock_type::now())
+                return;
+            timer->expired = true;
+            socket.cancel();
+        });
+        socket_.async_wait(tcp::socket::wait_write, std::move(*this));
+    }
+};
+
+template <typename Handler>
+void AsyncSendFile(tcp::socket& socket, int fd, uint64_t offset, uint64_t size, Handler&& handler) {
+    SendFileOp<std::decay_t<Handler>>{socket, fd, offset, size, std::forward<Handler>(handler)}();
+}
+#endif
+
+}  // namespace http_server
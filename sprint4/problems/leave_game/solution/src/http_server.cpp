@@ -1,34 +1,11 @@
 #include "http_server.h"
 
 #include <boost/asio/dispatch.hpp>
+#include <boost/beast/websocket/rfc6455.hpp>
 #include <iostream>
 
 namespace http_server {
 
-std::string uriDecode(std::string_view src) {
-    std::string out;
-    for (int pos = 0; pos < src.length(); pos++) {
-        if (src[pos] == '%') {
-            int from_hex_char;
-            [[maybe_unused]] auto s = sscanf(
-                src.substr(pos + 1, 2).data(), "%x", &from_hex_char);
-            out += static_cast<char>(from_hex_char);
-            pos += 2;
-        }
-        else if (src[pos] == '+') {
-            out += ' ';
-            pos += 1;
-        }
-        else if (src[pos] >= 'A' && src[pos] <= 'Z') {
-            out += src[pos] - 'A' + 'a';
-        }
-        else {
-            out += src[pos];
-        }
-    }
-    return out;
-}
-
 void SessionBase::Run() {
     // Вызываем метод Read, используя executor объекта stream_.
     // Таким образом вся работа со stream_ будет выполняться, используя его executor
@@ -41,14 +18,17 @@ void SessionBase::Read() {
     // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
     request_ = {};
     stream_.expires_after(30s);
+    // на keep-alive соединении чтение включает ожидание следующего запроса
+    StartTrace(read_start_);
     // Считываем request_ из stream_, используя buffer_ для хранения считанных данных
     http::async_read(stream_, buffer_, request_,
         // По окончании операции будет вызван метод OnRead
         beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
 }
 
-void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+void SessionBase::OnRead(beast::error_code ec, std::size_t bytes_read) {
     using namespace std::literals;
+    METRICS().AddBytesReceived(bytes_read);
     if (ec == http::error::end_of_stream) {
         // Нормальная ситуация - клиент закрыл соединение
         return Close();
@@ -57,15 +37,28 @@ void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t byte
         LOGSRV().Error(ec, server_logging::Server::Where::read);
         return;
     }
-    std::string uri = uriDecode(request_.target());
-    auto rmeth = http::to_string(request_.method());
-    LOGSRV().Request(stream_.socket().remote_endpoint().address().to_string(),
-        uri, std::string_view(rmeth.data(), rmeth.size()));
+    trace_request_ = 0;
+    if (read_start_ != steady_clock::time_point{}) {
+        trace_request_ = util::Tracer::NextRequest();
+        TRACER().Record("read"sv, "http"sv, read_start_, steady_clock::now(), trace_request_);
+    }
+    // интервалы обработки в этом потоке относятся к запросу
+    util::TraceRequestScope trace_scope{trace_request_};
+    // target декодируется один раз и дальше передаётся вместе с запросом
+    RequestTarget target{request_.target()};
+    LOGSRV().Request(remote_address_, target.Decoded(), request_.method());
     start_time_ = steady_clock::now();
-    HandleRequest(std::move(request_));
+    if (upgrade_handler_ && beast::websocket::is_upgrade(request_)) {
+        // соединение переходит к обработчику, сессия завершается
+        return upgrade_handler_(std::move(stream_), std::move(request_), std::move(target));
+    }
+    HandleRequest(std::move(request_), std::move(target));
 }
 
-void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+void SessionBase::OnWrite(bool close, beast::error_code ec, std::size_t bytes_written) {
+    METRICS().AddBytesSent(bytes_written);
+    if (write_start_ != steady_clock::time_point{})
+        TRACER().Record("write"sv, "http"sv, write_start_, steady_clock::now(), trace_request_);
     if (ec) {
         LOGSRV().Error(ec, server_logging::Server::Where::write);
         return;
@@ -78,6 +71,41 @@ void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std
     Read();
 }
 
+void SessionBase::LogResponse(unsigned status, std::string_view content_type) {
+    auto time = steady_clock::now() - start_time_;
+    LOGSRV().Response(std::chrono::round<milliseconds>(time).count(), status, content_type);
+}
+
+void SessionBase::Write(http::response<FileRangeBody>&& response) {
+#ifdef __linux__
+    LogResponse(response.result_int(), response[http::field::content_type]);
+    StartTrace(write_start_);
+    // сериализатор хранит ссылку на ответ, поэтому оба живут в куче вместе
+    struct Pending {
+        http::response<FileRangeBody> response;
+        http::response_serializer<FileRangeBody> serializer{response};
+        explicit Pending(http::response<FileRangeBody>&& res)
+            : response(std::move(res)) {
+        }
+    };
+    auto pending = std::make_shared<Pending>(std::move(response));
+    auto self = GetSharedThis();
+    http::async_write_header(stream_, pending->serializer,
+        [pending, self](beast::error_code ec, std::size_t header_size) {
+            if (ec)
+                return self->OnWrite(false, ec, header_size);
+            const auto& body = pending->response.body();
+            AsyncSendFile(self->stream_.socket(), body.file.native_handle(), body.offset, body.size,
+                [pending, self, header_size](beast::error_code ec, uint64_t body_size) {
+                    self->OnWrite(pending->response.need_eof(), ec,
+                        header_size + static_cast<std::size_t>(body_size));
+                });
+        });
+#else
+    Write<FileRangeBody, http::fields>(std::move(response));
+#endif
+}
+
 void SessionBase::Close() {
     stream_.socket().shutdown(tcp::socket::shutdown_send);
 }
@@ -6,7 +6,12 @@
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <chrono>
+#include <functional>
+#include "file_range_body.h"
+#include "request_target.h"
 #include "log.h"
+#include "metrics.h"
+#include "util/trace.h"
 
 namespace http_server {
     
@@ -18,7 +23,10 @@ using tcp = net::ip::tcp;
 using namespace std::literals;
 using namespace std::chrono;
 
-std::string uriDecode(std::string_view src);
+// Получает соединение, запросившее переход на WebSocket (Upgrade),
+// вместе с запросом: дальше соединение обслуживается вне HTTP-сессии
+using UpgradeHandler = std::function<void(beast::tcp_stream&& stream,
+    http::request<http::string_body>&& request, RequestTarget&& target)>;
 
 class SessionBase {
 public:
@@ -29,14 +37,18 @@ public:
 
 protected:
     using HttpRequest = http::request<http::string_body>;
-    explicit SessionBase(tcp::socket&& socket)
-        : stream_(std::move(socket)) {
+    SessionBase(tcp::socket&& socket, UpgradeHandler upgrade_handler)
+        : stream_(std::move(socket))
+        , upgrade_handler_(std::move(upgrade_handler)) {
+        // адрес клиента не меняется, пока открыто соединение
+        sys::error_code ec;
+        remote_address_ = stream_.socket().remote_endpoint(ec).address();
+        METRICS().ConnectionOpened(metrics::Registry::Connection::Http);
     }
     template <typename Body, typename Fields>
     void Write(http::response<Body, Fields>&& response) {
-        auto time = steady_clock::now() - start_time_;
-        LOGSRV().Response(std::chrono::round<milliseconds>(time).count(), 
-            response.result_int(), response[http::field::content_type]);
+        LogResponse(response.result_int(), response[http::field::content_type]);
+        StartTrace(write_start_);
         // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
         auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
         auto self = GetSharedThis();
@@ -45,21 +57,37 @@ protected:
                               self->OnWrite(safe_response->need_eof(), ec, bytes_written);
                           });
     }
-    virtual ~SessionBase() = default;
+    // Участок файла: заголовок пишется через Beast, тело на Linux
+    // отправляется из файла в сокет через sendfile
+    void Write(http::response<FileRangeBody>&& response);
+    virtual ~SessionBase() {
+        METRICS().ConnectionClosed(metrics::Registry::Connection::Http);
+    }
 private:
     // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
     beast::tcp_stream stream_;
     beast::flat_buffer buffer_;
     HttpRequest request_;
     steady_clock::time_point start_time_;
+    UpgradeHandler upgrade_handler_;
+    net::ip::address remote_address_;
+    // начала чтения и записи для трассировки, пустые - трассировка выключена
+    steady_clock::time_point read_start_;
+    steady_clock::time_point write_start_;
+    // номер текущего запроса в трассировке
+    uint64_t trace_request_ = 0;
 
     virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
     void Read();
-    void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
-    void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
+    void OnRead(beast::error_code ec, std::size_t bytes_read);
+    void OnWrite(bool close, beast::error_code ec, std::size_t bytes_written);
     void Close();
+    void LogResponse(unsigned status, std::string_view content_type);
+    static void StartTrace(steady_clock::time_point& start) {
+        start = util::Tracer::Enabled() ? steady_clock::now() : steady_clock::time_point{};
+    }
     // Обработку запроса делегируем подклассу
-    virtual void HandleRequest(HttpRequest&& request) = 0;
+    virtual void HandleRequest(HttpRequest&& request, RequestTarget&& target) = 0;
 };
 
 template <typename RequestHandler>
@@ -67,8 +95,8 @@ class Session : public SessionBase, public std::enable_shared_from_this<Session<
 	// Напишите недостающий код, используя информацию из урока
 public:
     template <typename Handler>
-    Session(tcp::socket&& socket, Handler&& request_handler)
-        : SessionBase(std::move(socket))
+    Session(tcp::socket&& socket, Handler&& request_handler, UpgradeHandler upgrade_handler = {})
+        : SessionBase(std::move(socket), std::move(upgrade_handler))
         , request_handler_(std::forward<Handler>(request_handler)) {
     }
 private:
@@ -76,12 +104,11 @@ private:
     std::shared_ptr<SessionBase> GetSharedThis() override {
         return this->shared_from_this();
     }
-    void HandleRequest(HttpRequest&& request) override {
+    void HandleRequest(HttpRequest&& request, RequestTarget&& target) override {
         // Захватываем умный указатель на текущий объект Session в лямбде,
         // чтобы продлить время жизни сессии до вызова лямбды.
         // Используется generic-лямбда функция, способная принять response произвольного типа
-        tcp::endpoint ep;
-        request_handler_(ep, std::move(request), [self = this->shared_from_this()](auto&& response) {
+        request_handler_(std::move(target), std::move(request), [self = this->shared_from_this()](auto&& response) {
             self->Write(std::move(response));
         });
     }
@@ -92,11 +119,13 @@ class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
     // Напишите недостающий код, используя информацию из урока
 public:
     template <typename Handler>
-    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler)
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler,
+            UpgradeHandler upgrade_handler = {})
         : ioc_(ioc)
         // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
         , acceptor_(net::make_strand(ioc))
-        , request_handler_(std::forward<Handler>(request_handler)) {
+        , request_handler_(std::forward<Handler>(request_handler))
+        , upgrade_handler_(std::move(upgrade_handler)) {
         // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
         acceptor_.open(endpoint.protocol());
         // После закрытия TCP-соединения сокет некоторое время может считаться занятым,
@@ -118,6 +147,7 @@ private:
     net::io_context& ioc_;
     tcp::acceptor acceptor_;
     RequestHandler request_handler_;
+    UpgradeHandler upgrade_handler_;
 
     void DoAccept() {
         acceptor_.async_accept(
@@ -142,6 +172,7 @@ private:
             LOGSRV().Error(ec, server_logging::Server::Where::accept);
             return;
         }
+        util::TraceSpan span{"accept"sv, "http"sv};
         // Асинхронно обрабатываем сессию
         AsyncRunSession(std::move(socket));
         // Принимаем новое соединение
@@ -149,17 +180,22 @@ private:
     }
 
     void AsyncRunSession(tcp::socket&& socket) {
-        std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_)->Run();
+        std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_,
+            upgrade_handler_)->Run();
     }
 };
 
+// upgrade_handler - обработчик запросов WebSocket Upgrade; если не задан,
+// такие запросы обрабатываются как обычные HTTP-запросы
 template <typename RequestHandler>
-void ServerHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler) {
+void ServerHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler,
+        UpgradeHandler upgrade_handler = {}) {
     // Напишите недостающий код, используя информацию из урока
     // При помощи decay_t исключим ссылки из типа RequestHandler,
     // чтобы Listener хранил RequestHandler по значению
     using MyListener = Listener<std::decay_t<RequestHandler>>;
-    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler),
+        std::move(upgrade_handler))->Run();
 }
 
 }  // namespace http_server
@@ -2,6 +2,8 @@
 
 #include "../app.h"
 #include <boost/serialization/map.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 #include "model_serialization.h"
 
 
@@ -22,14 +24,15 @@ public:
     explicit PlayerRepr(const app::Player* player)
         : player_id_(player->GetId().ToString())
         , game_session_id_(player->GetSession()->MapId())
-        , dog_id_(player->GetDog()->GetId())
+        , dog_id_(player->GetDogId())
     {        
     }
 
     void Restore(app::App& app) const {
         model::GameSession* session = app.GetGameModel().FindGameSession(game_session_id_);
-        model::Dog* dog = session->FindDog(dog_id_);
-        app.EditPlayers().Add(app::PlayerId::FromString(player_id_), dog, session);
+        if (!session->FindDog(dog_id_))
+            throw std::logic_error("Player dog not found in game session");
+        app.EditPlayers().Add(app::PlayerId::FromString(player_id_), dog_id_, session);
     }
 
     template <typename Archive>
@@ -53,6 +56,10 @@ public:
         for(auto &[player_id, player] : players.GetPlayers()) 
             players_repr_.push_back(std::move(PlayerRepr(player.get())));
     }
+    explicit PlayersRepr(std::list<PlayerRepr> players)
+        : players_repr_(std::move(players))
+    {
+    }
 
     void Restore(app::App& app) const {
         for (auto &player_repr : players_repr_) {
@@ -80,6 +87,11 @@ public:
         }
     }
 
+    explicit PlayerTokensRepr(std::map<std::string, std::string> player_tokens)
+        : player_tokens_(std::move(player_tokens))
+    {
+    }
+
     void Restore(app::App& app) const {
         for (auto &player_token : player_tokens_) {
             app.EditPlayerTokens().AddToken(security::Token{ player_token.first },
@@ -96,34 +108,142 @@ private:
     std::map<std::string, std::string> player_tokens_;
 };
 
+// Сессия вместе с её игроками и токенами, снятые в strand сессии за один
+// обход. Вход игрока (собака, игрок, токен) выполняется в том же strand,
+// поэтому у каждого снятого игрока есть снятая собака. Игроки ищутся по
+// собакам сессии: собака ушедшего игрока уже удалена, и он не сохраняется
+class SessionStateRepr {
+public:
+    SessionStateRepr() = default;
+
+    SessionStateRepr(const model::GameSession& session, const app::App& app)
+        : session_(session)
+        , captured_(true)
+    {
+        for (const auto& dog : session.GetDogs()) {
+            const auto player = app.GetPlayers().FindPlayerByDog(&session, dog.GetId());
+            if (!player)
+                continue;
+            players_.emplace_back(player.get());
+            if (auto token = app.GetPlayerTokens().FindToken(player->GetId()))
+                tokens_.emplace(**token, player->GetId().ToString());
+        }
+    }
+
+private:
+    friend class AppRepr;
+
+    GameSessionRepr session_;
+    std::list<PlayerRepr> players_;
+    std::map<std::string, std::string> tokens_;
+    // false - обход сессии завершился ошибкой, сессия не сохраняется
+    bool captured_ = false;
+};
+
+// Результат ушедшего игрока, ещё не записанный в базу
+class RetiredPlayerRepr {
+public:
+    RetiredPlayerRepr() = default;
+
+    explicit RetiredPlayerRepr(const app::RetiredPlayer& retired_player)
+        : player_id_(retired_player.GetId().ToString())
+        , name_(retired_player.GetName())
+        , score_(retired_player.GetScore())
+        , play_time_ms_(retired_player.GetPlayTime().count())
+    {
+    }
+
+    app::RetiredPlayer Restore() const {
+        return app::RetiredPlayer{app::PlayerId::FromString(player_id_), name_, score_,
+            app::milliseconds{play_time_ms_}};
+    }
+
+    template <typename Archive>
+    void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
+        ar& player_id_;
+        ar& name_;
+        ar& score_;
+        ar& play_time_ms_;
+    }
+
+private:
+    std::string player_id_;
+    std::string name_;
+    model::Score score_ = 0;
+    app::milliseconds::rep play_time_ms_ = 0;
+};
+
 class AppRepr {
 public:
     AppRepr() = default;
 
     explicit AppRepr(app::App& app)
         : game_repr_(app.GetGameModel())
-        , players_repr_(app.GetPlayers())
         , player_tokens_repr_(app.GetPlayerTokens()) 
+        , players_repr_(app.GetPlayers())
+        , retired_repr_(MakeRetiredRepr(app))
     {
     }
+    // Сессии, их игроки и токены сняты заранее, каждая в своём strand
+    AppRepr(std::vector<SessionStateRepr> sessions, const app::App& app)
+        : retired_repr_(MakeRetiredRepr(app))
+    {
+        std::list<GameSessionRepr> game_sessions;
+        std::list<PlayerRepr> players;
+        std::map<std::string, std::string> tokens;
+        for (auto& session : sessions) {
+            if (!session.captured_)
+                continue;
+            game_sessions.push_back(std::move(session.session_));
+            players.splice(players.end(), session.players_);
+            tokens.merge(session.tokens_);
+        }
+        game_repr_ = GameRepr{GameSessionsRepr{std::move(game_sessions)}};
+        players_repr_ = PlayersRepr{std::move(players)};
+        player_tokens_repr_ = PlayerTokensRepr{std::move(tokens)};
+    }
 
     void Restore(app::App& app) const {
         game_repr_.Restore(app.GetGameModel());
         players_repr_.Restore(app);
         player_tokens_repr_.Restore(app);
+        app::RetiredPlayers retired_players;
+        retired_players.reserve(retired_repr_.size());
+        for (const auto& retired_repr : retired_repr_)
+            retired_players.push_back(retired_repr.Restore());
+        app.RestoreRetiredPlayers(std::move(retired_players));
     }
 
     template <typename Archive>
-    void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
+    void serialize(Archive& ar, const unsigned version) {
         ar& game_repr_;
         ar& players_repr_;
         ar& player_tokens_repr_;
+        // в файлах версии 0 очереди ушедших игроков нет
+        if (version >= 1)
+            ar& retired_repr_;
     }
 
 private:
     GameRepr game_repr_;
-    PlayersRepr players_repr_;
+    // токены снимаются раньше игроков: игрок добавляется до выдачи токена,
+    // поэтому у каждого сохранённого токена есть сохранённый игрок
     PlayerTokensRepr player_tokens_repr_;
+    PlayersRepr players_repr_;
+    // снимается после игроков: игрок, ушедший между снимками, попадёт в оба
+    // и запишется в базу один раз, но не пропадёт из обоих. Снимок по сессиям
+    // делается внутри тика (после CompleteRetirement) или после остановки
+    // тикера, поэтому игрок с удалённой собакой уже в очереди записи
+    std::vector<RetiredPlayerRepr> retired_repr_;
+
+    static std::vector<RetiredPlayerRepr> MakeRetiredRepr(const app::App& app) {
+        std::vector<RetiredPlayerRepr> retired_repr;
+        for (const auto& retired_player : app.GetPendingRetiredPlayers())
+            retired_repr.emplace_back(retired_player);
+        return retired_repr;
+    }
 };
 
 }  // namespace serialization
+
+BOOST_CLASS_VERSION(::serialization::AppRepr, 1)
@@ -2,8 +2,10 @@
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <fstream>
+#include <future>
 #include <filesystem>
 #include "../log.h"
+#include "../util/trace.h"
 
 namespace infrastructure {
 using InputArchive = boost::archive::text_iarchive;
@@ -51,13 +53,71 @@ void SerializingListiner::Load() {
     }
 }
 
-void SerializingListiner::Save() {
+void SerializingListiner::SetSessionsCollector(SessionsCollector collector) {
+    sessions_collector_ = std::move(collector);
+}
+
+void SerializingListiner::SetSaveObserver(SaveObserver observer) {
+    save_observer_ = std::move(observer);
+}
+
+void SerializingListiner::Save(Done done) {
+    if (state_file_.empty()) {
+        if (done)
+            done();
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    if (!sessions_collector_) {
+        Write(serialization::AppRepr{*app_});
+        ObserveSave(start);
+        if (done)
+            done();
+        return;
+    }
+    sessions_collector_([this, done = std::move(done), start](std::vector<serialization::SessionStateRepr> sessions) {
+        try {
+            Write(serialization::AppRepr{std::move(sessions), *app_});
+        } catch (...) {
+            // ошибка уже в логе, done должен быть вызван и при неудаче
+        }
+        ObserveSave(start);
+        if (done)
+            done();
+    });
+}
+
+void SerializingListiner::SaveAndWait() {
     if (state_file_.empty())
         return;
+    const auto start = std::chrono::steady_clock::now();
+    if (!sessions_collector_) {
+        Write(serialization::AppRepr{*app_});
+        ObserveSave(start);
+        return;
+    }
+    std::promise<std::vector<serialization::SessionStateRepr>> collected;
+    auto sessions = collected.get_future();
+    sessions_collector_([&collected](std::vector<serialization::SessionStateRepr> sessions) {
+        collected.set_value(std::move(sessions));
+    });
+    Write(serialization::AppRepr{sessions.get(), *app_});
+    ObserveSave(start);
+}
+
+void SerializingListiner::ObserveSave(std::chrono::steady_clock::time_point start) const {
+    const auto end = std::chrono::steady_clock::now();
+    if (util::Tracer::Enabled())
+        TRACER().Record("save"sv, "tick"sv, start, end);
+    if (save_observer_)
+        save_observer_(end - start);
+}
+
+void SerializingListiner::Write(const serialization::AppRepr& repr) const {
     try {
         std::ofstream archive_{state_file_};
         OutputArchive output_archive{archive_};
-        output_archive << serialization::AppRepr{*app_};
+        output_archive << repr;
     }
     catch (const std::exception& ex) {
         LOGSRV().Msg("Error save serialize", ex.what());
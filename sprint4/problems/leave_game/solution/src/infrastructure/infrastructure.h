@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include "app_serialization.h"
 
 namespace infrastructure {
@@ -9,17 +10,39 @@ using namespace std::literals;
 
 class SerializingListiner {
 public:
+    using Done = std::function<void()>;
+    // Снимает представления всех игровых сессий вместе с их игроками
+    // и токенами и передаёт их в done
+    using SessionsCollector = std::function<void(
+        std::function<void(std::vector<serialization::SessionStateRepr>)> done)>;
+    // Получает время сохранения: от снятия состояния до записи файла
+    using SaveObserver = std::function<void(std::chrono::nanoseconds)>;
+
     SerializingListiner(std::shared_ptr<app::App> &app, const std::string& state_file, 
         milliseconds save_period);
     void OnTick(milliseconds time_delta_ms);
-    void Save();
+    // Без сборщика сессии читаются напрямую, что допустимо, только пока
+    // их никто не изменяет. Со сборщиком сохранение асинхронное,
+    // done вызывается после записи файла
+    void SetSessionsCollector(SessionsCollector collector);
+    void SetSaveObserver(SaveObserver observer);
+    void Save(Done done = {});
+    // Сохраняет состояние и ждёт записи файла: сессии снимаются в их strand'ах,
+    // файл пишется в вызывающем потоке. Не вызывается из потоков io_context,
+    // ошибка записи - исключение
+    void SaveAndWait();
     void Load();
 
 private:
     std::shared_ptr<app::App> &app_;
+    SessionsCollector sessions_collector_;
+    SaveObserver save_observer_;
     const std::string state_file_;
     milliseconds save_period_;
     milliseconds time_since_save_;
+
+    void Write(const serialization::AppRepr& repr) const;
+    void ObserveSave(std::chrono::steady_clock::time_point start) const;
 };
 
 } // namespace infrastructure
@@ -1,6 +1,8 @@
 #pragma once
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/list.hpp>
+#include <boost/serialization/split_free.hpp>
+#include <boost/serialization/level.hpp>
 
 #include "../model/model.h"
 
@@ -40,16 +42,34 @@ void serialize(Archive& ar, Loot& obj, [[maybe_unused]] const unsigned version)
     ar&(obj.pos);
 }
 
+// Трофеи пишутся как последовательность в порядке обхода хранилища.
+// Сам Loots помечен как object_serializable, поэтому в архиве остаётся только
+// заголовок вложенного вектора - тот же формат, что был у std::list<Loot>
 template <typename Archive>
-void serialize(Archive& ar, Dog::Id& obj, [[maybe_unused]] const unsigned version) {
-    ar& (*obj);
+void save(Archive& ar, const Loots& loots, [[maybe_unused]] const unsigned version) {
+    const std::vector<Loot> sequence(loots.begin(), loots.end());
+    ar << sequence;
+}
+
+template <typename Archive>
+void load(Archive& ar, Loots& loots, [[maybe_unused]] const unsigned version) {
+    std::vector<Loot> sequence;
+    ar >> sequence;
+    loots.clear();
+    loots.reserve(sequence.size());
+    for (auto& loot : sequence)
+        loots.Insert(std::move(loot));
 }
+
 template <typename Archive>
-void serialize(Archive& ar, GameSession::Dogs& obj, [[maybe_unused]] const unsigned version) {
-    for (auto &dog : obj)
-        ar& (dog);
+void serialize(Archive& ar, Loots& loots, const unsigned version) {
+    boost::serialization::split_free(ar, loots, version);
 }
 
+template <typename Archive>
+void serialize(Archive& ar, Dog::Id& obj, [[maybe_unused]] const unsigned version) {
+    ar& (*obj);
+}
 template <typename Archive>
 void serialize(Archive& ar, model::Game::GameSessions& objs, [[maybe_unused]] const unsigned version) {
     for (auto &odj : objs)
@@ -57,6 +77,8 @@ void serialize(Archive& ar, model::Game::GameSessions& objs, [[maybe_unused]] co
 }
 }  // namespace model
 
+BOOST_CLASS_IMPLEMENTATION(model::Loots, boost::serialization::object_serializable)
+
 namespace serialization {
 
 // DogRepr (DogRepresentation) - сериализованное представление класса Dog
@@ -84,11 +106,7 @@ public:
         dog.AddScore(score_);
         dog.SetLastMoveTime(std::chrono::milliseconds(lifetime_-stay_time_));
         dog.SetLifeTime(std::chrono::milliseconds(lifetime_));
-        model::Loots bag_content = bag_content_;
-        for (auto it = bag_content.begin(), itn = bag_content.begin(); it != bag_content.end(); it = itn) {
-            itn = std::next(it);
-            dog.PutTheLoot(bag_content, it);
-        }
+        dog.SetLoots(bag_content_);
         return dog;
     }
 
@@ -125,23 +143,22 @@ public:
         , last_dog_id_(game_session.GetLastDogId())
         , loots_(game_session.GetLoots())
     {
-        for (auto &[id, dog] : game_session.GetDogs())
-            dogs_repr_.push_back(DogRepr(dog));
+        for (const auto& dog : game_session.GetDogs())
+            dogs_repr_.push_back(DogRepr(dog.ToDog()));
     }
 
     [[nodiscard]] model::GameSession Restore(
-            const model::Map* map, 
+            std::shared_ptr<const model::MapIndex> map_index,
             bool randomize_spawn_points,
             const model::LootGeneratorConfig loot_generator_config) const {
-        model::GameSession game_session(map, randomize_spawn_points, loot_generator_config);
+        model::GameSession game_session(std::move(map_index), randomize_spawn_points,
+            loot_generator_config);
         game_session.SetLastLootId(last_loot_id_);
-        model::GameSession::Dogs dogs;
+        std::vector<model::Dog> dogs;
         for (auto &dog_repr : dogs_repr_) {
-            auto dog = dog_repr.Restore();
-            auto id = dog.GetId();
-            dogs.emplace(id, dog);
+            dogs.push_back(dog_repr.Restore());
         }
-        game_session.SetDogs(dogs);
+        game_session.SetDogs(std::move(dogs));
         game_session.SetLoots(loots_);
         game_session.SetLastLootId(last_loot_id_);
         game_session.SetLastDogId(last_dog_id_);
@@ -178,12 +195,19 @@ public:
         for (auto &gs : game_sessions)
             game_sessions_repr.push_back(GameSessionRepr(gs));
     }
+    // Из представлений, снятых заранее (например, каждое в strand своей сессии)
+    explicit GameSessionsRepr(std::list<GameSessionRepr> game_sessions)
+        : game_sessions_repr(std::move(game_sessions))
+    {
+    }
 
     [[nodiscard]] model::Game::GameSessions Restore(model::Game &game) const {
         model::Game::GameSessions gs;
         for (auto &game_session_repr : game_sessions_repr) {
-            auto map = game.FindMap(game_session_repr.GetMapId());
-            gs.push_back(game_session_repr.Restore(map, game.GetRandomizeSpawnPoints(), 
+            auto map_index = game.FindMapIndex(game_session_repr.GetMapId());
+            if (!map_index)
+                throw std::logic_error("Map of saved game session is not found");
+            gs.push_back(game_session_repr.Restore(std::move(map_index), game.GetRandomizeSpawnPoints(), 
                 game.GetLootGeneratorConfig()));
         }
         return gs;
@@ -207,6 +231,10 @@ public:
         : game_sessions_repr(game.GetGameSessions())
     {
     }
+    explicit GameRepr(GameSessionsRepr game_sessions)
+        : game_sessions_repr(std::move(game_sessions))
+    {
+    }
 
     void Restore(model::Game &game) const {
         game.SetGameSessions(game_sessions_repr.Restore(game));
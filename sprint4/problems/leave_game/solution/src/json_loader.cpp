@@ -142,6 +142,7 @@ std::unique_ptr<model::Game> LoadGame(const fs::path& json_path) {
         BOOST_FOREACH(ptree::value_type &jmap, jmaps) {
             game->AddMap(LoadMap(jmap.second, def_param));
         }
+        game->BuildMapIndexes();
         game->AddExtraData(LoadExtraData(json_path));
         return std::move(game);
     }
@@ -32,7 +32,7 @@ static void JsonFormatter(logging::record_view const& rec, logging::formatting_o
     strm << "\"message\":\"" << rec[msg] << "\"}" << std::endl;
 }
 
-void InitBoostLogFilter() {
+void InitBoostLogFilter(std::ostream& stream) {
     logging::core::get()->set_filter(
         logging::trivial::severity >= logging::trivial::info
     );
@@ -47,7 +47,7 @@ void InitBoostLogFilter() {
         keywords::time_based_rotation = sinks::file::rotation_at_time_point(12, 0, 0)
     );*/
     logging::add_console_log(
-        std::cout,
+        stream,
         keywords::format = &JsonFormatter,
         keywords::auto_flush = true
     );
@@ -59,11 +59,28 @@ void Log::Info(std::string_view data_, std::string_view message_) {
         << logging::add_value(msg, message_);
 }
 
+void Server::StartAsync(const AsyncLogConfig& config, std::ostream& os) {
+    async_log_ = std::make_unique<AsyncLog>(config, os);
+    async_.store(async_log_.get(), std::memory_order_release);
+}
+
+void Server::StopAsync() {
+    async_.store(nullptr, std::memory_order_release);
+    async_log_.reset();
+}
+
+void Server::Write(std::string data, std::string_view message) {
+    if (auto* async = async_.load(std::memory_order_acquire))
+        async->Line(std::move(data), message);
+    else
+        log_.Info(data, message);
+}
+
 void Server::Start(std::string_view address, int port) {
     json::object mapEl;
     mapEl["port"] = port;
     mapEl["address"] = address.data();
-    log_.Info(serialize(mapEl), "server started"sv);
+    Write(serialize(mapEl), "server started"sv);
 }
 
 void Server::End(const boost::system::error_code& err) {
@@ -72,7 +89,11 @@ void Server::End(const boost::system::error_code& err) {
     
     if (err)
         mapEl["exception"] = err.what();
-    log_.Info(serialize(mapEl), "server exited"sv);
+    Write(serialize(mapEl), "server exited"sv);
+}
+
+void Server::TickProfile(const json::object& profile) {
+    Write(serialize(profile), "tick profile"sv);
 }
 
 void Server::Error(const sys::error_code& ec, Where where)
@@ -93,24 +114,29 @@ void Server::Error(const sys::error_code& ec, Where where)
     mapEl["code"] = ec.value();
     mapEl["text"] = ec.message();
     mapEl["where"] = svWhere;
-    log_.Info(serialize(mapEl), "error"sv);
+    Write(serialize(mapEl), "error"sv);
 }
 
 static auto to_booststr = [](std::string_view str) {
     return boost::string_view(str.data(), str.size());
 };
 
-void Server::Request(std::string_view address, std::string_view uri, std::string_view method)
+void Server::Request(const net::ip::address& address, std::string_view uri, http::verb method)
 {
+    if (auto* async = async_.load(std::memory_order_acquire))
+        return async->Request(address, uri, method);
+    const auto method_str = http::to_string(method);
     json::object mapEl;
-    mapEl["address"] = to_booststr(address);
+    mapEl["address"] = address.to_string();
     mapEl["URI"] = to_booststr(uri);
-    mapEl["method"] = to_booststr(method);
+    mapEl["method"] = boost::string_view(method_str.data(), method_str.size());
     log_.Info(serialize(mapEl), "request received"sv);
 }
 
 void Server::Response(long long response_time, unsigned status_code, std::string_view content_type)
 {
+    if (auto* async = async_.load(std::memory_order_acquire))
+        return async->Response(response_time, status_code, content_type);
     json::object mapEl;
     mapEl["response_time"] = response_time;
     mapEl["code"] = status_code;
@@ -126,7 +152,7 @@ void Server::Msg(std::string_view header, std::string_view message) {
     json::object mapEl;
     mapEl["header"] = to_booststr(header);
     mapEl["message"] = to_booststr(message);
-    log_.Info(serialize(mapEl), "response sent"sv);
+    Write(serialize(mapEl), "response sent"sv);
 }
 
 }
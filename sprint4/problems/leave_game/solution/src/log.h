@@ -6,6 +6,7 @@
 #include <boost/system.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/http.hpp>
+#include "async_log.h"
 
 #define LOG() server_logging::Log::GetInstance()
 #define LOGSRV() server_logging::Server::GetInstance()
@@ -19,7 +20,7 @@ using tcp = net::ip::tcp;
 namespace beast = boost::beast;
 namespace http = beast::http;
     
-void InitBoostLogFilter();
+void InitBoostLogFilter(std::ostream& stream = std::cout);
 
 // Для синхронного вывода в Boost.Asio могут использовать любой тип, удовлетворяющий требованиям,
 // описанным в документе:
@@ -74,7 +75,11 @@ private:
 class Server {
 private:
     Log& log_; 
+    // асинхронный журнал, пока он запущен
+    std::unique_ptr<AsyncLog> async_log_;
+    std::atomic<AsyncLog*> async_{nullptr};
     Server() : log_(Log::GetInstance()) {}
+    void Write(std::string data, std::string_view message);
 public:
     enum class Where {
         read,
@@ -88,9 +93,17 @@ public:
     void Start(std::string_view address, int port);
     void End(const sys::error_code& ec);
     void Error(const sys::error_code& ec, Where where);
-    void Request(std::string_view address, std::string_view uri, std::string_view method);
+    void Request(const net::ip::address& address, std::string_view uri, http::verb method);
     void Msg(std::string_view address, std::string_view uri);
     void Response(long long response_time, unsigned status_code, std::string_view content_type);
+    // Периодическая сводка профиля тиков
+    void TickProfile(const json::object& profile);
+    // Дальше записи выводит поток журнала. Вызывается до запуска потоков,
+    // которые пишут в журнал
+    void StartAsync(const AsyncLogConfig& config, std::ostream& os = std::cout);
+    // Выводит оставшиеся записи, журнал снова синхронный. Вызывается после
+    // остановки потоков, которые пишут в журнал
+    void StopAsync();
 };
 
 template<class SomeRequestHandler>
@@ -99,11 +112,11 @@ public:
     LoggingRequestHandler(SomeRequestHandler&& requestHandler) : 
         decorated_(std::forward<SomeRequestHandler>(requestHandler)) {
     }
-    template <typename Body, typename Allocator, typename Send>
-     void operator () (tcp::endpoint ep, 
+    template <typename Target, typename Body, typename Allocator, typename Send>
+     void operator () (Target&& target,
             http::request<Body, http::basic_fields<Allocator>>&& req, 
             Send&& send) {
-        decorated_(ep, std::forward<decltype(req)>(req),
+        decorated_(std::forward<Target>(target), std::forward<decltype(req)>(req),
         std::forward<decltype(send)>(send));
     }
 
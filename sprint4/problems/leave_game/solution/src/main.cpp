@@ -7,11 +7,15 @@
 
 #include "json_loader.h"
 #include "request_handler/request_handler.h"
+#include "request_handler/ws_session.h"
 #include "log.h"
 #include "app.h"
+#include "coordinator.h"
+#include "state_feed.h"
 #include "ticker.h"
 #include "http_server.h"
 #include "infrastructure/infrastructure.h"
+#include "util/trace.h"
 
 using namespace std::literals;
 namespace sys = boost::system;
@@ -32,6 +36,17 @@ void RunThreads(unsigned number_of_threads, const Fn& fn) {
     fn();
 }
 constexpr const char DB_URL_ENV_NAME[]{ "GAME_DB_URL" };
+// Сколько при остановке ждать записи ушедших игроков в базу
+constexpr std::chrono::milliseconds RETIRED_PLAYERS_FLUSH_TIMEOUT{ 5s };
+
+// Токен служебных endpoint'ов (/metrics, /admin/...), без него они отключены
+constexpr const char ADMIN_TOKEN_ENV_NAME[]{ "GAME_ADMIN_TOKEN" };
+
+std::string GetAdminTokenFromEnv() {
+    if (const auto* token = std::getenv(ADMIN_TOKEN_ENV_NAME))
+        return token;
+    return {};
+}
 
 std::string GetConfigFromEnv() {
     std::string db_url;
@@ -52,6 +67,11 @@ struct Args {
     std::chrono::milliseconds tick_period;
     bool on_tick_api = false;
     bool randomize_spawn_points = false;
+    uint64_t static_cache_limit = http_handler::StaticIndex::DEFAULT_CACHE_FILE_LIMIT;
+    server_logging::AsyncLogConfig log_config;
+    std::chrono::milliseconds tick_profile_period{60'000};
+    bool trace = false;
+    size_t trace_buffer = util::Tracer::DEFAULT_BUFFER_EVENTS;
 };
 
 [[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
@@ -61,6 +81,8 @@ struct Args {
     Args args;
     uint64_t time = 0;
     uint64_t period_serialization = 0;
+    uint64_t tick_profile_period = args.tick_profile_period.count();
+    std::string log_overflow = "drop"s;
     desc.add_options()
         // Добавляем опцию --help и её короткую версию -h
         ("help,h", "produce help message")
@@ -75,7 +97,19 @@ struct Args {
         // get file name to save serialization file
         ("state-file", po::value(&args.state_file)->value_name("file"s), "set serialization file path")
         // get period to save serialization
-        ("save-state-period", po::value(&period_serialization)->value_name("milliseconds"s), "set serialization period");
+        ("save-state-period", po::value(&period_serialization)->value_name("milliseconds"s), "set serialization period")
+        // статические файлы не больше этого размера хранятся в памяти
+        ("static-cache-limit", po::value(&args.static_cache_limit)->value_name("bytes"s), "set max size of static file cached in memory")
+        // журнал пишет отдельный поток, 0 - синхронный журнал
+        ("log-buffer", po::value(&args.log_config.buffer_records)->value_name("records"s), "set log buffer size per thread, 0 - synchronous log")
+        // что делать с записями, когда буфер журнала заполняется
+        ("log-overflow", po::value(&log_overflow)->value_name("drop|sample"s), "set log buffer overflow policy")
+        ("log-sample-rate", po::value(&args.log_config.sample_rate)->value_name("n"s), "keep every n-th record when log buffer is nearly full")
+        // период сводки профиля тиков в журнале, 0 - без сводок
+        ("tick-profile-period", po::value(&tick_profile_period)->value_name("milliseconds"s), "set tick profile log summary period, 0 - no summaries")
+        // трассировка включается и выключается через /admin/trace/start и /admin/trace/stop
+        ("trace", "record trace spans from start")
+        ("trace-buffer", po::value(&args.trace_buffer)->value_name("events"s), "set trace buffer size per thread");
     
     // variables_map хранит значения опций после разбора
     po::variables_map vm;
@@ -111,6 +145,15 @@ struct Args {
     if (vm.contains("randomize-spawn-points"s)) {
         args.randomize_spawn_points = true;
     }
+    if (log_overflow == "drop"sv) {
+        args.log_config.overflow = server_logging::Overflow::Drop;
+    } else if (log_overflow == "sample"sv) {
+        args.log_config.overflow = server_logging::Overflow::Sample;
+    } else {
+        throw std::runtime_error("Unknown log overflow policy: "s + log_overflow);
+    }
+    args.tick_profile_period = std::chrono::milliseconds{ tick_profile_period };
+    args.trace = vm.contains("trace"s);
     // С опциями программы всё в порядке, возвращаем структуру args
     return args;
 }
@@ -130,6 +173,11 @@ int main(int argc, const char* argv[]) {
         return EXIT_FAILURE;
     }
     server_logging::InitBoostLogFilter();
+    if (args.log_config.buffer_records != 0)
+        LOGSRV().StartAsync(args.log_config);
+    TRACER().SetBufferEvents(args.trace_buffer);
+    if (args.trace)
+        TRACER().Enable();
     try {
         // Получаем количество допустимых потоков.
         const unsigned num_threads = std::thread::hardware_concurrency();
@@ -150,39 +198,79 @@ int main(int argc, const char* argv[]) {
             game->SetRandomizeSpawnPoints(args.randomize_spawn_points);
             app.reset(new app::App(*game, app_config));
         }
-        auto conn = game->DoOnTick([&ser_listiner, &app] (std::chrono::milliseconds delta) mutable {
+        // Игроки удаляются координатором на каждом тике, подписчику остаётся сохранение
+        auto conn = game->DoOnTick([&ser_listiner] (std::chrono::milliseconds delta) mutable {
             ser_listiner.OnTick(delta);
-            //
-            app->RetirPlayers(delta);
+        });
+        // После тика новое состояние сессий рассылается WebSocket-подписчикам
+        auto feed = std::make_shared<app::StateFeed>();
+        auto feed_conn = game->DoOnTick([feed] (std::chrono::milliseconds) {
+            feed->Publish();
         });
         // 2. Инициализируем io_context
         net::io_context ioc(num_threads);
-        // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
+        // Профиль тиков: фазы сессий, удаление игроков, подписчики и сохранение
+        auto profiler = std::make_shared<ticker::TickProfiler>(args.tick_period, args.tick_profile_period);
+        ser_listiner.SetSaveObserver([profiler](std::chrono::nanoseconds time) {
+            profiler->RecordSave(time);
+        });
+        // Координатор раздаёт запросы по strand'ам игровых сессий
+        auto coordinator = std::make_shared<app::Coordinator>(ioc, *app, profiler);
+        // Состояние каждой сессии вместе с её игроками и токенами снимается
+        // в её strand, где выполняется и вход в игру
+        ser_listiner.SetSessionsCollector([coordinator, app](auto done) {
+            coordinator->ForEachSession<serialization::SessionStateRepr>(
+                [app](model::GameSession& session) {
+                    return serialization::SessionStateRepr{session, *app};
+                },
+                std::move(done));
+        });
+        // Настраиваем тик всех сессий каждые delta миллисекунд; тик запускается
+        // в strand координатора, сессии обрабатываются в своих strand'ах
+        auto ticker = std::make_shared<ticker::Ticker>(coordinator->GetStrand(), args.tick_period,
+            [coordinator](std::chrono::milliseconds delta) { coordinator->Tick(delta); },
+            profiler
+        );
+        // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM.
+        // Остановка идёт в отдельном потоке: ожидание базы и запись файла
+        // состояния не занимают потоки ввода-вывода
+        std::jthread shutdown;
         net::signal_set signals(ioc, SIGINT, SIGTERM);
-        signals.async_wait([&ioc, &ser_listiner] (const sys::error_code& ec, [[maybe_unused]] int signal_number) {
-            if (!ec) {
-                ser_listiner.Save();
-                LOGSRV().End(ec);
-                ioc.stop();
-            }
+        signals.async_wait([&ioc, &ser_listiner, &shutdown, app, coordinator, ticker]
+                (const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+            if (ec)
+                return;
+            // после остановки тикера игроки больше не уходят и очередь
+            // записи в базу не пополняется
+            ticker->Stop();
+            // тик с обработчиком завершения встаёт в очередь координатора за
+            // идущим тиком: done вызывается, когда тиков больше нет
+            coordinator->Tick(0ms, [&ioc, &ser_listiner, &shutdown, app, ec] {
+                shutdown = std::jthread{[&ioc, &ser_listiner, app, ec] {
+                    // результаты ушедших игроков попадают в базу до записи файла
+                    // состояния, в котором этих игроков уже нет; не записанные
+                    // из-за ошибки базы сохраняются в самом файле
+                    if (!app->FlushRetiredPlayers(RETIRED_PLAYERS_FLUSH_TIMEOUT))
+                        LOGSRV().Msg("Retired players flush"sv, "timeout"sv);
+                    try {
+                        ser_listiner.SaveAndWait();
+                    } catch (const std::exception&) {
+                        // ошибка записи уже в журнале
+                    }
+                    LOGSRV().End(ec);
+                    ioc.stop();
+                }};
+            });
         });
-        // strand, используемый для доступа к API
-        auto api_strand = net::make_strand(ioc);
         // 4. Создаём обработчик HTTP-запросов и связываем его с моделью игры
-        auto handler = std::make_shared<http_handler::RequestHandler>(args.www_root, api_strand, *app, args.on_tick_api);
-        // Настраиваем вызов метода Application::Tick каждые delta миллисекунд внутри strand
-        auto ticker = std::make_shared<ticker::Ticker>(api_strand, args.tick_period,
-            [&game](std::chrono::milliseconds delta) { game->Tick(delta); }
-        );
-        // Настраиваем вызов метода Application::RetirPlayers каждые delta миллисекунд внутри strand
-        auto ticker_retir = std::make_shared<ticker::Ticker>(api_strand, args.tick_period,
-            [app](std::chrono::milliseconds delta) { app->RetirPlayers(delta); }
-        );
+        auto handler = std::make_shared<http_handler::RequestHandler>(args.www_root, coordinator, *app,
+            args.on_tick_api, args.static_cache_limit, GetAdminTokenFromEnv());
+        handler->WatchStaticFiles(ioc);
         // Оборачиваем его в логирующий декоратор
         server_logging::LoggingRequestHandler logging_handler {
-            [handler](auto&& endpoint, auto&& req, auto&& send) {
+            [handler](auto&& target, auto&& req, auto&& send) {
                 // Обрабатываем запрос
-                (*handler)(std::forward<decltype(endpoint)>(endpoint),
+                (*handler)(std::forward<decltype(target)>(target),
                     std::forward<decltype(req)>(req),
                     std::forward<decltype(send)>(send));
             }
@@ -191,7 +279,12 @@ int main(int argc, const char* argv[]) {
         const auto address = net::ip::make_address(ServerParam::ADDR);
         constexpr net::ip::port_type port = ServerParam::PORT;
         // Запускаем обработку запросов
-        http_server::ServerHttp(ioc, { address, port }, logging_handler);
+        http_server::ServerHttp(ioc, { address, port }, logging_handler,
+            [&game_app = *app, feed](auto&& stream, auto&& req, auto&& target) {
+                // подключение к WebSocket-каналу игрока
+                std::make_shared<http_handler::WsSession>(std::move(stream), game_app, *feed)
+                    ->Run(std::move(req), target);
+            });
         ticker->Start();
         // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
         LOGSRV().Start(address.to_string(), port);
@@ -200,7 +293,10 @@ int main(int argc, const char* argv[]) {
             ioc.run();
         });
     } catch (const std::exception& ex) {
+        LOGSRV().StopAsync();
         std::cerr << ex.what() << std::endl;
         return EXIT_FAILURE;
     }
+    // выводим записи, оставшиеся в буферах журнала
+    LOGSRV().StopAsync();
 }
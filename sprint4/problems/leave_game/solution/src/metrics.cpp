@@ -0,0 +1,148 @@
+#include "metrics.h"
+
+#include <cstdio>
+
+namespace metrics {
+using namespace std::literals;
+
+namespace {
+std::string_view EndpointName(size_t index) {
+    using defs::TypeRequest;
+    switch (static_cast<TypeRequest>(index)) {
+    case TypeRequest::None: return "unknown"sv;
+    case TypeRequest::StaticFiles: return "static"sv;
+    case TypeRequest::Maps: return "maps"sv;
+    case TypeRequest::Map: return "map"sv;
+    case TypeRequest::Join: return "join"sv;
+    case TypeRequest::Players: return "players"sv;
+    case TypeRequest::State: return "state"sv;
+    case TypeRequest::Action: return "action"sv;
+    case TypeRequest::Records: return "records"sv;
+    case TypeRequest::BadVersion: return "bad_version"sv;
+    case TypeRequest::Tick: return "tick"sv;
+    case TypeRequest::Metrics: return "metrics"sv;
+    case TypeRequest::TickProfile: return "tick_profile"sv;
+    case TypeRequest::Trace: return "trace"sv;
+    }
+    return "unknown"sv;
+}
+
+// Микросекунды как десятичные секунды без потери точности: 2500 -> 0.0025
+void AppendSeconds(std::string& out, uint64_t micro) {
+    out += std::to_string(micro / 1'000'000);
+    if (auto fraction = micro % 1'000'000) {
+        char buffer[8];
+        std::snprintf(buffer, sizeof(buffer), ".%06u", static_cast<unsigned>(fraction));
+        std::string_view digits{buffer};
+        out += digits.substr(0, digits.find_last_not_of('0') + 1);
+    }
+}
+
+void AppendHeader(std::string& out, std::string_view name, std::string_view type, std::string_view help) {
+    out += "# HELP "sv;
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE "sv;
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+// labels - готовая строка меток без скобок, может быть пустой
+template <typename Snapshot, typename Bounds>
+void AppendHistogram(std::string& out, std::string_view name, std::string_view labels,
+        const Snapshot& snapshot, const Bounds& bounds) {
+    const std::string separator = labels.empty() ? ""s : ","s;
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < snapshot.intervals.size(); ++i) {
+        cumulative += snapshot.intervals[i];
+        out += name;
+        out += "_bucket{"sv;
+        out += labels;
+        out += separator;
+        out += "le=\""sv;
+        if (i < bounds.size())
+            AppendSeconds(out, bounds[i]);
+        else
+            out += "+Inf"sv;
+        out += "\"} "sv;
+        out += std::to_string(cumulative);
+        out += '\n';
+    }
+    const std::string braced = labels.empty() ? ""s : "{"s + std::string(labels) + "}"s;
+    out += name;
+    out += "_sum"sv;
+    out += braced;
+    out += ' ';
+    AppendSeconds(out, snapshot.sum);
+    out += '\n';
+    out += name;
+    out += "_count"sv;
+    out += braced;
+    out += ' ';
+    out += std::to_string(snapshot.count);
+    out += '\n';
+}
+
+void AppendValue(std::string& out, std::string_view name, std::string_view labels, int64_t value) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += std::to_string(value);
+    out += '\n';
+}
+}  // namespace
+
+std::string Registry::Format() const {
+    std::string out;
+    out.reserve(16 * 1024);
+
+    constexpr auto REQUEST_TIME = "game_server_request_duration_seconds"sv;
+    AppendHeader(out, REQUEST_TIME, "histogram"sv,
+        "Time from reading a request to handing the response to the socket"sv);
+    for (size_t endpoint = 0; endpoint < ENDPOINTS; ++endpoint) {
+        for (size_t status = 0; status < STATUSES; ++status) {
+            const auto snapshot = request_time_.Collect(endpoint * STATUSES + status);
+            // ряды без запросов не выводятся
+            if (snapshot.count == 0)
+                continue;
+            std::string labels = "endpoint=\""s + std::string(EndpointName(endpoint)) + "\",code=\""s
+                + (status < STATUS_CODES.size() ? std::to_string(STATUS_CODES[status]) : "other"s) + "\""s;
+            AppendHistogram(out, REQUEST_TIME, labels, snapshot, request_time_.GetBounds());
+        }
+    }
+
+    constexpr auto RECEIVED = "game_server_received_bytes_total"sv;
+    AppendHeader(out, RECEIVED, "counter"sv, "Bytes of HTTP requests read"sv);
+    AppendValue(out, RECEIVED, {}, static_cast<int64_t>(counters_.Value(BYTES_RECEIVED)));
+    constexpr auto SENT = "game_server_sent_bytes_total"sv;
+    AppendHeader(out, SENT, "counter"sv, "Bytes of HTTP responses written"sv);
+    AppendValue(out, SENT, {}, static_cast<int64_t>(counters_.Value(BYTES_SENT)));
+
+    constexpr auto CONNECTIONS_OPEN = "game_server_open_connections"sv;
+    AppendHeader(out, CONNECTIONS_OPEN, "gauge"sv, "Open client connections"sv);
+    AppendValue(out, CONNECTIONS_OPEN, "kind=\"http\""sv,
+        static_cast<int64_t>(counters_.Value(CONNECTIONS + static_cast<size_t>(Connection::Http))));
+    AppendValue(out, CONNECTIONS_OPEN, "kind=\"websocket\""sv,
+        static_cast<int64_t>(counters_.Value(CONNECTIONS + static_cast<size_t>(Connection::WebSocket))));
+
+    constexpr auto QUEUE = "game_server_strand_queue_depth"sv;
+    AppendHeader(out, QUEUE, "gauge"sv, "Requests dispatched to a strand and not started yet"sv);
+    AppendValue(out, QUEUE, "strand=\"coordinator\""sv,
+        static_cast<int64_t>(counters_.Value(STRAND_QUEUE + static_cast<size_t>(Strand::Coordinator))));
+    AppendValue(out, QUEUE, "strand=\"session\""sv,
+        static_cast<int64_t>(counters_.Value(STRAND_QUEUE + static_cast<size_t>(Strand::Session))));
+
+    constexpr auto TICK_TIME = "game_server_tick_duration_seconds"sv;
+    AppendHeader(out, TICK_TIME, "histogram"sv, "Time to tick all game sessions"sv);
+    AppendHistogram(out, TICK_TIME, {}, tick_time_.Collect(0), tick_time_.GetBounds());
+    return out;
+}
+
+}  // namespace metrics
@@ -0,0 +1,184 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "request_handler/defs.h"
+
+#define METRICS() metrics::Registry::GetInstance()
+
+namespace metrics {
+
+// Потоки пишут в свой шард, чтобы не делить кэш-линии с другими потоками.
+// Значение метрики - сумма по шардам, собирается только при выдаче /metrics
+inline constexpr size_t SHARDS = 16;
+
+// Шард текущего потока: потоки получают шарды по кругу при первом обращении
+inline size_t ShardIndex() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local const size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return index;
+}
+
+template <size_t Size>
+struct alignas(64) ShardCells {
+    std::array<std::atomic<uint64_t>, Size> cells{};
+};
+
+// Набор счётчиков, у каждого шарда свои ячейки
+template <size_t Size>
+class CounterSet {
+public:
+    void Add(size_t index, uint64_t value = 1) {
+        shards_[ShardIndex()].cells[index].fetch_add(value, std::memory_order_relaxed);
+    }
+    // для gauge: уменьшение - прибавление дополнения, сумма по шардам верна
+    void Sub(size_t index, uint64_t value = 1) {
+        shards_[ShardIndex()].cells[index].fetch_sub(value, std::memory_order_relaxed);
+    }
+    uint64_t Value(size_t index) const {
+        uint64_t sum = 0;
+        for (const auto& shard : shards_)
+            sum += shard.cells[index].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    std::array<ShardCells<Size>, SHARDS> shards_;
+};
+
+// Гистограммы с общими фиксированными границами для Series рядов.
+// Значения - целые микросекунды; наблюдение - два relaxed fetch_add:
+// ячейка интервала и сумма, число наблюдений - сумма интервалов
+template <size_t Series, size_t Buckets>
+class HistogramSet {
+public:
+    using Bounds = std::array<uint64_t, Buckets>;
+    // последний интервал - +Inf
+    static constexpr size_t INTERVALS = Buckets + 1;
+
+    struct Snapshot {
+        std::array<uint64_t, INTERVALS> intervals{};
+        uint64_t sum = 0;
+        uint64_t count = 0;
+    };
+
+    explicit constexpr HistogramSet(const Bounds& bounds)
+        : bounds_(bounds) {
+    }
+
+    void Observe(size_t series, uint64_t value) {
+        size_t interval = 0;
+        while (interval < Buckets && value > bounds_[interval])
+            ++interval;
+        cells_.Add(series * STRIDE + interval);
+        cells_.Add(series * STRIDE + INTERVALS, value);
+    }
+    Snapshot Collect(size_t series) const {
+        Snapshot snapshot;
+        for (size_t i = 0; i < INTERVALS; ++i) {
+            snapshot.intervals[i] = cells_.Value(series * STRIDE + i);
+            snapshot.count += snapshot.intervals[i];
+        }
+        snapshot.sum = cells_.Value(series * STRIDE + INTERVALS);
+        return snapshot;
+    }
+    const Bounds& GetBounds() const {
+        return bounds_;
+    }
+
+private:
+    // интервалы и сумма одного ряда
+    static constexpr size_t STRIDE = INTERVALS + 1;
+    Bounds bounds_;
+    CounterSet<Series * STRIDE> cells_;
+};
+
+// Метрики сервера в формате Prometheus. Обновление - несколько relaxed
+// атомарных операций в шарде потока, без журнала и блокировок
+class Registry {
+public:
+    // Коды ответа с отдельным рядом, остальные попадают в "other"
+    static constexpr std::array<unsigned, 11> STATUS_CODES{
+        200, 204, 206, 304, 400, 401, 404, 405, 413, 416, 500};
+    static constexpr size_t STATUSES = STATUS_CODES.size() + 1;
+    static constexpr size_t ENDPOINTS = static_cast<size_t>(defs::TypeRequest::Trace) + 1;
+
+    enum class Connection {
+        Http,
+        WebSocket
+    };
+    enum class Strand {
+        Coordinator,
+        Session
+    };
+
+    static Registry& GetInstance() {
+        static Registry obj;
+        return obj;
+    }
+    Registry() = default;
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+    // Время от прочтения запроса до передачи ответа на запись
+    void ObserveRequest(defs::TypeRequest endpoint, unsigned status, std::chrono::microseconds time) {
+        request_time_.Observe(static_cast<size_t>(endpoint) * STATUSES + StatusIndex(status),
+            static_cast<uint64_t>(time.count()));
+    }
+    void AddBytesReceived(uint64_t bytes) {
+        counters_.Add(BYTES_RECEIVED, bytes);
+    }
+    void AddBytesSent(uint64_t bytes) {
+        counters_.Add(BYTES_SENT, bytes);
+    }
+    void ConnectionOpened(Connection kind) {
+        counters_.Add(CONNECTIONS + static_cast<size_t>(kind));
+    }
+    void ConnectionClosed(Connection kind) {
+        counters_.Sub(CONNECTIONS + static_cast<size_t>(kind));
+    }
+    // Задание отправлено в strand и ещё не начало выполняться
+    void StrandQueued(Strand strand) {
+        counters_.Add(STRAND_QUEUE + static_cast<size_t>(strand));
+    }
+    void StrandStarted(Strand strand) {
+        counters_.Sub(STRAND_QUEUE + static_cast<size_t>(strand));
+    }
+    void ObserveTick(std::chrono::microseconds time) {
+        tick_time_.Observe(0, static_cast<uint64_t>(time.count()));
+    }
+
+    // Все метрики в текстовом формате Prometheus 0.0.4
+    std::string Format() const;
+
+    static constexpr size_t StatusIndex(unsigned status) {
+        for (size_t i = 0; i < STATUS_CODES.size(); ++i) {
+            if (STATUS_CODES[i] == status)
+                return i;
+        }
+        return STATUS_CODES.size();
+    }
+
+private:
+    static constexpr size_t BYTES_RECEIVED = 0;
+    static constexpr size_t BYTES_SENT = 1;
+    static constexpr size_t CONNECTIONS = 2;
+    static constexpr size_t STRAND_QUEUE = 4;
+    static constexpr size_t COUNTERS = 6;
+
+    // границы интервалов в микросекундах
+    static constexpr std::array<uint64_t, 13> REQUEST_BOUNDS{
+        100, 250, 500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000, 1'000'000};
+    static constexpr std::array<uint64_t, 11> TICK_BOUNDS{
+        500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000, 1'000'000};
+
+    HistogramSet<ENDPOINTS * STATUSES, REQUEST_BOUNDS.size()> request_time_{REQUEST_BOUNDS};
+    HistogramSet<1, TICK_BOUNDS.size()> tick_time_{TICK_BOUNDS};
+    CounterSet<COUNTERS> counters_;
+};
+
+}  // namespace metrics
@@ -1,8 +1,163 @@
 #include "collision_detector.h"
 #include <cassert>
+#include <cmath>
+#include <stdexcept>
 
 namespace collision_detector {
 
+namespace {
+// Дороги лежат на целочисленной сетке, поэтому единичная ячейка - разумный размер
+constexpr Dimension2D DEFAULT_CELL_SIZE = 1.0;
+// Ограничение на число ячеек: сетка не должна быть сильно больше числа предметов
+constexpr size_t MIN_GRID_CELLS = 16;
+constexpr size_t MAX_CELLS_PER_ITEM = 4;
+// Запас на погрешность вычислений при отсечении ячеек, лишние кандидаты
+// всё равно отсеиваются точной проверкой TryCollectPoint
+constexpr Dimension2D RADIUS_EPSILON = 1e-9;
+
+bool IsStanding(const Gatherer& gatherer) {
+    return gatherer.start_pos.x == gatherer.end_pos.x &&
+        gatherer.start_pos.y == gatherer.end_pos.y;
+}
+
+void SortByTime(std::vector<GatheringEvent>& events) {
+    // Устойчивая сортировка сохраняет порядок (gatherer_id, item_id) при равном time
+    std::stable_sort(events.begin(), events.end(),
+              [](const GatheringEvent& e_l, const GatheringEvent& e_r) {
+                  return e_l.time < e_r.time;
+              });
+}
+
+void TryGather(const Gatherer& gatherer, size_t gatherer_id, const Item& item,
+        size_t item_id, std::vector<GatheringEvent>& events) {
+    auto collect_result
+        = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
+
+    if (collect_result.IsCollected(gatherer.width + item.width)) {
+        GatheringEvent evt{.item_id = item_id,
+                           .gatherer_id = gatherer_id,
+                           .sq_distance = collect_result.sq_distance,
+                           .time = collect_result.proj_ratio};
+        events.push_back(evt);
+    }
+}
+
+// Равномерная сетка предметов в CSR-раскладке: предметы ячейки (x, y) лежат в
+// item_ids_[cell_begin_[y * nx_ + x] .. cell_begin_[y * nx_ + x + 1])
+// в порядке возрастания индекса
+class ItemGrid {
+public:
+    ItemGrid(std::vector<Item> items, Dimension2D cell_size)
+        : items_(std::move(items))
+        , cell_size_(cell_size) {
+        if (items_.empty())
+            return;
+        auto [min_x, max_x] = std::minmax_element(items_.begin(), items_.end(),
+            [](const Item& l, const Item& r) { return l.position.x < r.position.x; });
+        auto [min_y, max_y] = std::minmax_element(items_.begin(), items_.end(),
+            [](const Item& l, const Item& r) { return l.position.y < r.position.y; });
+        origin_ = { min_x->position.x, min_y->position.y };
+        const Dimension2D width = max_x->position.x - min_x->position.x;
+        const Dimension2D height = max_y->position.y - min_y->position.y;
+        const size_t max_cells = std::max(MIN_GRID_CELLS, items_.size() * MAX_CELLS_PER_ITEM);
+        for (;;) {
+            const Dimension2D nx = std::floor(width / cell_size_) + 1;
+            const Dimension2D ny = std::floor(height / cell_size_) + 1;
+            if (nx * ny <= static_cast<Dimension2D>(max_cells)) {
+                nx_ = static_cast<size_t>(nx);
+                ny_ = static_cast<size_t>(ny);
+                break;
+            }
+            cell_size_ *= 2;
+        }
+        for (const auto& item : items_)
+            max_item_width_ = std::max(max_item_width_, item.width);
+
+        std::vector<size_t> item_cell(items_.size());
+        cell_begin_.assign(nx_ * ny_ + 1, 0);
+        for (size_t i = 0; i < items_.size(); ++i) {
+            const auto& pos = items_[i].position;
+            size_t x = std::min(static_cast<size_t>((pos.x - origin_.x) / cell_size_), nx_ - 1);
+            size_t y = std::min(static_cast<size_t>((pos.y - origin_.y) / cell_size_), ny_ - 1);
+            item_cell[i] = y * nx_ + x;
+            ++cell_begin_[item_cell[i] + 1];
+        }
+        for (size_t c = 1; c < cell_begin_.size(); ++c)
+            cell_begin_[c] += cell_begin_[c - 1];
+        item_ids_.resize(items_.size());
+        std::vector<size_t> fill(cell_begin_.begin(), cell_begin_.end() - 1);
+        for (size_t i = 0; i < items_.size(); ++i)
+            item_ids_[fill[item_cell[i]]++] = i;
+    }
+
+    const Item& GetItem(size_t idx) const {
+        return items_[idx];
+    }
+
+    // Вызывает fn для каждого предмета из ячеек, которые задевает отрезок собирателя,
+    // расширенный на его ширину и ширину самого широкого предмета. Отрезок
+    // обходится по строкам сетки: в строке берутся только столбцы, над которыми
+    // проходит часть отрезка, попадающая в полосу этой строки
+    template <typename Fn>
+    void ForEachCandidate(const Gatherer& gatherer, Fn&& fn) const {
+        if (items_.empty())
+            return;
+        const Dimension2D radius = (gatherer.width + max_item_width_) * (1 + RADIUS_EPSILON)
+            + RADIUS_EPSILON;
+        const auto a = gatherer.start_pos;
+        const Dimension2D dx = gatherer.end_pos.x - a.x;
+        const Dimension2D dy = gatherer.end_pos.y - a.y;
+        auto [row_first, row_last] = CellRange(std::min(a.y, a.y + dy) - radius,
+            std::max(a.y, a.y + dy) + radius, origin_.y, ny_);
+        for (size_t row = row_first; row < row_last; ++row) {
+            const Dimension2D band_lo = origin_.y + static_cast<Dimension2D>(row) * cell_size_ - radius;
+            const Dimension2D band_hi = band_lo + cell_size_ + 2 * radius;
+            Dimension2D t0 = 0.0, t1 = 1.0;
+            if (dy != 0.0) {
+                t0 = (band_lo - a.y) / dy;
+                t1 = (band_hi - a.y) / dy;
+                if (t0 > t1)
+                    std::swap(t0, t1);
+                t0 = std::max(t0, 0.0);
+                t1 = std::min(t1, 1.0);
+                if (t0 > t1)
+                    continue;
+            }
+            const Dimension2D x0 = a.x + t0 * dx;
+            const Dimension2D x1 = a.x + t1 * dx;
+            auto [col_first, col_last] = CellRange(std::min(x0, x1) - radius,
+                std::max(x0, x1) + radius, origin_.x, nx_);
+            for (size_t cell = row * nx_ + col_first; cell < row * nx_ + col_last; ++cell) {
+                for (size_t k = cell_begin_[cell]; k < cell_begin_[cell + 1]; ++k)
+                    fn(item_ids_[k]);
+            }
+        }
+    }
+
+private:
+    std::vector<Item> items_;
+    Dimension2D cell_size_;
+    geom::Point2D origin_;
+    size_t nx_ = 0;
+    size_t ny_ = 0;
+    Dimension2D max_item_width_ = 0.0;
+    std::vector<size_t> cell_begin_;
+    std::vector<size_t> item_ids_;
+
+    // Полуинтервал [first, last) ячеек, покрывающих отрезок [lo, hi] по одной оси
+    std::pair<size_t, size_t> CellRange(Dimension2D lo, Dimension2D hi,
+            Dimension2D origin, size_t cells) const {
+        const Dimension2D first = std::floor((lo - origin) / cell_size_);
+        const Dimension2D last = std::floor((hi - origin) / cell_size_);
+        if (last < 0.0 || first >= static_cast<Dimension2D>(cells))
+            return { 0, 0 };
+        return { static_cast<size_t>(std::max(first, 0.0)),
+            static_cast<size_t>(std::min(last, static_cast<Dimension2D>(cells - 1))) + 1 };
+    }
+};
+
+}  // namespace
+
 CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c) {
     // Проверим, что перемещение ненулевое.
     // Тут приходится использовать строгое равенство, а не приближённое,
@@ -22,40 +177,57 @@ CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D
     return CollectionResult(sq_distance, proj_ratio);
 }
 
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
+    return FindGatherEvents(provider, DEFAULT_CELL_SIZE);
+}
+
 std::vector<GatheringEvent> FindGatherEvents(
-    const ItemGathererProvider& provider) {
+    const ItemGathererProvider& provider, Dimension2D cell_size) {
+    if (!(cell_size > 0.0))
+        throw std::invalid_argument("Grid cell size must be positive");
     std::vector<GatheringEvent> detected_events;
+    std::vector<Item> items;
+    items.reserve(provider.ItemsCount());
+    for (size_t i = 0; i < provider.ItemsCount(); ++i) {
+        items.push_back(provider.GetItem(i));
+    }
+    const ItemGrid grid{std::move(items), cell_size};
 
-    static auto eq_pt = [](geom::Point2D p1, geom::Point2D p2) {
-        return p1.x == p2.x && p1.y == p2.y;
-    };
-
+    std::vector<size_t> candidates;
     for (size_t g = 0; g < provider.GatherersCount(); ++g) {
         Gatherer gatherer = provider.GetGatherer(g);
-        if (eq_pt(gatherer.start_pos, gatherer.end_pos)) {
+        if (IsStanding(gatherer)) {
             continue;
         }
-        for (size_t i = 0; i < provider.ItemsCount(); ++i) {
-            Item item = provider.GetItem(i);
-            auto collect_result
-                = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
-
-            if (collect_result.IsCollected(gatherer.width + item.width)) {
-                GatheringEvent evt{.item_id = i,
-                                   .gatherer_id = g,
-                                   .sq_distance = collect_result.sq_distance,
-                                   .time = collect_result.proj_ratio};
-                detected_events.push_back(evt);
-            }
+        candidates.clear();
+        grid.ForEachCandidate(gatherer, [&candidates](size_t item_id) {
+            candidates.push_back(item_id);
+        });
+        // Внутри собирателя события идут по возрастанию item_id, как в полном переборе
+        std::sort(candidates.begin(), candidates.end());
+        for (size_t i : candidates) {
+            TryGather(gatherer, g, grid.GetItem(i), i, detected_events);
         }
     }
+    SortByTime(detected_events);
+    return detected_events;
+}
 
-    std::sort(detected_events.begin(), detected_events.end(),
-              [](const GatheringEvent& e_l, const GatheringEvent& e_r) {
-                  return e_l.time < e_r.time;
-              });
+std::vector<GatheringEvent> FindGatherEventsBruteForce(
+    const ItemGathererProvider& provider) {
+    std::vector<GatheringEvent> detected_events;
 
+    for (size_t g = 0; g < provider.GatherersCount(); ++g) {
+        Gatherer gatherer = provider.GetGatherer(g);
+        if (IsStanding(gatherer)) {
+            continue;
+        }
+        for (size_t i = 0; i < provider.ItemsCount(); ++i) {
+            TryGather(gatherer, g, provider.GetItem(i), i, detected_events);
+        }
+    }
+    SortByTime(detected_events);
     return detected_events;
 }
 
-}  // namespace collision_detector
\ No newline at end of file
+}  // namespace collision_detector
@@ -82,6 +82,16 @@ struct GatheringEvent {
     double time;
 };
 
+// Ищет события сбора предметов. Предметы раскладываются по ячейкам равномерной
+// сетки, и каждый собиратель проверяет только предметы из ячеек, которые пересекает
+// его отрезок перемещения (с учётом ширины). Результат совпадает с
+// FindGatherEventsBruteForce: события упорядочены по time, при равном time -
+// по gatherer_id, затем по item_id.
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
+// То же с явно заданным размером ячейки сетки
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider,
+    Dimension2D cell_size);
+// Эталонная реализация: проверяет каждого собирателя с каждым предметом
+std::vector<GatheringEvent> FindGatherEventsBruteForce(const ItemGathererProvider& provider);
 
 }  // namespace collision_detector
@@ -6,9 +6,8 @@ geom::Speed2D model::Dog::zero_speed_ = geom::Speed2D{0.0, 0.0};
 namespace model {
 using namespace std::literals;
 
-std::string Dog::GetDirection() const
-{
-    switch (dir_) {
+std::string DirectionToString(Direction dir) {
+    switch (dir) {
     case Direction::NORTH:
         return "U";
     case Direction::EAST:
@@ -21,32 +20,49 @@ std::string Dog::GetDirection() const
     return "U";
 }
 
-void Dog::Diraction(Move move, Dimension2D speed) {
+void ApplyMove(Move move, Dimension2D speed, Speed2D& dog_speed, Direction& dir) {
     static constexpr double dzero = 0.0; 
     static constexpr double invert = -1.0; 
     switch (move) {
     case Move::LEFT:
-        speed_ = { invert*speed, dzero };
-        dir_ = Direction::WEST;
+        dog_speed = { invert*speed, dzero };
+        dir = Direction::WEST;
         break;
     case Move::RIGHT:
-        speed_ = { speed, dzero };
-        dir_ = Direction::EAST;
+        dog_speed = { speed, dzero };
+        dir = Direction::EAST;
         break;
     case Move::UP:
-        speed_ = { dzero, invert*speed };
-        dir_ = Direction::NORTH;
+        dog_speed = { dzero, invert*speed };
+        dir = Direction::NORTH;
         break;
     case Move::DOWN:
-        speed_ = { dzero, speed };
-        dir_ = Direction::SOUTH;
+        dog_speed = { dzero, speed };
+        dir = Direction::SOUTH;
         break;
     case Move::STAND:
-        speed_ = zero_speed_;
+        dog_speed = {};
         break;
     }
 }
 
+Score LootsScore(const Loots& loots, const LootsParam& loots_param) {
+    Score score = 0;
+    for (const auto& loot : loots) {
+        score += loots_param[loot.type];
+    }
+    return score;
+}
+
+std::string Dog::GetDirection() const
+{
+    return DirectionToString(dir_);
+}
+
+void Dog::Diraction(Move move, Dimension2D speed) {
+    ApplyMove(move, speed, speed_, dir_);
+}
+
 Point2D Dog::GetEndPoint(std::chrono::milliseconds move_time_ms)
 {
     auto msChronoToDoubleSec = [] (auto ms) {
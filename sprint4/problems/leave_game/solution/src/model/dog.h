@@ -10,6 +10,7 @@
 #include <chrono>
 #include "../util/tagged_uuid.h"
 #include "geom.h"
+#include "loots.h"
 
 namespace model {
 using namespace geom;
@@ -18,7 +19,6 @@ using milliseconds = std::chrono::milliseconds;
 using LootParam = int;
 using LootsParam = std::vector<LootParam>;
 using Score = unsigned;
-using LostObjectType = unsigned;
 
 enum class Move {
     LEFT,
@@ -35,16 +35,11 @@ enum class Direction {
     EAST
 };
 
-struct Loot {
-    using Id = util::Tagged<uint32_t, Loot>;
-
-    Id id{ 0u };
-    LostObjectType type{ 0u };
-    Point2D pos;
-
-    [[nodiscard]] auto operator<=>(const Loot&) const = default;
-};
-using Loots = std::list<Loot>;
+// Общие для Dog и DogStore правила: направление в текстовом виде,
+// скорость и направление после команды движения, очки за рюкзак
+std::string DirectionToString(Direction dir);
+void ApplyMove(Move move, Dimension2D speed, Speed2D& dog_speed, Direction& dir);
+Score LootsScore(const Loots& loots, const LootsParam& loots_param);
 
 class Dog {
 public:
@@ -85,16 +80,17 @@ public:
     void Stop() {
         speed_ = zero_speed_;
     }
-    void PutTheLoot(Loots &session_loots, auto it_loot) {
-        loots_.splice(loots_.end(), session_loots, it_loot);
+    void PutTheLoot(Loots &session_loots, Loots::Handle loot) {
+        session_loots.MoveTo(loot, loots_);
+    }
+    void SetLoots(const Loots& loots) {
+        loots_ = loots;
     }
     const Loots& GetLoots() const {
         return loots_;
     }
     void LootsReturn(const LootsParam& loots_param) {
-        for (const auto& loot : loots_) {
-            score_ += loots_param[loot.type];
-        }
+        score_ += LootsScore(loots_, loots_param);
         return loots_.clear();
     }
     Score GetScore() const {
@@ -0,0 +1,135 @@
+#include "dog_store.h"
+
+#include <stdexcept>
+
+namespace model {
+using namespace std::literals;
+
+const Dog::Id& DogView::GetId() const {
+    return store_->ids_[slot_];
+}
+
+const std::string& DogView::GetName() const {
+    return store_->names_[slot_];
+}
+
+const Point2D& DogView::GetPoint() const {
+    return store_->pos_[slot_];
+}
+
+const Point2D& DogView::GetPrevPoint() const {
+    return store_->prev_pos_[slot_];
+}
+
+const Speed2D& DogView::GetSpeed() const {
+    return store_->speed_[slot_];
+}
+
+std::string DogView::GetDirection() const {
+    return DirectionToString(store_->dir_[slot_]);
+}
+
+Direction DogView::GetDir() const {
+    return store_->dir_[slot_];
+}
+
+const Loots& DogView::GetLoots() const {
+    return store_->bags_[slot_];
+}
+
+Score DogView::GetScore() const {
+    return store_->score_[slot_];
+}
+
+milliseconds DogView::GetStayTime() const {
+    return store_->lifetime_[slot_] - store_->last_move_time_[slot_];
+}
+
+milliseconds DogView::GetLifetime() const {
+    return store_->lifetime_[slot_];
+}
+
+Dog DogView::ToDog() const {
+    Dog dog{GetId(), GetName(), GetPoint()};
+    dog.SetSpeed(GetSpeed());
+    dog.SetDirection(GetDir());
+    dog.AddScore(GetScore());
+    dog.SetLifeTime(GetLifetime());
+    dog.SetLastMoveTime(store_->last_move_time_[slot_]);
+    dog.SetLoots(GetLoots());
+    return dog;
+}
+
+std::optional<size_t> DogStore::FindSlot(const Dog::Id& id) const {
+    if (auto it = id_to_slot_.find(id); it != id_to_slot_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<DogView> DogStore::Find(const Dog::Id& id) const {
+    if (auto slot = FindSlot(id)) {
+        return DogView{*this, *slot};
+    }
+    return std::nullopt;
+}
+
+size_t DogStore::Add(Dog&& dog) {
+    const size_t slot = ids_.size();
+    if (auto [it, inserted] = id_to_slot_.emplace(dog.GetId(), slot); !inserted) {
+        throw std::invalid_argument("Dog with id "s + std::to_string(*dog.GetId()) + " already exists"s);
+    }
+    ids_.push_back(dog.GetId());
+    pos_.push_back(dog.GetPoint());
+    prev_pos_.push_back(dog.GetPrevPoint());
+    speed_.push_back(dog.GetSpeed());
+    dir_.push_back(dog.GetDir());
+    lifetime_.push_back(dog.GetLifetime());
+    last_move_time_.push_back(dog.GetLifetime() - dog.GetStayTime());
+    score_.push_back(dog.GetScore());
+    names_.push_back(dog.GetName());
+    bags_.push_back(dog.GetLoots());
+    return slot;
+}
+
+template <typename Fn>
+void DogStore::ForEachColumn(Fn&& fn) {
+    fn(ids_);
+    fn(pos_);
+    fn(prev_pos_);
+    fn(speed_);
+    fn(dir_);
+    fn(lifetime_);
+    fn(last_move_time_);
+    fn(score_);
+    fn(names_);
+    fn(bags_);
+}
+
+void DogStore::Erase(const Dog::Id& id) {
+    auto it = id_to_slot_.find(id);
+    if (it == id_to_slot_.end())
+        return;
+    const size_t slot = it->second;
+    const size_t last = ids_.size() - 1;
+    id_to_slot_.erase(it);
+    if (slot != last) {
+        id_to_slot_[ids_[last]] = slot;
+    }
+    ForEachColumn([slot, last](auto& column) {
+        if (slot != last)
+            column[slot] = std::move(column[last]);
+        column.pop_back();
+    });
+}
+
+void DogStore::SetMove(size_t slot, Move move, Dimension2D speed) {
+    ApplyMove(move, speed, speed_[slot], dir_[slot]);
+}
+
+void DogStore::ReturnLoots(size_t slot, const LootsParam& loots_param) {
+    score_[slot] += LootsScore(bags_[slot], loots_param);
+    bags_[slot].clear();
+}
+
+}  // namespace model
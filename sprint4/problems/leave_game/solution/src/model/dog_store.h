@@ -0,0 +1,138 @@
+#pragma once
+#include "../sdk.h"
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "dog.h"
+
+namespace model {
+
+class DogStore;
+
+// Лёгкое представление собаки, хранящейся в DogStore.
+// Действительно до ближайшего удаления собаки из хранилища.
+class DogView {
+public:
+    DogView(const DogStore& store, size_t slot) noexcept
+        : store_(&store), slot_(slot) {
+    }
+    size_t GetSlot() const noexcept {
+        return slot_;
+    }
+    const Dog::Id& GetId() const;
+    const std::string& GetName() const;
+    const Point2D& GetPoint() const;
+    const Point2D& GetPrevPoint() const;
+    const Speed2D& GetSpeed() const;
+    std::string GetDirection() const;
+    Direction GetDir() const;
+    const Loots& GetLoots() const;
+    Score GetScore() const;
+    milliseconds GetStayTime() const;
+    milliseconds GetLifetime() const;
+    // Собирает полноценный объект Dog (для сериализации)
+    Dog ToDog() const;
+
+private:
+    const DogStore* store_;
+    size_t slot_;
+};
+
+// Плотное хранилище собак игровой сессии в виде структуры массивов.
+// Горячие данные, которые нужны на каждом тике (координаты, скорость,
+// время жизни, очки), лежат в отдельных непрерывных массивах, индексируемых
+// слотом. Имена и рюкзаки - в побочных таблицах с тем же индексом.
+// При удалении последняя собака переезжает в освободившийся слот, поэтому
+// снаружи собаку следует адресовать по Dog::Id, а не по слоту.
+class DogStore {
+    using DogsIdHasher = util::TaggedHasher<Dog::Id>;
+public:
+    class Iterator {
+    public:
+        Iterator(const DogStore& store, size_t slot) noexcept
+            : store_(&store), slot_(slot) {
+        }
+        DogView operator*() const noexcept {
+            return DogView{*store_, slot_};
+        }
+        Iterator& operator++() noexcept {
+            ++slot_;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const noexcept = default;
+    private:
+        const DogStore* store_;
+        size_t slot_;
+    };
+
+    size_t size() const noexcept {
+        return ids_.size();
+    }
+    bool empty() const noexcept {
+        return ids_.empty();
+    }
+    Iterator begin() const noexcept {
+        return Iterator{*this, 0};
+    }
+    Iterator end() const noexcept {
+        return Iterator{*this, size()};
+    }
+
+    bool Contains(const Dog::Id& id) const {
+        return id_to_slot_.contains(id);
+    }
+    std::optional<size_t> FindSlot(const Dog::Id& id) const;
+    std::optional<DogView> Find(const Dog::Id& id) const;
+    size_t Add(Dog&& dog);
+    void Erase(const Dog::Id& id);
+    void SetMove(size_t slot, Move move, Dimension2D speed);
+    // Сдаёт содержимое рюкзака на базу, начисляя очки
+    void ReturnLoots(size_t slot, const LootsParam& loots_param);
+
+    // Непрерывные массивы для потоковой обработки на тике
+    std::span<const Dog::Id> Ids() const noexcept {
+        return ids_;
+    }
+    std::span<Point2D> Positions() noexcept {
+        return pos_;
+    }
+    std::span<Point2D> PrevPositions() noexcept {
+        return prev_pos_;
+    }
+    std::span<Speed2D> Speeds() noexcept {
+        return speed_;
+    }
+    std::span<milliseconds> Lifetimes() noexcept {
+        return lifetime_;
+    }
+    std::span<milliseconds> LastMoveTimes() noexcept {
+        return last_move_time_;
+    }
+    Loots& Bag(size_t slot) {
+        return bags_[slot];
+    }
+
+private:
+    friend class DogView;
+
+    std::vector<Dog::Id> ids_;
+    std::vector<Point2D> pos_;
+    std::vector<Point2D> prev_pos_;
+    std::vector<Speed2D> speed_;
+    std::vector<Direction> dir_;
+    std::vector<milliseconds> lifetime_;
+    std::vector<milliseconds> last_move_time_;
+    std::vector<Score> score_;
+    // холодные данные
+    std::vector<std::string> names_;
+    std::vector<Loots> bags_;
+    std::unordered_map<Dog::Id, size_t, DogsIdHasher> id_to_slot_;
+
+    template <typename Fn>
+    void ForEachColumn(Fn&& fn);
+};
+
+}  // namespace model
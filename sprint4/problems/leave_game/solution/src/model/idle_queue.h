@@ -0,0 +1,66 @@
+#pragma once
+#include "../sdk.h"
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <vector>
+#include "dog.h"
+
+namespace model {
+
+// Очередь собак по времени начала простоя (min-heap). Время - время сессии.
+// Движение собаки очередь не трогает: при извлечении запись сверяется с
+// актуальным временем простоя и, если собака двигалась, возвращается в очередь
+// с новым временем. Поэтому Take стоит O(k log n), где k - число извлечённых
+// записей, а не число собак
+class IdleQueue {
+public:
+    // since - время сессии, с которого собака стоит
+    void Push(const Dog::Id& dog_id, milliseconds since) {
+        heap_.push_back(Entry{since, dog_id});
+        std::push_heap(heap_.begin(), heap_.end(), Later{});
+    }
+    void Clear() noexcept {
+        heap_.clear();
+    }
+    size_t size() const noexcept {
+        return heap_.size();
+    }
+
+    // Извлекает собак, стоящих с момента не позже deadline.
+    // idle_since(dog_id) -> std::optional<milliseconds> - актуальное время
+    // начала простоя, nullopt - собаки больше нет. Извлечённые собаки
+    // покидают очередь: вызывающий удаляет их или возвращает через Push
+    template <typename IdleSince>
+    std::vector<Dog::Id> Take(milliseconds deadline, IdleSince&& idle_since) {
+        std::vector<Dog::Id> idle;
+        while (!heap_.empty() && heap_.front().since <= deadline) {
+            std::pop_heap(heap_.begin(), heap_.end(), Later{});
+            const auto dog_id = heap_.back().dog_id;
+            heap_.pop_back();
+            const std::optional<milliseconds> since = idle_since(dog_id);
+            if (!since)
+                continue;
+            if (*since <= deadline)
+                idle.push_back(dog_id);
+            else
+                Push(dog_id, *since);
+        }
+        return idle;
+    }
+
+private:
+    struct Entry {
+        milliseconds since;
+        Dog::Id dog_id;
+    };
+    struct Later {
+        bool operator()(const Entry& lhs, const Entry& rhs) const noexcept {
+            return lhs.since > rhs.since;
+        }
+    };
+
+    std::vector<Entry> heap_;
+};
+
+}  // namespace model
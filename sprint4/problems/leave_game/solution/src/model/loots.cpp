@@ -0,0 +1,91 @@
+#include "loots.h"
+
+#include <stdexcept>
+
+namespace model {
+
+Loots::Loots(std::initializer_list<Loot> loots) {
+    reserve(loots.size());
+    for (const auto& loot : loots) {
+        Insert(loot);
+    }
+}
+
+void Loots::reserve(size_t count) {
+    dense_.reserve(count);
+    dense_to_slot_.reserve(count);
+    slots_.reserve(count);
+}
+
+Loots::Handle Loots::Insert(Loot loot) {
+    uint32_t slot = free_head_;
+    if (slot != NO_SLOT) {
+        free_head_ = slots_[slot].dense_index;
+    } else {
+        if (slots_.size() >= NO_SLOT)
+            throw std::length_error("Too many loots");
+        slot = static_cast<uint32_t>(slots_.size());
+        slots_.emplace_back();
+    }
+    slots_[slot].dense_index = static_cast<uint32_t>(dense_.size());
+    dense_.push_back(std::move(loot));
+    dense_to_slot_.push_back(slot);
+    return Handle{ slot, slots_[slot].generation };
+}
+
+bool Loots::Contains(Handle handle) const noexcept {
+    return handle.index < slots_.size()
+        && slots_[handle.index].generation == handle.generation
+        && slots_[handle.index].dense_index < dense_.size()
+        && dense_to_slot_[slots_[handle.index].dense_index] == handle.index;
+}
+
+const Loot* Loots::Find(Handle handle) const noexcept {
+    if (!Contains(handle))
+        return nullptr;
+    return &dense_[slots_[handle.index].dense_index];
+}
+
+std::optional<Loot> Loots::Extract(Handle handle) {
+    if (!Contains(handle))
+        return std::nullopt;
+    const uint32_t pos = slots_[handle.index].dense_index;
+    const uint32_t last = static_cast<uint32_t>(dense_.size() - 1);
+    Loot loot = std::move(dense_[pos]);
+    if (pos != last) {
+        dense_[pos] = std::move(dense_[last]);
+        dense_to_slot_[pos] = dense_to_slot_[last];
+        slots_[dense_to_slot_[pos]].dense_index = pos;
+    }
+    dense_.pop_back();
+    dense_to_slot_.pop_back();
+    ReleaseSlot(handle.index);
+    return loot;
+}
+
+bool Loots::Erase(Handle handle) {
+    return Extract(handle).has_value();
+}
+
+std::optional<Loots::Handle> Loots::MoveTo(Handle handle, Loots& dst) {
+    if (auto loot = Extract(handle)) {
+        return dst.Insert(std::move(*loot));
+    }
+    return std::nullopt;
+}
+
+void Loots::clear() {
+    for (uint32_t slot : dense_to_slot_) {
+        ReleaseSlot(slot);
+    }
+    dense_.clear();
+    dense_to_slot_.clear();
+}
+
+void Loots::ReleaseSlot(uint32_t slot) {
+    ++slots_[slot].generation;
+    slots_[slot].dense_index = free_head_;
+    free_head_ = slot;
+}
+
+}  // namespace model
@@ -0,0 +1,98 @@
+#pragma once
+#include "../sdk.h"
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+#include "../util/tagged_uuid.h"
+#include "geom.h"
+
+namespace model {
+using namespace geom;
+
+using LostObjectType = unsigned;
+
+struct Loot {
+    using Id = util::Tagged<uint32_t, Loot>;
+
+    Id id{ 0u };
+    LostObjectType type{ 0u };
+    Point2D pos;
+
+    [[nodiscard]] auto operator<=>(const Loot&) const = default;
+};
+
+// Хранилище трофеев - слот-карта с поколениями.
+// Трофеи лежат плотно в одном массиве (быстрый обход при поиске столкновений),
+// а адресуются через Handle: индекс слота и его поколение. При удалении на
+// место трофея переезжает последний, слот уходит в список свободных, а его
+// поколение увеличивается - старые Handle на этот слот становятся недействительными.
+// Вставка, удаление и перенос в другое хранилище (с карты в рюкзак) - O(1).
+class Loots {
+public:
+    struct Handle {
+        uint32_t index = NO_SLOT;
+        uint32_t generation = 0;
+
+        [[nodiscard]] auto operator<=>(const Handle&) const = default;
+    };
+    using const_iterator = std::vector<Loot>::const_iterator;
+
+    Loots() = default;
+    Loots(std::initializer_list<Loot> loots);
+
+    size_t size() const noexcept {
+        return dense_.size();
+    }
+    bool empty() const noexcept {
+        return dense_.empty();
+    }
+    const_iterator begin() const noexcept {
+        return dense_.begin();
+    }
+    const_iterator end() const noexcept {
+        return dense_.end();
+    }
+    const Loot& operator[](size_t dense_index) const {
+        return dense_[dense_index];
+    }
+    // Handle трофея, лежащего в плотном массиве на позиции dense_index
+    Handle HandleAt(size_t dense_index) const {
+        const uint32_t slot = dense_to_slot_[dense_index];
+        return Handle{ slot, slots_[slot].generation };
+    }
+
+    void reserve(size_t count);
+    Handle Insert(Loot loot);
+    bool Contains(Handle handle) const noexcept;
+    const Loot* Find(Handle handle) const noexcept;
+    std::optional<Loot> Extract(Handle handle);
+    bool Erase(Handle handle);
+    // Переносит трофей в другое хранилище. Возвращает Handle трофея в dst
+    // или std::nullopt, если handle уже недействителен
+    std::optional<Handle> MoveTo(Handle handle, Loots& dst);
+    void clear();
+
+    // Сравнение по содержимому в порядке обхода, слоты и поколения не учитываются
+    bool operator==(const Loots& other) const {
+        return dense_ == other.dense_;
+    }
+
+private:
+    static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        // для занятого слота - позиция в dense_, для свободного - следующий свободный слот
+        uint32_t dense_index = NO_SLOT;
+        uint32_t generation = 0;
+    };
+
+    std::vector<Loot> dense_;
+    std::vector<uint32_t> dense_to_slot_;
+    std::vector<Slot> slots_;
+    uint32_t free_head_ = NO_SLOT;
+
+    void ReleaseSlot(uint32_t slot);
+};
+
+}  // namespace model
@@ -4,9 +4,12 @@
 #include <boost/multiprecision/cpp_int.hpp>
 #include <ctime>
 #include <random>
+#include <future>
+#include <unordered_set>
 
 #include "model.h"
 #include "collision_detector.h"
+#include "../util/trace.h"
 
 #define MAX_ROADS_TO_FOUND 1000
 
@@ -39,6 +42,8 @@ void Game::AddMap(const Map &map) {
     } else {
         try {
             maps_.emplace_back(std::move(map));
+            // indexes hold pointers into maps_, rebuild them after loading
+            map_indexes_.clear();
         } catch (...) {
             map_id_to_index_.erase(it);
             throw std::bad_alloc(); // "failed to allocate memory for Map"
@@ -53,7 +58,36 @@ const Map* Game::FindMap(const Map::Id& id) const noexcept {
     return nullptr;
 }
 
+void Game::BuildMapIndexes() {
+    std::vector<std::future<std::shared_ptr<const MapIndex>>> builds;
+    builds.reserve(maps_.size());
+    for (const auto& map : maps_) {
+        builds.push_back(std::async(std::launch::async, [&map] {
+            return std::make_shared<const MapIndex>(map);
+        }));
+    }
+    std::vector<std::shared_ptr<const MapIndex>> map_indexes;
+    map_indexes.reserve(builds.size());
+    for (auto& build : builds) {
+        map_indexes.push_back(build.get());
+    }
+    map_indexes_ = std::move(map_indexes);
+}
+
+std::shared_ptr<const MapIndex> Game::FindMapIndex(const Map::Id& id) const noexcept {
+    if (auto it = map_id_to_index_.find(id);
+        it != map_id_to_index_.end() && it->second < map_indexes_.size()) {
+        return map_indexes_[it->second];
+    }
+    return nullptr;
+}
+
 GameSession* Game::FindGameSession(const Map::Id& id) noexcept {
+    std::lock_guard lock{sessions_mutex_};
+    return FindGameSessionLocked(id);
+}
+
+GameSession* Game::FindGameSessionLocked(const Map::Id& id) noexcept {
     if (auto it = map_id_to_game_sessions_index_.find(id);
         it != map_id_to_game_sessions_index_.end()) {
         return &game_sessions_.at(it->second);
@@ -62,10 +96,32 @@ GameSession* Game::FindGameSession(const Map::Id& id) noexcept {
 }
 
 GameSession* Game::AddGameSession(const Map::Id& id) {
-    auto map = FindMap(id);
-    if (map == nullptr)
+    std::lock_guard lock{sessions_mutex_};
+    return AddGameSessionLocked(id);
+}
+
+GameSession* Game::FindOrAddGameSession(const Map::Id& id) {
+    std::lock_guard lock{sessions_mutex_};
+    if (auto session = FindGameSessionLocked(id))
+        return session;
+    return AddGameSessionLocked(id);
+}
+
+std::vector<GameSession*> Game::GetGameSessionList() {
+    std::lock_guard lock{sessions_mutex_};
+    std::vector<GameSession*> sessions;
+    sessions.reserve(game_sessions_.size());
+    for (auto& session : game_sessions_)
+        sessions.push_back(&session);
+    return sessions;
+}
+
+GameSession* Game::AddGameSessionLocked(const Map::Id& id) {
+    if (FindMap(id) == nullptr)
         throw std::invalid_argument("Bad id, map not found");
-    GameSession gs{ map , randomize_spawn_points_, 
+    if (map_indexes_.size() != maps_.size())
+        BuildMapIndexes();
+    GameSession gs{ FindMapIndex(id), randomize_spawn_points_, 
         GetLootGeneratorConfig()};
     const size_t index = game_sessions_.size();
     game_sessions_.emplace_back(std::move(gs));
@@ -80,6 +136,101 @@ GameSession* Game::AddGameSession(const Map::Id& id) {
     return &game_sessions_.back();
 }
 
+RoadIndex::RoadIndex(const Map::Roads& roads, Dimension2D road_offset)
+    : road_offset_(road_offset) {
+    std::vector<std::tuple<Coord, Coord, Coord>> horizontal, vertical;
+    for (const auto& road : roads) {
+        auto start = road.GetStart();
+        auto end = road.GetEnd();
+        if (road.IsHorizontal())
+            horizontal.emplace_back(start.y, std::min(start.x, end.x), std::max(start.x, end.x));
+        if (road.IsVertical())
+            vertical.emplace_back(start.x, std::min(start.y, end.y), std::max(start.y, end.y));
+    }
+    rows_.Build(std::move(horizontal));
+    columns_.Build(std::move(vertical));
+}
+
+RoadIndex::Cover RoadIndex::RoadsAt(Point cell) const {
+    Cover cover;
+    rows_.ForEachCovering(cell.y, cell.x, [&](const Segment& s) {
+        cover.emplace_back(Point{s.lo, cell.y}, Point{s.hi, cell.y}, road_offset_);
+    });
+    columns_.ForEachCovering(cell.x, cell.y, [&](const Segment& s) {
+        cover.emplace_back(Point{cell.x, s.lo}, Point{cell.x, s.hi}, road_offset_);
+    });
+    return cover;
+}
+
+size_t RoadIndex::MemoryUsage() const noexcept {
+    return sizeof(*this) + rows_.MemoryUsage() + columns_.MemoryUsage();
+}
+
+void RoadIndex::Axis::Build(std::vector<std::tuple<Coord, Coord, Coord>> entries) {
+    // entries: (line, lo, hi)
+    std::sort(entries.begin(), entries.end());
+    lines.clear();
+    segments.clear();
+    segments.reserve(entries.size());
+    for (const auto& [line, lo, hi] : entries) {
+        if (lines.empty() || lines.back().pos != line) {
+            const auto begin = static_cast<uint32_t>(segments.size());
+            lines.push_back(Line{line, begin, begin});
+            segments.push_back(Segment{lo, hi, hi});
+        } else {
+            segments.push_back(Segment{lo, hi, std::max(hi, segments.back().max_hi)});
+        }
+        lines.back().end = static_cast<uint32_t>(segments.size());
+    }
+    lines.shrink_to_fit();
+}
+
+template <typename Fn>
+void RoadIndex::Axis::ForEachCovering(Coord line, Coord at, Fn&& fn) const {
+    auto l = std::lower_bound(lines.begin(), lines.end(), line,
+        [](const Line& l, Coord pos) { return l.pos < pos; });
+    if (l == lines.end() || l->pos != line)
+        return;
+    const auto first = segments.begin() + l->begin;
+    // отрезки, начинающиеся правее at, его не содержат
+    auto it = std::upper_bound(first, segments.begin() + l->end, at,
+        [](Coord at, const Segment& s) { return at < s.lo; });
+    // идём назад, пока среди оставшихся отрезков есть доходящие до at
+    while (it != first && std::prev(it)->max_hi >= at) {
+        --it;
+        if (it->hi >= at)
+            fn(*it);
+    }
+}
+
+size_t RoadIndex::Axis::MemoryUsage() const noexcept {
+    return lines.capacity() * sizeof(Line) + segments.capacity() * sizeof(Segment);
+}
+
+SpawnSampler::SpawnSampler(const Map::Roads& roads) {
+    segments_.reserve(roads.size());
+    for (const auto& road : roads) {
+        auto start = road.GetStart();
+        auto end = road.GetEnd();
+        segments_.push_back(Segment{
+            .start = { static_cast<Dimension2D>(start.x), static_cast<Dimension2D>(start.y) },
+            .end = { static_cast<Dimension2D>(end.x), static_cast<Dimension2D>(end.y) },
+            .horizontal = road.IsHorizontal() });
+    }
+}
+
+MapIndex::MapIndex(const Map& map)
+    : map_(&map)
+    , road_index_(map.GetRoads(), map.GetRoadOffset())
+    , spawn_sampler_(map.GetRoads()) {
+    office_items_.reserve(map.GetOffices().size());
+    for (const auto& office : map.GetOffices()) {
+        auto pos = office.GetPosition();
+        Point2D pos2d{ static_cast<Dimension2D>(pos.x), static_cast<Dimension2D>(pos.y) };
+        office_items_.push_back(collision_detector::Item{ .position = pos2d, .width = OFFICE_WIDTH });
+    }
+}
+
 Game::GameSessions& Game::GetGameSessions() {
     return game_sessions_;
 }
@@ -105,73 +256,71 @@ void Game::Tick(milliseconds time_delta_ms) {
     for (auto &game_session : game_sessions_) {
         game_session.Tick(time_delta_ms);
     }
+    NotifyTick(time_delta_ms);
+}
+
+void Game::NotifyTick(milliseconds time_delta_ms) {
     tick_signal_(time_delta_ms);
 }
 
-Dog* GameSession::AddDog(std::string_view nick_name) {
+Dog::Id GameSession::AddDog(std::string_view nick_name) {
     Point2D coord;
     if (randomize_spawn_points_)
         coord = GetRandomRoadCoord();
     auto dog_id = GetNextDogId();
-    Dog dog = Dog(dog_id, nick_name.data(), coord);
-    MoveDogToContainer(std::move(dog));
-    loots_.push_back(std::move(Loot{
+    dogs_.Add(Dog(dog_id, std::string(nick_name), coord));
+    idle_dogs_.Push(dog_id, session_time_);
+    loots_.Insert(Loot{
         .id = GetNextLootId(),
         .type = GetRandomInt(0, static_cast<int>(map_->GetLootsParam().size() - 1)),
-        .pos = GetRandomRoadCoord() }));
-    return &dogs_.at(dog_id);
+        .pos = GetRandomRoadCoord() });
+    roster_.reset();
+    PublishSnapshot();
+    return dog_id;
 }
 
 void GameSession::DeleteDog(const Dog::Id& dog_id)
 {
-    if (dogs_.contains(dog_id)) {
-        dogs_.erase(dog_id);
-    }
-}
-
-void GameSession::MoveDogToContainer(Dog &&dog) {
-    try {
-        auto id = dog.GetId();
-        dogs_.emplace(id, std::move(dog));
-    }
-    catch (...) {
-        throw std::bad_alloc(); //"failed to allocate memory for Dog"
-    }
+    dogs_.Erase(dog_id);
+    roster_.reset();
+    PublishSnapshot();
 }
 
-void GameSession::SetDogs(const Dogs& dogs) {
-    for (auto it = dogs.begin(); it != dogs.end(); ++it) {
-        auto [id, dog] = *it;
-        MoveDogToContainer(std::move(dog));
+void GameSession::SetDogs(std::vector<Dog>&& dogs) {
+    for (auto& dog : dogs) {
+        idle_dogs_.Push(dog.GetId(), session_time_ - dog.GetStayTime());
+        dogs_.Add(std::move(dog));
     }
+    roster_.reset();
+    PublishSnapshot();
 }
 
 const GameSession::Dogs& GameSession::GetDogs() const {
     return dogs_;
 }
 
+std::vector<Dog::Id> GameSession::TakeIdleDogs(milliseconds retirement_time) {
+    return idle_dogs_.Take(session_time_ - retirement_time,
+        [this](const Dog::Id& dog_id) -> std::optional<milliseconds> {
+            auto dog = dogs_.Find(dog_id);
+            if (!dog)
+                return std::nullopt;
+            return session_time_ - dog->GetStayTime();
+        });
+}
+
 void GameSession::SetLoots(const Loots& loots) {
     loots_ = loots;
+    PublishSnapshot();
 }
 
 const Loots& GameSession::GetLoots() const {
     return loots_;
 }
-/*
-Dog* GameSession::FindDog(std::string_view nick_name) {
-    for (auto &[dog_id, dog] : dogs_) {
-        if (dog.GetName() == nick_name)
-            return &dog;
-    }
-    return nullptr;
-}*/
 
-Dog* GameSession::FindDog(const Dog::Id& dog_id)
+std::optional<DogView> GameSession::FindDog(const Dog::Id& dog_id) const
 {
-    if (dogs_.contains(dog_id)) {
-        return &dogs_.at(dog_id);
-    }
-    return {};
+    return dogs_.Find(dog_id);
 }
 
 double GameSession::GetRandomDouble(double min, double max) {
@@ -193,53 +342,158 @@ LostObjectType GameSession::GetRandomInt(int min, int max) {
 }
 
 Point2D GameSession::GetRandomRoadCoord() {
-    auto &roads = map_->GetRoads();
-    if (roads.size() == 0)
-        return Point2D();
-    auto &road = roads[static_cast<size_t>(GetRandomInt(0, 
-        static_cast<int>(roads.size() - 1)))];
-    Point2D coord;
-    if (road.IsHorizontal()) {
-        auto start_point = road.GetStart();
-        auto end_point = road.GetEnd();
-        coord.x = GetRandomDouble(start_point.x, end_point.x);
-        coord.y = end_point.y;
-    }
-    else {
-        auto start_point = road.GetStart();
-        auto end_point = road.GetEnd();
-        coord.y = GetRandomDouble(start_point.y, end_point.y);
-        coord.x = end_point.x;
+    return map_index_->GetSpawnSampler().Sample(
+        [](size_t count) {
+            return static_cast<size_t>(GetRandomInt(0, static_cast<int>(count - 1)));
+        },
+        [](Dimension2D from, Dimension2D to) {
+            return GetRandomDouble(from, to);
+        });
+}
+
+void GameSession::MoveDog(const Dog::Id& id, Move move) {
+    if (auto slot = dogs_.FindSlot(id)) {
+        dogs_.SetMove(*slot, move, map_->GetDogSpeed());
     }
-    return coord;
 }
 
-void GameSession::LoadRoadMap() {
-    const auto &roads = map_->GetRoads();
-    for (const auto& road : roads) {
-        auto start = road.GetStart();
-        auto end = road.GetEnd();
-        if (road.IsHorizontal()) {
-            if (start.x > end.x)
-                std::swap(start, end);
-            for (auto x = start.x; x <= end.x; x++) {
-                road_map.emplace(Point{.x = x, .y = start.y}, &road);
-            }
+void GameSession::PushMove(const Dog::Id& id, Move move) {
+    pending_moves_.Push(MoveCommand{id, move});
+}
+
+void GameSession::ApplyPendingMoves() {
+    pending_moves_.Drain([this](MoveCommand&& command) {
+        MoveDog(command.dog_id, command.move);
+    });
+}
+
+namespace {
+// Версии первого снимка отсчитываются от текущего времени в микросекундах,
+// чтобы после перезапуска сервера они не совпали с уже выданными клиентам
+uint64_t InitialSnapshotVersion() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+template <typename Id>
+void AppendRemovals(std::vector<SessionSnapshot::Removal<Id>>& removals,
+        const std::vector<SessionSnapshot::Removal<Id>>& prev, uint64_t& history_begin) {
+    // removals уже содержит удаления новой версии, из прошлых сохраняются
+    // последние, чтобы всего было не больше MAX_REMOVALS
+    const size_t room = SessionSnapshot::MAX_REMOVALS > removals.size()
+        ? SessionSnapshot::MAX_REMOVALS - removals.size() : 0;
+    const size_t keep = std::min(prev.size(), room);
+    const size_t skip = prev.size() - keep;
+    if (skip > 0)
+        history_begin = std::max(history_begin, prev[skip - 1].version);
+    removals.insert(removals.begin(), prev.begin() + skip, prev.end());
+}
+}  // namespace
+
+void GameSession::PublishSnapshot() {
+    auto prev = snapshot_.Load();
+    auto snapshot = std::make_shared<SessionSnapshot>();
+    const uint64_t version = prev ? prev->version + 1 : InitialSnapshotVersion();
+    bool changed = !prev || !roster_;
+    if (!roster_) {
+        auto roster = std::make_shared<SessionSnapshot::Roster>();
+        roster->dogs.reserve(dogs_.size());
+        for (const auto& dog : dogs_)
+            roster->dogs.emplace_back(dog.GetId(), dog.GetName());
+        roster_ = std::move(roster);
+    }
+    snapshot->roster = roster_;
+
+    // Собаки и трофеи обычно лежат в том же порядке, что и в прошлом снимке,
+    // поэтому предыдущее состояние сначала ищется по тому же индексу
+    std::unordered_map<Dog::Id, size_t, util::TaggedHasher<Dog::Id>> prev_dog_index;
+    auto find_prev_dog = [&](const Dog::Id& id, size_t i) -> const SessionSnapshot::DogState* {
+        if (!prev)
+            return nullptr;
+        if (i < prev->dogs.size() && prev->dogs[i].id == id)
+            return &prev->dogs[i];
+        if (prev_dog_index.empty()) {
+            for (size_t j = 0; j < prev->dogs.size(); ++j)
+                prev_dog_index.emplace(prev->dogs[j].id, j);
         }
-        if (road.IsVertical()) {
-            if (start.y > end.y)
-                std::swap(start, end);
-            for (auto y = start.y; y <= end.y; y++) {
-                road_map.emplace(Point{ .x = start.x, .y = y }, &road);
+        auto it = prev_dog_index.find(id);
+        return it == prev_dog_index.end() ? nullptr : &prev->dogs[it->second];
+    };
+    snapshot->dogs.reserve(dogs_.size());
+    size_t matched_dogs = 0;
+    for (const auto& dog : dogs_) {
+        const auto& bag = dog.GetLoots();
+        SessionSnapshot::DogState state{
+            .id = dog.GetId(),
+            .pos = dog.GetPoint(),
+            .speed = dog.GetSpeed(),
+            .dir = dog.GetDir(),
+            .bag = {bag.begin(), bag.end()},
+            .score = dog.GetScore()};
+        const auto* before = find_prev_dog(state.id, snapshot->dogs.size());
+        if (before)
+            ++matched_dogs;
+        if (before && before->SameState(state)) {
+            state.changed_at = before->changed_at;
+        } else {
+            state.changed_at = version;
+            changed = true;
+        }
+        snapshot->dogs.push_back(std::move(state));
+    }
+
+    std::unordered_map<Loot::Id, size_t, util::TaggedHasher<Loot::Id>> prev_loot_index;
+    snapshot->loots.reserve(loots_.size());
+    size_t matched_loots = 0;
+    for (const auto& loot : loots_) {
+        const size_t i = snapshot->loots.size();
+        const SessionSnapshot::LootState* before = nullptr;
+        if (prev && i < prev->loots.size() && prev->loots[i].loot.id == loot.id) {
+            before = &prev->loots[i];
+        } else if (prev) {
+            if (prev_loot_index.empty()) {
+                for (size_t j = 0; j < prev->loots.size(); ++j)
+                    prev_loot_index.emplace(prev->loots[j].loot.id, j);
             }
+            if (auto it = prev_loot_index.find(loot.id); it != prev_loot_index.end())
+                before = &prev->loots[it->second];
         }
+        if (before)
+            ++matched_loots;
+        else
+            changed = true;
+        snapshot->loots.push_back({loot, before ? before->added_at : version});
     }
-}
 
-void GameSession::MoveDog(const Dog::Id& id, Move move) {
-    if (auto it_dog = dogs_.find(id); it_dog != dogs_.end()) {
-        it_dog->second.Diraction(move, map_->GetDogSpeed());
+    if (prev) {
+        snapshot->history_begin = prev->history_begin;
+        // всё, что было в прошлом снимке и не нашлось в новом, удалено
+        if (matched_dogs != prev->dogs.size()) {
+            for (const auto& dog : prev->dogs) {
+                if (!dogs_.Contains(dog.id))
+                    snapshot->removed_dogs.push_back({dog.id, version});
+            }
+        }
+        if (matched_loots != prev->loots.size()) {
+            std::unordered_set<Loot::Id, util::TaggedHasher<Loot::Id>> current;
+            current.reserve(loots_.size());
+            for (const auto& loot : loots_)
+                current.insert(loot.id);
+            for (const auto& loot : prev->loots) {
+                if (!current.contains(loot.loot.id))
+                    snapshot->removed_loots.push_back({loot.loot.id, version});
+            }
+        }
+        changed = changed || !snapshot->removed_dogs.empty() || !snapshot->removed_loots.empty();
+        if (!changed)
+            return;
+        AppendRemovals(snapshot->removed_dogs, prev->removed_dogs, snapshot->history_begin);
+        AppendRemovals(snapshot->removed_loots, prev->removed_loots, snapshot->history_begin);
+    } else {
+        snapshot->history_begin = version;
     }
+    snapshot->version = version;
+    snapshot_.Store(std::move(snapshot));
 }
 
 Point2D GameSession::MoveDog(Point2D start_pos, Point2D end_pos) {
@@ -255,7 +509,7 @@ Point2D GameSession::MoveDog(Point2D start_pos, Point2D end_pos) {
     int protect = 0;
     do {
         Point dog_cell = pos_round(start_pos);
-        auto roads = road_map.equal_range(dog_cell);
+        auto roads = map_index_->GetRoadIndex().RoadsAt(dog_cell);
         if (PosInRoads(roads, end_pos)) {
             return end_pos;
         }
@@ -268,59 +522,70 @@ Point2D GameSession::MoveDog(Point2D start_pos, Point2D end_pos) {
 }
 
 void GameSession::MoveDogsInMap(milliseconds time_delta_ms) {
-    for (auto& [dog_id, dog] : dogs_) {
-        dog.IncLifetime(time_delta_ms);
-        if (dog.IsStanding())
+    static constexpr double ms_to_sec = 1000.0;
+    const double dt_second = static_cast<double>(time_delta_ms.count()) / ms_to_sec;
+    session_time_ += time_delta_ms;
+    const Speed2D zero_speed{};
+    auto positions = dogs_.Positions();
+    auto prev_positions = dogs_.PrevPositions();
+    auto speeds = dogs_.Speeds();
+    auto lifetimes = dogs_.Lifetimes();
+    auto last_move_times = dogs_.LastMoveTimes();
+    for (size_t slot = 0; slot < dogs_.size(); ++slot) {
+        lifetimes[slot] += time_delta_ms;
+        auto& speed = speeds[slot];
+        if (speed == zero_speed)
             continue;
-        auto start_pos = dog.GetPoint();
-        auto end_pos = dog.GetEndPoint(time_delta_ms);
+        last_move_times[slot] = lifetimes[slot];
+        auto start_pos = positions[slot];
+        Point2D end_pos{ start_pos.x + speed.x * dt_second,
+            start_pos.y + speed.y * dt_second };
         auto move_pos = MoveDog(start_pos, end_pos);
-        dog.SetPoint(move_pos);
+        prev_positions[slot] = start_pos;
+        positions[slot] = move_pos;
         // if the dog is on the edge, it is necessery to stop him
         if (move_pos != end_pos)
-            dog.Stop();
+            speed = zero_speed;
     }
 }
 
 void GameSession::CollectAndReturnLoots() {
     namespace cd = collision_detector;
     cd::ItemGatherer item_gatherer;
-    std::map<size_t, model::Dog*> dog_numb_to_gather;
-    std::map<size_t, decltype(loots_.begin())> loot_numb_to_item;
-    size_t dog_idx = 0;
-    size_t loot_idx = 0;
-    for (auto& [dog_id, dog] : dogs_) {
-        dog_numb_to_gather[dog_idx++] = &dog;
+    auto positions = dogs_.Positions();
+    auto prev_positions = dogs_.PrevPositions();
+    // gatherer index is the dog slot
+    for (size_t slot = 0; slot < dogs_.size(); ++slot) {
         item_gatherer.Add(cd::Gatherer{ 
-            .start_pos = dog.GetPrevPoint(), 
-            .end_pos = dog.GetPoint(), .width = DOG_WIDTH});
+            .start_pos = prev_positions[slot], 
+            .end_pos = positions[slot], .width = DOG_WIDTH});
     }
-    for (auto it = loots_.begin(); it != loots_.end(); ++it) {
-        loot_numb_to_item[loot_idx++] = it;
-        item_gatherer.Add(cd::Item{ .position = it->pos, .width = LOOT_WIDTH });
+    // item index is the dense loot index at the start of the pass; handles stay
+    // valid while other loots are moved out and go stale once the loot is taken
+    loot_handles_.clear();
+    for (size_t i = 0; i < loots_.size(); ++i) {
+        loot_handles_.push_back(loots_.HandleAt(i));
+        item_gatherer.Add(cd::Item{ .position = loots_[i].pos, .width = LOOT_WIDTH });
     }
-    for (const auto& office : map_->GetOffices()) {
-        auto pos = office.GetPosition();
-        Point2D pos2d{ static_cast<Dimension2D>(pos.x), static_cast<Dimension2D>(pos.y) };
-        item_gatherer.Add(cd::Item{ .position = pos2d, .width = OFFICE_WIDTH });
+    for (auto office : map_index_->GetOfficeItems()) {
+        item_gatherer.Add(std::move(office));
     }
     auto gathering_events = cd::FindGatherEvents(item_gatherer);
-    size_t sz_loots = loots_.size();
     for (const auto& ge : gathering_events) {
         // if is office
-        if (ge.item_id >= sz_loots) {
+        if (ge.item_id >= loot_handles_.size()) {
             // Return all items to the base
-            dog_numb_to_gather[ge.gatherer_id]->LootsReturn(map_->GetLootsParam());
+            dogs_.ReturnLoots(ge.gatherer_id, map_->GetLootsParam());
             continue;
         }
         // if is loot
-        if (loot_numb_to_item.contains(ge.item_id)) {
+        const auto loot = loot_handles_[ge.item_id];
+        if (loots_.Contains(loot)) {
+            auto& bag = dogs_.Bag(ge.gatherer_id);
             // if the bag is full, then we do not collect loot
-            if (dog_numb_to_gather[ge.gatherer_id]->GetLoots().size() >= map_->GetBagCapacity())
+            if (bag.size() >= map_->GetBagCapacity())
                 continue;
-            dog_numb_to_gather[ge.gatherer_id]->PutTheLoot(
-                loots_, loot_numb_to_item[ge.item_id]);
-            loot_numb_to_item.erase(ge.item_id);
+            loots_.MoveTo(loot, bag);
         }
     }
 }
@@ -329,10 +594,10 @@ void GameSession::PushLootsToMap(milliseconds time_delta_ms) {
     auto cnt_loot = loot_generator_.Generate(time_delta_ms,
         static_cast<int>(loots_.size()), static_cast<int>(dogs_.size()));
     for (unsigned i = 0; i < cnt_loot; i++) {
-        loots_.push_back(std::move(Loot{
+        loots_.Insert(Loot{
             .id = GetNextLootId(),
             .type = GetRandomInt(0, static_cast<int>(map_->GetLootsParam().size() - 1)),
-            .pos = GetRandomRoadCoord() }));
+            .pos = GetRandomRoadCoord() });
     }
 }
 
@@ -360,10 +625,27 @@ void GameSession::SetLastDogId(const Dog::Id& dog_id) {
 }
 
 void GameSession::Tick(milliseconds time_delta_ms) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    // время фазы - от конца предыдущей, один вызов часов на фазу
+    auto finish = [&](TickPhase phase) {
+        const auto now = Clock::now();
+        const auto index = static_cast<size_t>(phase);
+        last_tick_timings_[index] = now - start;
+        if (util::Tracer::Enabled())
+            TRACER().Record(TICK_PHASE_NAMES[index], "tick", start, now);
+        start = now;
+    };
+    ApplyPendingMoves();
+    finish(TickPhase::ApplyMoves);
     MoveDogsInMap(time_delta_ms);
+    finish(TickPhase::MoveDogs);
     PushLootsToMap(time_delta_ms);
+    finish(TickPhase::PushLoots);
     CollectAndReturnLoots();
-
+    finish(TickPhase::CollectLoots);
+    PublishSnapshot();
+    finish(TickPhase::PublishSnapshot);
 }
 //    |  ______________
 // y1 | |              |
@@ -374,22 +656,20 @@ void GameSession::Tick(milliseconds time_delta_ms) {
 //    |____________________
 //     x0             x1
 //
-bool GameSession::PosInRoads(RoadMapIter roads, Point2D pos) {
-    for (auto it = roads.first; it != roads.second; ++it) {
-        auto &road = *it->second;
-        auto [x0, x1, y0, y1] = road.GetRectangle();
+bool GameSession::PosInRoads(const RoadIndex::Cover& roads, Point2D pos) {
+    for (const auto& road : roads) {
+        auto [x0, x1, y0, y1] = road.Get();
         if (pos.x >= x0 && pos.x <= x1 && pos.y >= y0 && pos.y <= y1)
             return true;
     }
     return false;
 }
-Point2D GameSession::GetExtremePos(RoadMapIter roads, Point2D pos) {
+Point2D GameSession::GetExtremePos(const RoadIndex::Cover& roads, Point2D pos) {
     typedef std::numeric_limits<Dimension2D> dbl; 
     Point2D min;
     Dimension2D min_d = dbl::max(), distance;
-    for (auto it = roads.first; it != roads.second; ++it) {
-        auto& road = *it->second;
-        auto [x0, x1, y0, y1] = road.GetRectangle();
+    for (const auto& road : roads) {
+        auto [x0, x1, y0, y1] = road.Get();
         if (pos.x >= x0 && pos.x <= x1) {
             if (pos.y <= y0) {
                 if ((distance = std::abs(y0 - pos.y)) < min_d) {
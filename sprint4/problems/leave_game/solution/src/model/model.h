@@ -1,17 +1,28 @@
 #pragma once 
 #include "../sdk.h"
 #include <boost/signals2.hpp>
+#include <boost/container/small_vector.hpp>
+#include <array>
+#include <chrono>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <deque>
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <list>
 #include "dog.h"
+#include "dog_store.h"
+#include "idle_queue.h"
+#include "mpsc_queue.h"
+#include "../util/atomic_shared_ptr.h"
+#include "../util/lazy.h"
 #include "extra_data.h"
 #include "loot_generator.h"
+#include "collision_detector.h"
 
 namespace model {
 
@@ -235,48 +246,230 @@ struct LootGeneratorConfig {
     double probability = 500.0;
 };
 
-struct PointKeyHash {
-    std::size_t operator()(const Point& k) const {
-        return std::hash<Coord>()(k.x) ^ (std::hash<Coord>()(k.y) << 1);
+// Индекс дорог карты: по целочисленной клетке возвращает прямоугольники
+// всех дорог, проходящих через неё.
+// Горизонтальные дороги сгруппированы по строкам (y), вертикальные - по столбцам (x).
+// Внутри линии отрезки отсортированы по началу, рядом хранится префиксный
+// максимум их концов, поэтому поиск занимает O(log n + k), где k - число
+// найденных дорог. Память пропорциональна числу дорог, а не их длине.
+class RoadIndex {
+public:
+    using Cover = boost::container::small_vector<RoadRectangle, 4>;
+
+    RoadIndex() = default;
+    RoadIndex(const Map::Roads& roads, Dimension2D road_offset);
+
+    Cover RoadsAt(Point cell) const;
+    // Объём памяти, занимаемой индексом, в байтах
+    size_t MemoryUsage() const noexcept;
+
+private:
+    struct Segment {
+        Coord lo, hi;
+        // максимум hi среди отрезков линии от первого до текущего
+        Coord max_hi;
+    };
+    struct Line {
+        Coord pos;
+        // отрезки линии - segments[begin, end)
+        uint32_t begin, end;
+    };
+    struct Axis {
+        std::vector<Line> lines;
+        std::vector<Segment> segments;
+
+        void Build(std::vector<std::tuple<Coord, Coord, Coord>> entries);
+        template <typename Fn>
+        void ForEachCovering(Coord line, Coord at, Fn&& fn) const;
+        size_t MemoryUsage() const noexcept;
+    };
+
+    Axis rows_;
+    Axis columns_;
+    Dimension2D road_offset_ = 0.0;
+};
+
+// Отрезки дорог карты для выбора случайной точки на дороге
+class SpawnSampler {
+public:
+    explicit SpawnSampler(const Map::Roads& roads);
+
+    // random_index(n) возвращает индекс дороги из [0, n - 1],
+    // random_coord(a, b) - координату из [a, b]
+    template <typename RandomIndex, typename RandomCoord>
+    Point2D Sample(RandomIndex&& random_index, RandomCoord&& random_coord) const {
+        if (segments_.empty())
+            return Point2D();
+        const auto& segment = segments_[random_index(segments_.size())];
+        if (segment.horizontal)
+            return { random_coord(segment.start.x, segment.end.x), segment.end.y };
+        return { segment.end.x, random_coord(segment.start.y, segment.end.y) };
     }
+
+private:
+    struct Segment {
+        Point2D start;
+        Point2D end;
+        bool horizontal;
+    };
+    std::vector<Segment> segments_;
 };
-struct PointKeyEqual {
-    bool operator()(const Point& lhs, const Point& rhs) const {
-        return lhs.x == rhs.x && lhs.y == rhs.y;
+
+// Неизменяемые производные данные карты: индекс дорог, офисы в виде предметов
+// для поиска столкновений и выбор точек появления.
+// Строится один раз при загрузке игры и разделяется всеми сессиями этой карты,
+// поэтому создание и восстановление сессии не зависит от размера карты
+class MapIndex {
+public:
+    explicit MapIndex(const Map& map);
+
+    const Map& GetMap() const noexcept {
+        return *map_;
+    }
+    const RoadIndex& GetRoadIndex() const noexcept {
+        return road_index_;
+    }
+    const collision_detector::ItemGatherer::Items& GetOfficeItems() const noexcept {
+        return office_items_;
     }
+    const SpawnSampler& GetSpawnSampler() const noexcept {
+        return spawn_sampler_;
+    }
+
+private:
+    const Map* map_;
+    RoadIndex road_index_;
+    collision_detector::ItemGatherer::Items office_items_;
+    SpawnSampler spawn_sampler_;
+};
+
+// Неизменяемый снимок состояния игровой сессии.
+// Публикуется владельцем сессии в конце тика и при изменении состава собак,
+// читается из любого потока без синхронизации с тиком.
+// Версия растёт, только если состояние изменилось; по версиям изменений
+// собак и трофеев строится разница между снимками
+struct SessionSnapshot {
+    struct DogState {
+        Dog::Id id;
+        Point2D pos;
+        Speed2D speed;
+        Direction dir;
+        std::vector<Loot> bag;
+        Score score;
+        // версия, в которой собака последний раз изменилась
+        uint64_t changed_at = 0;
+
+        bool SameState(const DogState& other) const {
+            return pos == other.pos && speed == other.speed && dir == other.dir
+                && score == other.score && bag == other.bag;
+        }
+    };
+    struct LootState {
+        Loot loot;
+        // версия, в которой трофей появился на карте
+        uint64_t added_at = 0;
+    };
+    template <typename Id>
+    struct Removal {
+        Id id;
+        uint64_t version;
+    };
+    // Имена меняются только при входе и уходе игроков,
+    // поэтому список разделяется снимками до изменения состава
+    struct Roster {
+        std::vector<std::pair<Dog::Id, std::string>> dogs;
+        // сериализованный список, строится прикладным слоем при первом запросе
+        util::Lazy<std::string> body;
+    };
+    // Сколько последних удалений собак и трофеев хранит снимок
+    static constexpr size_t MAX_REMOVALS = 1024;
+
+    uint64_t version = 0;
+    // Разница с версией since точна при since >= history_begin:
+    // более старые удаления уже вытеснены из истории
+    uint64_t history_begin = 0;
+    std::vector<DogState> dogs;
+    std::vector<LootState> loots;
+    // удаления по возрастанию версии
+    std::vector<Removal<Dog::Id>> removed_dogs;
+    std::vector<Removal<Loot::Id>> removed_loots;
+    std::shared_ptr<const Roster> roster;
+    // Сериализованное состояние сессии. Строится при первом запросе после
+    // публикации снимка и отдаётся всем игрокам сессии до следующего тика
+    util::Lazy<std::string> state_body;
+    // То же состояние в двоичном виде (application/x-game-state)
+    util::Lazy<std::string> state_binary;
+
+    bool CoversSince(uint64_t since) const noexcept {
+        return since >= history_begin && since <= version;
+    }
+};
+
+// Фазы GameSession::Tick в порядке выполнения
+enum class TickPhase {
+    ApplyMoves,
+    MoveDogs,
+    PushLoots,
+    CollectLoots,
+    PublishSnapshot
 };
+inline constexpr size_t TICK_PHASES = 5;
+inline constexpr std::array<std::string_view, TICK_PHASES> TICK_PHASE_NAMES{
+    "apply_moves", "move_dogs", "push_loots", "collect_loots", "publish_snapshot"};
+// Время каждой фазы последнего тика сессии
+using TickTimings = std::array<std::chrono::nanoseconds, TICK_PHASES>;
 
 class GameSession {
-private:
-    using RoadMap = std::unordered_multimap<Point, const Road*, PointKeyHash, PointKeyEqual>;
-    using RoadMapIter = decltype(RoadMap{}.equal_range(Point{}));
-    using DogsIdHasher = util::TaggedHasher<Dog::Id>;
 public:
-    using Dogs = std::unordered_map<Dog::Id, Dog, DogsIdHasher>;
+    using Dogs = DogStore;
 
-    GameSession(const Map* map, bool randomize_spawn_points,
+    GameSession(std::shared_ptr<const MapIndex> map_index, bool randomize_spawn_points,
         const LootGeneratorConfig loot_generator_config)
-        : map_(map)
+        : map_index_(std::move(map_index))
+        , map_(&map_index_->GetMap())
         , randomize_spawn_points_(randomize_spawn_points)
         , loot_generator_config_(loot_generator_config)
         , loot_generator_(loot_generator_config.period, 
             loot_generator_config.probability,
             [&]() {return GetRandomDouble(0.0, 1.0);}) {
-        LoadRoadMap();
+        PublishSnapshot();
     }
     const Map::Id& MapId() const {
         return map_->GetId();
     } 
-   // Dog* FindDog(std::string_view nick_name);
-    Dog* FindDog(const Dog::Id& dog_id);
-    Dog* AddDog(std::string_view nick_name);
+    const std::shared_ptr<const MapIndex>& GetMapIndex() const noexcept {
+        return map_index_;
+    }
+    // Представление собаки действительно до ближайшего удаления собаки из сессии.
+    // Для долгого хранения используется Dog::Id
+    std::optional<DogView> FindDog(const Dog::Id& dog_id) const;
+    Dog::Id AddDog(std::string_view nick_name);
     void DeleteDog(const Dog::Id& dog_id);
-    void SetDogs(const Dogs& dogs);
+    void SetDogs(std::vector<Dog>&& dogs);
     const Dogs& GetDogs() const;
+    // Собаки, простоявшие не меньше retirement_time. Возвращённые собаки
+    // выходят из очереди простоя, их следует удалить из сессии
+    std::vector<Dog::Id> TakeIdleDogs(milliseconds retirement_time);
     void SetLoots(const Loots& loots) ;
     const Loots& GetLoots() const;
     void MoveDog(const Dog::Id& dog_id, Move move);
+    // Ставит команду движения в очередь сессии. Можно вызывать из любого потока
+    // без синхронизации с тиком: команды применяются в начале следующего тика
+    // (или в ApplyPendingMoves) в порядке поступления, поэтому из нескольких
+    // команд одной собаке за тик действует последняя. Команда собаке,
+    // удалённой до применения, игнорируется
+    void PushMove(const Dog::Id& dog_id, Move move);
+    // Применяет накопленные команды. Вызывается в потоке, владеющем сессией
+    void ApplyPendingMoves();
+    // Последний опубликованный снимок, без блокировок из любого потока
+    std::shared_ptr<const SessionSnapshot> GetSnapshot() const {
+        return snapshot_.Load();
+    }
     void Tick(milliseconds time_delta_ms);
+    // Замеры последнего Tick, читаются в потоке, владеющем сессией
+    const TickTimings& GetLastTickTimings() const noexcept {
+        return last_tick_timings_;
+    }
     const Loot::Id& GetLastLootId() const;
     void SetLastLootId(const Loot::Id& loot_id);
     const Dog::Id& GetLastDogId() const;
@@ -288,40 +481,60 @@ public:
         loot_id_ = other.loot_id_;
         dog_id_ = other.dog_id_;
         dogs_ = other.dogs_;
+        idle_dogs_ = other.idle_dogs_;
+        session_time_ = other.session_time_;
         loots_ = other.loots_;
+        map_index_ = other.map_index_;
         map_ = other.map_;
         randomize_spawn_points_ = other.randomize_spawn_points_;
-        road_map = other.road_map;
         loot_generator_config_ = other.loot_generator_config_;
+        snapshot_ = other.snapshot_;
+        roster_ = other.roster_;
         loot_generator_ = loot_gen::LootGenerator{ loot_generator_config_.period,
             loot_generator_config_.probability,
             [&]() {return GetRandomDouble(0.0, 1.0); } };
     }
 
 private:
+    struct MoveCommand {
+        Dog::Id dog_id;
+        Move move;
+    };
+
     Loot::Id loot_id_{ 0 };
     Dog::Id dog_id_{ 0 };
     Dogs dogs_;
+    // по записи на каждую собаку сессии
+    IdleQueue idle_dogs_;
+    // сумма дельт тиков, отсчёт времени простоя собак
+    milliseconds session_time_{0};
+    // команды из запросов action, копия сессии получает пустую очередь
+    MpscQueue<MoveCommand> pending_moves_;
+    util::AtomicSharedPtr<const SessionSnapshot> snapshot_;
+    // список имён для следующего снимка, nullptr - состав собак изменился
+    std::shared_ptr<const SessionSnapshot::Roster> roster_;
     Loots loots_;
+    // рабочий буфер CollectAndReturnLoots, переиспользуется между тиками
+    std::vector<Loots::Handle> loot_handles_;
+    TickTimings last_tick_timings_{};
+    std::shared_ptr<const MapIndex> map_index_;
     const Map* map_;
     bool randomize_spawn_points_ = true;
-    RoadMap road_map;
     LootGeneratorConfig loot_generator_config_;
     loot_gen::LootGenerator loot_generator_{loot_gen::LootGenerator::TimeInterval{0}, 0.0};
 
     Point2D GetRandomRoadCoord();
-    void LoadRoadMap();
-    bool PosInRoads(RoadMapIter roads, Point2D pos);
-    Point2D GetExtremePos(RoadMapIter roads, Point2D pos);
+    static bool PosInRoads(const RoadIndex::Cover& roads, Point2D pos);
+    static Point2D GetExtremePos(const RoadIndex::Cover& roads, Point2D pos);
     Point2D MoveDog(Point2D start_pos, Point2D end_pos);
     static double GetRandomDouble(double min, double max);
     static LostObjectType GetRandomInt(int min, int max);
     void MoveDogsInMap(milliseconds time_delta_ms);
     void CollectAndReturnLoots();
+    void PublishSnapshot();
     void PushLootsToMap(milliseconds time_delta_ms);
     Dog::Id GetNextDogId();
     Loot::Id GetNextLootId();
-    void MoveDogToContainer(Dog &&dog);
 };
 
 struct GameParam {
@@ -355,11 +568,25 @@ public:
         return extra_data_.GetLootTypes(*id);
     }
     const Map* FindMap(const Map::Id& id) const noexcept;
+    // Строит MapIndex для всех карт, карты обрабатываются параллельно.
+    // Вызывается после загрузки карт; добавление карты сбрасывает индексы
+    void BuildMapIndexes();
+    std::shared_ptr<const MapIndex> FindMapIndex(const Map::Id& id) const noexcept;
+    // FindGameSession, AddGameSession, FindOrAddGameSession и GetGameSessionList
+    // потокобезопасны. Сессии хранятся в deque, указатели на них не инвалидируются
     GameSession* FindGameSession(const Map::Id& id) noexcept;
     GameSession* AddGameSession(const Map::Id& id);
+    GameSession* FindOrAddGameSession(const Map::Id& id);
+    std::vector<GameSession*> GetGameSessionList();
+    // Прямой доступ к контейнеру - только когда сессии не добавляются параллельно
     GameSessions& GetGameSessions();
     void SetGameSessions(const GameSessions& game_session);
+    // Тикает сессии последовательно в вызывающем потоке, затем вызывает
+    // tick_signal_. Сервер тикает сессии параллельно в их strand'ах через
+    // app::Coordinator и оповещает подписчиков через NotifyTick
     void Tick(milliseconds time_delta_ms);
+    // Оповещает подписчиков о завершённом тике, если сессии тикали снаружи Game::Tick
+    void NotifyTick(milliseconds time_delta_ms);
     // Добавляем обработчик сигнала tick и возвращаем объект connection для управления,
     // при помощи которого можно отписаться от сигнала
     [[nodiscard]] sig::connection DoOnTick(const TickSignal::slot_type& handler) {
@@ -379,6 +606,7 @@ public:
             return *this;
         randomize_spawn_points_ = other.randomize_spawn_points_;
         maps_ = other.maps_;
+        map_indexes_ = other.map_indexes_;
         extra_data_ = other.extra_data_;
         game_param_ = other.game_param_;
         game_sessions_ = other.game_sessions_;
@@ -393,12 +621,18 @@ private:
     
     bool randomize_spawn_points_ = true;
     Maps maps_;
+    // индекс карты maps_[i] - map_indexes_[i]
+    std::vector<std::shared_ptr<const MapIndex>> map_indexes_;
     ExtraData extra_data_;
     GameParam game_param_;
     GameSessions game_sessions_;
     MapIdToIndex map_id_to_index_;
     MapIdToIndex map_id_to_game_sessions_index_;
+    std::mutex sessions_mutex_;
     TickSignal tick_signal_;
+
+    GameSession* FindGameSessionLocked(const Map::Id& id) noexcept;
+    GameSession* AddGameSessionLocked(const Map::Id& id);
 };
 
 }  // namespace model
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace model {
+
+// Очередь без блокировок: много писателей, один читатель.
+// Писатель добавляет узел в односвязный стек одним CAS и сразу возвращается.
+// Читатель забирает весь стек одной атомарной операцией и разворачивает его,
+// поэтому элементы выдаются в порядке добавления, а ABA невозможна:
+// узлы освобождает только читатель, уже после того как забрал их из очереди.
+// Копия очереди пуста - ожидающие элементы не копируются.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() = default;
+    MpscQueue(const MpscQueue&) noexcept {
+    }
+    MpscQueue& operator=(const MpscQueue&) noexcept {
+        return *this;
+    }
+    ~MpscQueue() {
+        DeleteList(head_.exchange(nullptr, std::memory_order_acquire));
+    }
+
+    // Потокобезопасно
+    void Push(T value) {
+        auto* node = new Node{std::move(value), head_.load(std::memory_order_relaxed)};
+        while (!head_.compare_exchange_weak(node->next, node,
+                std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Вызывается только одним потоком (владельцем очереди).
+    // Передаёт накопленные элементы в fn в порядке добавления
+    template <typename Fn>
+    size_t Drain(Fn&& fn) {
+        Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+        Node* fifo = nullptr;
+        while (node) {
+            fifo = std::exchange(node, std::exchange(node->next, fifo));
+        }
+        size_t count = 0;
+        while (fifo) {
+            std::unique_ptr<Node> current{std::exchange(fifo, fifo->next)};
+            try {
+                fn(std::move(current->value));
+            } catch (...) {
+                DeleteList(fifo);
+                throw;
+            }
+            ++count;
+        }
+        return count;
+    }
+
+    bool Empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+    std::atomic<Node*> head_{nullptr};
+
+    static void DeleteList(Node* node) noexcept {
+        while (node) {
+            delete std::exchange(node, node->next);
+        }
+    }
+};
+
+}  // namespace model
@@ -11,49 +11,79 @@ static auto to_booststr = [](std::string_view str) {
     return boost::string_view(str.data(), str.size());
 };
 
-void Player::Move(std::string_view move_cmd) {
-    model::Move dog_move;
+model::Move MoveFromString(std::string_view move_cmd) {
     if (move_cmd == "L"sv) 
-        dog_move = model::Move::LEFT;
-    else if (move_cmd == "R"sv)
-        dog_move = model::Move::RIGHT;
-    else if (move_cmd == "U"sv)
-        dog_move = model::Move::UP;
-    else if (move_cmd == "D"sv)
-        dog_move = model::Move::DOWN;
-    else 
-        dog_move = model::Move::STAND;
-    session_->MoveDog(dog_->GetId(), dog_move);    
+        return model::Move::LEFT;
+    if (move_cmd == "R"sv)
+        return model::Move::RIGHT;
+    if (move_cmd == "U"sv)
+        return model::Move::UP;
+    if (move_cmd == "D"sv)
+        return model::Move::DOWN;
+    return model::Move::STAND;
+}
+
+void Player::Move(std::string_view move_cmd) {
+    session_->PushMove(dog_id_, MoveFromString(move_cmd));
 }
 
 Player* PlayerTokens::FindPlayer(Token token) const
 {
-    if (token_to_player.contains(token))
-        return token_to_player.at(token);
+    std::shared_lock lock{mutex_};
+    if (auto it = token_to_player.find(token); it != token_to_player.end())
+        return it->second;
     return nullptr;
 }
 
+std::optional<PlayerRef> PlayerTokens::Resolve(const Token& token) const {
+    // игрок удаляется только после своего токена, поэтому под блокировкой он жив
+    std::shared_lock lock{mutex_};
+    if (auto it = token_to_player.find(token); it != token_to_player.end())
+        return it->second->GetRef();
+    return std::nullopt;
+}
+
 Token PlayerTokens::AddPlayer(Player* player)
 {
+    std::unique_lock lock{mutex_};
     Token token{GetToken()};
     token_to_player[token] = player;
+    player_to_token_.insert_or_assign(player->GetId(), token);
     return token;
 }
 
 void PlayerTokens::AddToken(Token token, Player* player) {
+    std::unique_lock lock{mutex_};
     token_to_player[token] = player;
+    player_to_token_.insert_or_assign(player->GetId(), std::move(token));
 }
 
 void PlayerTokens::DeleteToken(const PlayerId& player_id) {
-    for (const auto& [token, player] : token_to_player) {
-        if (player->GetId() == player_id) {
-            token_to_player.erase(token);
-            return;
-        }
+    std::unique_lock lock{mutex_};
+    if (auto it = player_to_token_.find(player_id); it != player_to_token_.end()) {
+        token_to_player.erase(it->second);
+        player_to_token_.erase(it);
     }
 }
 
-const PlayerTokens::TokenToPlayerContainer& PlayerTokens::GetTokens() const {
+std::optional<Token> PlayerTokens::FindToken(const PlayerId& player_id) const {
+    std::shared_lock lock{mutex_};
+    if (auto it = player_to_token_.find(player_id); it != player_to_token_.end())
+        return it->second;
+    return std::nullopt;
+}
+
+PlayerTokens::PlayerToTokenContainer PlayerTokens::MakePlayerIndex(
+        const TokenToPlayerContainer& tokens) {
+    PlayerToTokenContainer index;
+    index.reserve(tokens.size());
+    for (const auto& [token, player] : tokens)
+        index.insert_or_assign(player->GetId(), token);
+    return index;
+}
+
+PlayerTokens::TokenToPlayerContainer PlayerTokens::GetTokens() const {
+    std::shared_lock lock{mutex_};
     return token_to_player;
 }
 
@@ -80,15 +110,16 @@ std::string PlayerTokens::ToHex(uint64_t n) const {
 }
 
 Player* Players::PushPlayer(PlayerContainer&& player) {
-    const size_t index = players_.size();
+    std::unique_lock lock{mutex_};
     if (auto [it, inserted] = players_.emplace(player->GetId(), player); !inserted) {
         throw std::invalid_argument("Player with id "s + player->GetId().ToString() + " already exists"s);
     }
-    return players_.at(player->GetId()).get();
+    dog_to_player_.insert_or_assign(DogKey{player->GetSession(), player->GetDogId()}, player);
+    return player.get();
 }
 
-Player* Players::Add(PlayerId player_id, model::Dog* dog, model::GameSession* session) {
-    auto player = std::make_shared<Player>(player_id, session, dog);
+Player* Players::Add(PlayerId player_id, model::Dog::Id dog_id, model::GameSession* session) {
+    auto player = std::make_shared<Player>(player_id, session, dog_id);
     return PushPlayer(std::move(player));
 }
 
@@ -97,36 +128,40 @@ void Players::Add(PlayerContainer&& player) {
 }
 
 Player* Players::FindPlayer(PlayerId player_id, model::Map::Id map_id) noexcept {
+    std::shared_lock lock{mutex_};
     if (auto it = players_.find(player_id); it != players_.end()) {
-        auto pl = players_.at(player_id).get();
+        auto pl = it->second.get();
         if (pl->MapId() == map_id)
             return pl;
     }
     return nullptr;
 }
-const PlayerId* Players::FindPlayerId(std::string_view player_name) const noexcept {
-    for (const auto& [id, player] : players_) {
-        if (player->GetName() == player_name) {
-            return &player->GetId();
-        }
+Player* Players::FindPlayer(const PlayerId& player_id) const noexcept {
+    std::shared_lock lock{mutex_};
+    if (auto it = players_.find(player_id); it != players_.end()) {
+        return it->second.get();
     }
     return nullptr;
 }
 
-Player* Players::FindPlayer(const PlayerId& player_id) const noexcept {
-    if (auto it = players_.find(player_id); it != players_.end()) {
-        auto pl = players_.at(player_id).get();
-        return pl;
-    }
+Players::PlayerContainer Players::FindPlayerByDog(const model::GameSession* session,
+        const model::Dog::Id& dog_id) const {
+    std::shared_lock lock{mutex_};
+    if (auto it = dog_to_player_.find(DogKey{session, dog_id}); it != dog_to_player_.end())
+        return it->second;
     return nullptr;
 }
 
-const Players::PlayersContainer& Players::GetPlayers() const {
+Players::PlayersContainer Players::GetPlayers() const {
+    std::shared_lock lock{mutex_};
     return players_;
 }
 
 void Players::DeletePlayer(const PlayerId& player_id) noexcept {
+    std::unique_lock lock{mutex_};
     if (auto it = players_.find(player_id); it != players_.end()) {
+        const auto& player = *it->second;
+        dog_to_player_.erase(DogKey{player.GetSession(), player.GetDogId()});
         players_.erase(it);
     }
 }
@@ -4,6 +4,7 @@
 #include <boost/asio/strand.hpp>
 #include <string>
 #include <random>
+#include <shared_mutex>
 #include "model/model.h"
 #include "util/token.h"
 #include "util/tagged_uuid.h"
@@ -22,47 +23,58 @@ namespace detail {
 
 using PlayerId = util::TaggedUUID<detail::PlayerTag>;
 
+// Команда движения из запроса action: "L", "R", "U", "D", иначе - остановка
+model::Move MoveFromString(std::string_view move_cmd);
+
+// Игровая сессия и собака игрока, найденные по токену.
+// Копируется по значению, поэтому остаётся корректной после удаления игрока:
+// сессии не удаляются, а отсутствие собаки проверяется по Dog::Id
+struct PlayerRef {
+    model::GameSession* session = nullptr;
+    model::Dog::Id dog_id{0};
+};
+
 class Player {
 public:
     Player() = default;
-    Player(PlayerId id, model::GameSession* session, model::Dog* dog) :
-        session_(session), dog_(dog), id_(id) {}
+    Player(PlayerId id, model::GameSession* session, model::Dog::Id dog_id) :
+        id_(id), session_(session), dog_id_(dog_id) {}
     const PlayerId& GetId() const {
         return id_;
     }
     const model::Map::Id& MapId() const {
         return session_->MapId();
     }
-    std::string_view GetName() const {
-        return dog_->GetName();
-    }
     const model::GameSession* GetSession() const {
         return session_;
     }
-    const model::Dog* GetDog() const {
-        return dog_;
+    PlayerRef GetRef() const {
+        return PlayerRef{session_, dog_id_};
+    }
+    const model::Dog::Id& GetDogId() const {
+        return dog_id_;
     }
     void Move(std::string_view move_cmd);
     Player(const Player& other) {
         *this = other;
     }
     Player(Player&& other) noexcept {
-        id_ = std::move(id_);
+        id_ = std::move(other.id_);
         session_ = other.session_;
-        dog_ = other.dog_;
+        dog_id_ = other.dog_id_;
     }
     Player& operator=(const Player& other) {
         if (this == &other)
             return *this;
         id_ = other.id_;
         session_ = other.session_;
-        dog_ = other.dog_;
+        dog_id_ = other.dog_id_;
         return *this;
     }
 private:
     PlayerId id_;
     model::GameSession* session_ = nullptr;
-    model::Dog* dog_ = nullptr;
+    model::Dog::Id dog_id_{0};
 };
 } // namespace app
 
@@ -76,25 +88,42 @@ struct TaggedHasher<app::PlayerId> {
 }
 
 namespace app {
+// Все методы потокобезопасны: токены ищутся параллельно из потоков,
+// обслуживающих запросы, а добавляются и удаляются при входе и уходе игроков
 class PlayerTokens {
 public:
     using TokenToPlayerContainer = std::unordered_map<Token, Player*,
         util::TaggedHasher<Token>>;
     Player* FindPlayer(Token token) const;
+    std::optional<PlayerRef> Resolve(const Token& token) const;
     Token AddPlayer(Player* player);
     void AddToken(Token token, Player* player);
     void DeleteToken(const PlayerId& player_id);
-    const TokenToPlayerContainer& GetTokens() const;
+    std::optional<Token> FindToken(const PlayerId& player_id) const;
+    TokenToPlayerContainer GetTokens() const;
     PlayerTokens() = default;
     PlayerTokens(const PlayerTokens& other) {
-        token_to_player = other.token_to_player;
+        token_to_player = other.GetTokens();
+        player_to_token_ = MakePlayerIndex(token_to_player);
     }
     PlayerTokens& operator=(const PlayerTokens& other) {
-        token_to_player = other.token_to_player;
+        if (this == &other)
+            return *this;
+        auto tokens = other.GetTokens();
+        auto index = MakePlayerIndex(tokens);
+        std::unique_lock lock{mutex_};
+        token_to_player = std::move(tokens);
+        player_to_token_ = std::move(index);
         return *this;
     }
 private:
+    using PlayerToTokenContainer = std::unordered_map<PlayerId, Token,
+        util::TaggedHasher<PlayerId>>;
+
+    mutable std::shared_mutex mutex_;
     TokenToPlayerContainer token_to_player;
+    // обратный индекс для DeleteToken, меняется вместе с token_to_player
+    PlayerToTokenContainer player_to_token_;
     std::random_device random_device_;
     std::mt19937_64 generator1_{[this] {
         std::uniform_int_distribution<std::mt19937_64::result_type> dist;
@@ -110,8 +139,11 @@ private:
     // Вы можете поэкспериментировать с алгоритмом генерирования токенов,
     // чтобы сделать их подбор ещё более затруднительным
     std::string ToHex(uint64_t n) const;
+    static PlayerToTokenContainer MakePlayerIndex(const TokenToPlayerContainer& tokens);
 };
 
+// Все методы потокобезопасны. GetPlayers возвращает копию контейнера,
+// объекты игроков разделяются через shared_ptr
 class Players {
 private:
     using PlayerIdHasher = util::TaggedHasher<PlayerId>;
@@ -119,15 +151,29 @@ private:
 public:
     using PlayerContainer = std::shared_ptr<Player>;
     using PlayersContainer = std::unordered_map<PlayerId, PlayerContainer, PlayerIdHasher>;
-    Player* Add(PlayerId player_id, model::Dog *dog, model::GameSession *session);
+    Player* Add(PlayerId player_id, model::Dog::Id dog_id, model::GameSession *session);
     void Add(PlayerContainer&& player);
     Player* FindPlayer(PlayerId player_id, model::Map::Id map_id) noexcept;
-    const PlayerId* FindPlayerId(std::string_view player_name) const noexcept;
     Player* FindPlayer(const PlayerId& player_id) const noexcept;
-    const PlayersContainer& GetPlayers() const;
+    PlayerContainer FindPlayerByDog(const model::GameSession* session,
+        const model::Dog::Id& dog_id) const;
+    PlayersContainer GetPlayers() const;
     void DeletePlayer(const PlayerId& player_id) noexcept;
     
+private:
+    using DogKey = std::pair<const model::GameSession*, model::Dog::Id>;
+    struct DogKeyHasher {
+        size_t operator()(const DogKey& key) const noexcept {
+            size_t seed = std::hash<const model::GameSession*>{}(key.first);
+            boost::hash_combine(seed, *key.second);
+            return seed;
+        }
+    };
+
+    mutable std::shared_mutex mutex_;
     PlayersContainer players_;
+    // индекс для FindPlayerByDog, меняется вместе с players_
+    std::unordered_map<DogKey, PlayerContainer, DogKeyHasher> dog_to_player_;
     Player* PushPlayer(PlayerContainer&& player);
 };
 
@@ -1,10 +1,13 @@
 #include "api_request.h"
+#include <charconv>
 #include <boost/regex.hpp>
+#include "../log.h"
 
 namespace http_handler
 {
 using namespace std::literals;
 using Token = security::Token;
+
 http::status ApiRequestHandler::ErrorCodeToStatus(app::error_code ec) const {
     http::status stat = http::status::ok;
     switch (ec) {
@@ -24,102 +27,137 @@ http::status ApiRequestHandler::ErrorCodeToStatus(app::error_code ec) const {
     return stat;
 }
 
-void ApiRequestHandler::LinkJoinWithoutAuthorize() {
-    auto ptr = uri_handler_.AddEndpoint(Endpoint::JOIN_GAME);
-    if(ptr) {
-        ptr->SetNeedAuthorization(false)
-            .SetAllowedMethods({http::verb::post}, ErrorMessage::POST_IS_EXPECTED, MiscMessage::ALLOWED_POST_METHOD)
-            .SetProcessFunction([&](std::string_view body){
-                return ProcessPostEndpoitWithoutAuthorization(body); 
-            });
-    }
+StringResponse ApiRequestHandler::Handle(const uri_api::StringRequest& req,
+        const http_server::RequestTarget& target) {
+    auto response = Routes::Dispatch(*this, req, target);
+    response.keep_alive(req.keep_alive());
+    response.version(req.version());
+    return response;
 }
-void ApiRequestHandler::LinkPlayersToUriHandler() {
-    auto ptr = uri_handler_.AddEndpoint(Endpoint::PLAYERS_LIST);
-    if(ptr) {
-        ptr->SetNeedAuthorization(true)
-            .SetAllowedMethods({http::verb::get, http::verb::head}, ErrorMessage::GET_IS_EXPECTED, MiscMessage::ALLOWED_GET_HEAD_METHOD)
-            .SetProcessFunction([&](const Token& token, std::string_view body){
-                return ExecuteAuthorizedPost(token, body, [&](const Token& token, std::string_view) {
-                    return app_.GetPlayers(token);
-            });
-        });
-    }
+StringResponse ApiRequestHandler::ProcessPlayers(const Token& token, std::string_view body) {
+    return ExecuteAuthorizedPost(token, body, [&](const Token& token, std::string_view) {
+        return app_.GetPlayers(token);
+    });
 }
 
-void ApiRequestHandler::LinkMapsAndMaps() {
-    auto ptr = uri_handler_.AddEndpoint(Endpoint::MAPS);
-    if (ptr) {
-        ptr->SetNeedAuthorization(false)
-            .SetNeedTargetProcessing(true)
-            .SetAllowedMethods({ http::verb::get, http::verb::head }, ErrorMessage::GET_IS_EXPECTED, MiscMessage::ALLOWED_GET_HEAD_METHOD)
-            .SetProcessFunction([&](std::string_view target, std::string_view body) {
-                // finded maps
-                std::string_view res;
-                auto sz_maps = Endpoint::MAPS.size();
-                if (target.size() != sz_maps)
-                    res = target.substr(sz_maps + 1, target.size() - sz_maps);
-                http::status stat;
-                auto [text, flag] = app_.GetMapBodyJson(res);
-                stat = flag ? http::status::ok : http::status::not_found;
-                return Response::Make(stat, text);
-            });
-    }
+StringResponse ApiRequestHandler::ProcessMaps(std::string_view path) {
+    std::string_view id;
+    if (path.size() > Endpoint::MAPS.size())
+        id = path.substr(Endpoint::MAPS.size() + 1);
+    auto [text, flag] = app_.GetMapBodyJson(id);
+    return Response::Make(flag ? http::status::ok : http::status::not_found, text);
 }
 
-void ApiRequestHandler::LinkGameState() {
-    auto ptr = uri_handler_.AddEndpoint(Endpoint::GAME_STATE);
-    if (ptr) {
-        ptr->SetNeedAuthorization(true)
-            .SetAllowedMethods({ http::verb::get, http::verb::head }, ErrorMessage::GET_IS_EXPECTED, MiscMessage::ALLOWED_GET_HEAD_METHOD)
-            .SetProcessFunction([&](const Token& token, std::string_view body) {
-            return ExecuteAuthorizedPost(token, body, [&](const Token& token, std::string_view) {
-                return app_.GetState(token);
-            });
-        });
+StringResponse ApiRequestHandler::ProcessGameState(const Token& token, 
+        const uri_api::RequestData& request) const {
+    auto [snapshot, err] = app_.GetSessionSnapshot(token);
+    if (err != app::error_code::None)
+        return Response::MakeUnauthorizedErrorUnknownToken();
+    std::optional<uint64_t> since;
+    boost::cmatch what;
+    static const boost::regex since_expr{"(^|&)since=([^&]*)"};
+    if (boost::regex_search(request.query.data(),
+            request.query.data() + request.query.size(), what, since_expr)) {
+        since = ParseUint64(std::string_view{what[2].first, what[2].second});
+        if (!since)
+            return Response::MakeBadRequestInvalidArgument(ErrorMessage::INVALID_SINCE);
     }
+    // при равном качестве остаётся JSON
+    const bool binary = !request.accept.empty()
+        && Negotiation::AcceptQuality(request.accept, app::BinaryState::CONTENT_TYPE)
+            > Negotiation::AcceptQuality(request.accept, Response::ContentType::TEXT_JSON);
+    if (binary && since)
+        return Response::MakeBadRequestInvalidArgument(ErrorMessage::BINARY_SINCE);
+    // версия снимка растёт только при изменении состояния, поэтому
+    // совпадение ETag означает, что клиент уже видел это состояние.
+    // У двоичного представления свой ETag
+    const std::string etag = "\""s + std::to_string(snapshot->version)
+        + (binary ? "b\""s : "\""s);
+    auto make = [&](http::status status, std::string_view body, std::string_view content_type) {
+        auto response = Response::Make(status, body, content_type);
+        response.set(http::field::etag, etag);
+        response.set(http::field::vary, "Accept"sv);
+        return response;
+    };
+    if (Negotiation::ETagMatches(request.if_none_match, etag))
+        return make(http::status::not_modified, ""sv, Response::ContentType::TEXT_JSON);
+    if (binary)
+        return make(http::status::ok, app::App::GetStateBinary(*snapshot), app::BinaryState::CONTENT_TYPE);
+    if (since)
+        return make(http::status::ok, app::App::GetStateDelta(*snapshot, *since), Response::ContentType::TEXT_JSON);
+    return make(http::status::ok, app::App::GetStateBody(*snapshot), Response::ContentType::TEXT_JSON);
 }
 
-void ApiRequestHandler::LinkGameActionMove() {
-    auto ptr = uri_handler_.AddEndpoint(Endpoint::GAME_ACTION);
-    if (ptr) {
-        ptr->SetNeedAuthorization(true)
-            .SetAllowedMethods({ http::verb::post }, ErrorMessage::POST_IS_EXPECTED, MiscMessage::ALLOWED_POST_METHOD)
-            .SetProcessFunction([&](const Token& token, std::string_view body) {
-            return ExecuteAuthorizedPost(token, body, [&](const Token& token, std::string_view body) {
-                return app_.ActionMove(token, body);
-            });
-        });
+SharedResponse ApiRequestHandler::MakePrecomputedResponse(
+        std::shared_ptr<const app::PrecomputedBody> body, bool head,
+        std::string_view if_none_match, std::string_view accept_encoding,
+        unsigned version, bool keep_alive) {
+    const bool gzip = Negotiation::AcceptsEncoding(accept_encoding, "gzip"sv);
+    const auto& etag = gzip ? body->gzip_etag : body->etag;
+    SharedResponse response;
+    response.version(version);
+    response.keep_alive(keep_alive);
+    response.set(http::field::cache_control, MiscDefs::NO_CACHE);
+    response.set(http::field::etag, etag);
+    response.set(http::field::vary, "Accept-Encoding"sv);
+    if (Negotiation::ETagMatches(if_none_match, etag)) {
+        response.result(http::status::not_modified);
+        return response;
     }
+    response.result(http::status::ok);
+    response.set(http::field::content_type, Response::ContentType::TEXT_JSON);
+    if (gzip)
+        response.set(http::field::content_encoding, "gzip"sv);
+    // тело не копируется: ответ владеет готовыми данными через общий указатель
+    const std::string& data = gzip ? body->gzip : body->body;
+    response.content_length(data.size());
+    if (!head)
+        response.body() = std::shared_ptr<const std::string>(std::move(body), &data);
+    return response;
 }
 
-void ApiRequestHandler::LinkGameTick() {
-    auto ptr = uri_handler_.AddEndpoint(Endpoint::GAME_TICK);
-    if (ptr) {
-        ptr->SetNeedAuthorization(false)
-            .SetAllowedMethods({ http::verb::post }, ErrorMessage::POST_IS_EXPECTED, MiscMessage::ALLOWED_POST_METHOD)
-            .SetProcessFunction([&](std::string_view body) {
-                auto [text, err] = app_.Tick(body);
-                return Response::Make(ErrorCodeToStatus(err), text);
-        });
-    }
+std::optional<uint64_t> ApiRequestHandler::ParseUint64(std::string_view str) {
+    uint64_t value = 0;
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec != std::errc{} || ptr != str.data() + str.size() || str.empty())
+        return std::nullopt;
+    return value;
 }
 
-void ApiRequestHandler::LinkRetiredPlayers() {
-    auto ptr = uri_handler_.AddEndpoint(Endpoint::RECORDS);
-    if (ptr) {
-        ptr->SetNeedAuthorization(false)
-            .SetAllowedMethods({ http::verb::get, http::verb::head }, ErrorMessage::GET_IS_EXPECTED, MiscMessage::ALLOWED_GET_HEAD_METHOD)
-            .SetProcessFunction([&](std::string_view params) {
-            std::string str{params.data(), params.size()};
-            int start = GetIntUrlParam(str, "start"s, Param::START);
-            int max_items = GetIntUrlParam(str, "max[Ii]tems"s, Param::MAX_ITEMS);
-            if (start == -1 || max_items == -1 || max_items > Param::MAX_ITEMS)
-                return Response::Make(http::status::bad_request, "");
-            auto [text, err] = app_.GetRecords(start, max_items);
-            return Response::Make(ErrorCodeToStatus(err), text);
-        });
-    }
+StringResponse ApiRequestHandler::ProcessAction(const Token& token, std::string_view body) {
+    return ExecuteAuthorizedPost(token, body, [&](const Token& token, std::string_view body) {
+        return app_.ActionMove(token, body);
+    });
+}
+
+StringResponse ApiRequestHandler::ProcessTick(std::string_view body) {
+    // при заданном --tick-period тик управляется сервером
+    if (!on_tick_api_)
+        return Response::MakeJSON(http::status::bad_request,
+            ErrorCode::BAD_REQUEST, ErrorMessage::INVALID_ENDPOINT);
+    auto [text, err] = app_.Tick(body);
+    return Response::Make(ErrorCodeToStatus(err), text);
+}
+
+StringResponse ApiRequestHandler::ProcessRecords(std::string_view query) {
+    std::string str{query.data(), query.size()};
+    int start = GetIntUrlParam(str, "start"s, Param::START);
+    int max_items = GetIntUrlParam(str, "max[Ii]tems"s, Param::MAX_ITEMS);
+    if (start == -1 || max_items == -1 || max_items > Param::MAX_ITEMS)
+        return Response::Make(http::status::bad_request, "");
+    auto [text, err] = app_.GetRecords(start, max_items);
+    return Response::Make(ErrorCodeToStatus(err), text);
+}
+
+defs::TypeRequest ApiRequestHandler::GetRequestType(std::string_view path) {
+    const auto index = Routes::Find(path);
+    if (index == Routes::NOT_FOUND)
+        return path.starts_with(Endpoint::CHECK_VERSION) ? defs::TypeRequest::None : defs::TypeRequest::BadVersion;
+    const auto type = Routes::GetType(index);
+    // /maps/{id} - описание одной карты
+    if (type == defs::TypeRequest::Maps && path.size() > Endpoint::MAPS.size() + 1)
+        return defs::TypeRequest::Map;
+    return type;
 }
 
 int ApiRequestHandler::GetIntUrlParam(const std::string& params, 
@@ -7,7 +7,9 @@
 #include "response.h"
 #include "defs.h"
 #include "uri_api.h"
+#include "negotiation.h"
 #include "../app.h"
+#include "../binary_state.h"
 
 namespace http_handler
 {
@@ -15,33 +17,15 @@ namespace net = boost::asio;
 using namespace defs;
 class ApiRequestHandler
 {
-    using Strand = net::strand<net::io_context::executor_type>;
     http::status ErrorCodeToStatus(app::error_code ec) const;
     int GetIntUrlParam(const std::string& params, 
         const std::string& name, int def_value) const;
 
 public:
-    ApiRequestHandler(Strand api_strand, app::App& app, bool on_tick_api)
-    : uri_handler_()
-    , api_strand_(api_strand)
-    , app_(app)
+    ApiRequestHandler(app::App& app, bool on_tick_api)
+    : app_(app)
+    , on_tick_api_(on_tick_api)
     {
-        ///----------- Register endpoints here ----------------------
-        //Add endpoint without authorization and with POST allowed methods
-        LinkJoinWithoutAuthorize();
-        //Add players list with GET only and authorization
-        LinkPlayersToUriHandler();
-        //Add map and maps request 
-        LinkMapsAndMaps();
-        //Add game state request
-        LinkGameState();
-        //Add game action move
-        LinkGameActionMove();
-        //Add retired players request
-        LinkRetiredPlayers();
-        //Add tick if period tick is not specified
-        if (on_tick_api)
-            LinkGameTick();
     };
 
     template <typename Body, typename Allocator>
@@ -52,31 +36,51 @@ public:
 
     StringResponse ProcessPostEndpoitWithoutAuthorization(std::string_view body);
 
-    template <typename Body, typename Allocator>
-    StringResponse ProcessGameRequest(const http::request<Body, http::basic_fields<Allocator>>& req)
-    {
-        return uri_handler_.Process(req);
-    }
-
     template <typename Body, typename Allocator>
     bool IsGameRequest(http::request<Body, http::basic_fields<Allocator>>& req)
     {
         return req.target().starts_with(Endpoint::GAME);
     }
 
-    template <typename Body, typename Allocator>
-    auto HandleGameRequest(const http::request<Body, http::basic_fields<Allocator>>& req)
-    {
-        auto response = ProcessGameRequest(req);
-        response.keep_alive(req.keep_alive());
-        response.version(req.version());
-        return response;
-    }
-    template <typename Body, typename Allocator>
-    StringResponse Handle(const http::request<Body, http::basic_fields<Allocator>>& req)
-    {
-        return std::move(HandleGameRequest(req));
+    // Ответ на запрос к API по таблице маршрутов
+    StringResponse Handle(const uri_api::StringRequest& req, const http_server::RequestTarget& target);
+    // Endpoint API по декодированному пути запроса
+    static defs::TypeRequest GetRequestType(std::string_view path);
+    // Быстрый путь GET и HEAD для /maps и /maps/{id}: тела карт построены
+    // при запуске, ответ - поиск в хеш-таблице и отправка готового тела.
+    // Возвращает false, если запрос не к картам (send не вызывается)
+    template <typename Body, typename Allocator, typename Send>
+    bool HandleMaps(const http::request<Body, http::basic_fields<Allocator>>& req,
+            std::string_view target, Send&& send) const {
+        if (req.method() != http::verb::get && req.method() != http::verb::head)
+            return false;
+        std::shared_ptr<const app::PrecomputedBody> body;
+        if (target == Endpoint::MAPS || target.substr(Endpoint::MAPS.size()) == "/"sv) {
+            body = app_.GetMapBodies().GetMaps();
+        } else if (target.starts_with(Endpoint::MAPS) && target[Endpoint::MAPS.size()] == '/') {
+            body = app_.GetMapBodies().GetMap(target.substr(Endpoint::MAPS.size() + 1));
+            if (!body) {
+                auto response = Response::MakeJSON(http::status::not_found,
+                    ErrorCode::MAP_NOT_FOUND, ErrorMessage::MAP_NOT_FOUND);
+                response.version(req.version());
+                response.keep_alive(req.keep_alive());
+                send(std::move(response));
+                return true;
+            }
+        } else {
+            return false;
+        }
+        send(MakePrecomputedResponse(std::move(body), req.method() == http::verb::head,
+            req.base()[http::field::if_none_match], req.base()[http::field::accept_encoding],
+            req.version(), req.keep_alive()));
+        return true;
     }
+    // Ответ с готовым телом: gzip-копия, если клиент её принимает,
+    // 304 при совпадении ETag, для HEAD - только заголовки
+    static SharedResponse MakePrecomputedResponse(std::shared_ptr<const app::PrecomputedBody> body,
+        bool head, std::string_view if_none_match, std::string_view accept_encoding,
+        unsigned version, bool keep_alive);
+
     template <typename Fn>
     StringResponse ExecuteAuthorizedPost(
             const security::Token& token, std::string_view body, Fn&& action) const {
@@ -88,17 +92,48 @@ public:
     }
 
 private:
-    uri_api::UriData uri_handler_;
-    Strand api_strand_;
     app::App &app_;
+    // без --tick-period доступен endpoint тика
+    bool on_tick_api_;
 
-    void LinkJoinWithoutAuthorize();
-    void LinkPlayersToUriHandler();
-    void LinkMapsAndMaps();
-    void LinkGameState();
-    void LinkGameActionMove();
-    void LinkGameTick();
-    void LinkRetiredPlayers();
+    StringResponse ProcessPlayers(const security::Token& token, std::string_view body);
+    // path - /maps или /maps/{id}
+    StringResponse ProcessMaps(std::string_view path);
+    // Ответ state с ETag по версии снимка: If-None-Match - 304,
+    // ?since=<версия> - только изменения после этой версии.
+    // Если Accept предпочитает application/x-game-state, отдаётся полное
+    // состояние в двоичном виде. Двоичной дельты нет: since вместе с ним -
+    // 400, иначе клиент принял бы полное состояние за изменения
+    StringResponse ProcessGameState(const security::Token& token,
+        const uri_api::RequestData& request) const;
+    StringResponse ProcessAction(const security::Token& token, std::string_view body);
+    StringResponse ProcessTick(std::string_view body);
+    StringResponse ProcessRecords(std::string_view query);
+    static std::optional<uint64_t> ParseUint64(std::string_view str);
 
+    // Маршруты API: путь, методы, авторизация, аргумент обработчика
+    using Routes = uri_api::Router<ApiRequestHandler,
+        uri_api::Route<Endpoint::JOIN_GAME, defs::TypeRequest::Join, uri_api::Match::Exact,
+            uri_api::PostOnly, uri_api::NoAuthorization, uri_api::BodyArg,
+            &ApiRequestHandler::ProcessPostEndpoitWithoutAuthorization>,
+        uri_api::Route<Endpoint::PLAYERS_LIST, defs::TypeRequest::Players, uri_api::Match::Exact,
+            uri_api::GetHead, uri_api::BearerAuthorization, uri_api::BodyArg,
+            &ApiRequestHandler::ProcessPlayers>,
+        uri_api::Route<Endpoint::MAPS, defs::TypeRequest::Maps, uri_api::Match::Prefix,
+            uri_api::GetHead, uri_api::NoAuthorization, uri_api::PathArg,
+            &ApiRequestHandler::ProcessMaps>,
+        uri_api::Route<Endpoint::GAME_STATE, defs::TypeRequest::State, uri_api::Match::Exact,
+            uri_api::GetHead, uri_api::BearerAuthorization, uri_api::RequestDataArg,
+            &ApiRequestHandler::ProcessGameState>,
+        uri_api::Route<Endpoint::GAME_ACTION, defs::TypeRequest::Action, uri_api::Match::Exact,
+            uri_api::PostOnly, uri_api::BearerAuthorization, uri_api::BodyArg,
+            &ApiRequestHandler::ProcessAction>,
+        uri_api::Route<Endpoint::RECORDS, defs::TypeRequest::Records, uri_api::Match::Exact,
+            uri_api::GetHead, uri_api::NoAuthorization, uri_api::QueryArg,
+            &ApiRequestHandler::ProcessRecords>,
+        uri_api::Route<Endpoint::GAME_TICK, defs::TypeRequest::Tick, uri_api::Match::Exact,
+            uri_api::PostOnly, uri_api::NoAuthorization, uri_api::BodyArg,
+            &ApiRequestHandler::ProcessTick>
+    >;
 };
 }
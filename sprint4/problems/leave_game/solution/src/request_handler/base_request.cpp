@@ -73,14 +73,15 @@ StringResponse BaseRequestHandler::MakeInvalidApiVersion(unsigned http_version,
     return resp;
 }
 
-FileRequestResult BaseRequestHandler::Handle(const StringRequest& req) const {
+FileRequestResult BaseRequestHandler::Handle(const StringRequest& req,
+        const http_server::RequestTarget& target) const {
     // Format response
     try {
         switch (req.method()) {
         case http::verb::get:
-            return MakeGetResponse(req, true);
+            return MakeGetResponse(req, target, true);
         case http::verb::head:
-            return MakeGetResponse(req, false);
+            return MakeGetResponse(req, target, false);
         case http::verb::post:
             return MakePostResponse(req);
         case http::verb::delete_:
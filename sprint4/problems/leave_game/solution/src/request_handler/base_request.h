@@ -8,6 +8,10 @@
 #include <iostream>
 #include <variant>
 
+#include "response.h"
+#include "../file_range_body.h"
+#include "../request_target.h"
+
 namespace http_handler {
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
@@ -20,9 +24,10 @@ using namespace std::literals;
 using StringRequest = http::request<http::string_body>;
 // ќтвет, тело которого представлено в виде строки
 using StringResponse = http::response<http::string_body>;
-using FileResponse = http::response<http::file_body>;
+// Ответ с участком файла; на Linux отправляется через sendfile
+using FileResponse = http::response<http_server::FileRangeBody>;
 using EmptyResponse = http::response<http::empty_body>;
-using FileRequestResult = std::variant<EmptyResponse, StringResponse, FileResponse>;
+using FileRequestResult = std::variant<EmptyResponse, StringResponse, FileResponse, SharedResponse>;
 
 
 enum class TypeRequest {
@@ -92,14 +97,15 @@ private:
 class BaseRequestHandler {
 public:
     virtual ~BaseRequestHandler() {}
-    FileRequestResult Handle(const StringRequest& req) const;
+    FileRequestResult Handle(const StringRequest& req, const http_server::RequestTarget& target) const;
     static StringResponse MakeStringResponse(
         http::status status, std::string_view requestTarget, unsigned http_version,
         bool keep_alive, std::string_view content_type = ContentType::APP_JSON,
         bool no_cache = false);
 
 protected:
-    virtual FileRequestResult MakeGetResponse(const StringRequest& req, bool with_body) const = 0;
+    virtual FileRequestResult MakeGetResponse(const StringRequest& req,
+        const http_server::RequestTarget& target, bool with_body) const = 0;
     virtual FileRequestResult MakePostResponse(const StringRequest& req) const = 0;
     virtual FileRequestResult MakeOptionsResponse(const StringRequest& req) const = 0;
     virtual FileRequestResult MakePutResponse(const StringRequest& req) const = 0;
@@ -14,8 +14,12 @@ enum class TypeRequest {
     Players,
     State,
     Action,
+    Records,
     BadVersion,
-    Tick
+    Tick,
+    Metrics,
+    TickProfile,
+    Trace
 };
 
 struct ServerMessage
@@ -51,6 +55,7 @@ struct ErrorCode
     static inline constexpr std::string_view INVALID_TOKEN = "invalidToken"sv;
     static inline constexpr std::string_view UNKNOWN_TOKEN = "unknownToken"sv;
     static inline constexpr std::string_view MAP_NOT_FOUND = "mapNotFound"sv;
+    static inline constexpr std::string_view NOT_FOUND = "notFound"sv;
 };
 
 struct ErrorMessage
@@ -66,6 +71,10 @@ struct ErrorMessage
     static inline constexpr std::string_view INVALID_NAME = "Invalid name"sv;
     static inline constexpr std::string_view FAIL_PARSE_ACTION = "Failed to parse action"sv;
     static inline constexpr std::string_view FAIL_PARSE_TICK_JSON = "Failed to parse tick request JSON"sv;
+    static inline constexpr std::string_view INVALID_SINCE = "Invalid since parameter"sv;
+    static inline constexpr std::string_view BINARY_SINCE = "The since parameter is not supported for the binary state"sv;
+    static inline constexpr std::string_view ADMIN_DISABLED = "Admin endpoints are disabled"sv;
+    static inline constexpr std::string_view INVALID_ADMIN_TOKEN = "Admin token is missing or invalid"sv;
 };
 
 struct ThrowMessage {
@@ -77,6 +86,11 @@ struct ThrowMessage {
 struct MiscDefs
 {
     static inline constexpr std::string_view NO_CACHE = "no-cache"sv;
+    // файлы с отпечатком содержимого в имени не меняются
+    static inline constexpr std::string_view IMMUTABLE = "public, max-age=31536000, immutable"sv;
+    static inline constexpr std::string_view BYTES = "bytes"sv;
+    // текстовый формат метрик Prometheus
+    static inline constexpr std::string_view PROMETHEUS_TEXT = "text/plain; version=0.0.4; charset=utf-8"sv;
 };
 
 struct MiscMessage
@@ -97,6 +111,15 @@ struct Endpoint
     static inline constexpr std::string_view GAME_STATE     = "/api/v1/game/state"sv;
     static inline constexpr std::string_view RECORDS        = "/api/v1/game/records"sv;
     static inline constexpr std::string_view GAME_ACTION    = "/api/v1/game/player/action"sv;
+    static inline constexpr std::string_view GAME_WS        = "/api/v1/game/ws"sv;
+    // служебные endpoint'ы ниже требуют токена администратора
+    static inline constexpr std::string_view METRICS        = "/metrics"sv;
+    // профиль тиков для администратора, JSON
+    static inline constexpr std::string_view TICK_PROFILE   = "/admin/tick-profile"sv;
+    // трассировка: GET - события в формате Chrome Trace Event, POST start/stop - включение
+    static inline constexpr std::string_view TRACE          = "/admin/trace"sv;
+    static inline constexpr std::string_view TRACE_START    = "/admin/trace/start"sv;
+    static inline constexpr std::string_view TRACE_STOP     = "/admin/trace/stop"sv;
 };
 
 struct Param {
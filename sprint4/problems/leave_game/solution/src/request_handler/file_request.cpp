@@ -1,22 +1,8 @@
 #include "file_request.h"
-#include <boost/algorithm/string.hpp>
 #include "../app.h"
-#include "../http_server.h"
+#include "negotiation.h"
 
 namespace http_handler {
-TypeRequest FileRequestHandler::ParseTarget(std::string_view target, std::string& res) const {
-    std::string_view api = Endpoint::API;
-    res = "";
-    std::string uriDecode = http_server::uriDecode(target);
-    // request stitic files
-    auto pos = target.find(api);
-    if (pos == target.npos) {
-        res = target;
-        return TypeRequest::StaticFiles;
-    }
-    return TypeRequest::None;
-}
-
 fs::path FileRequestHandler::CheckStaticPath(const fs::path& path_static) {
     auto path = fs::weakly_canonical(path_static);
     if (!fs::is_directory(path)) {
@@ -27,74 +13,128 @@ fs::path FileRequestHandler::CheckStaticPath(const fs::path& path_static) {
     return path;
 }
 
-bool FileRequestHandler::CheckFileExist(std::string& file) const {
-    std::string fileName = fs::path(file).filename().string();
-    auto path = fs::path(file).parent_path();
-    for (const auto& entry : fs::directory_iterator{ path }) {
-        std::string fn = entry.path().filename().string();
-        if (boost::iequals(fn, fileName)) {
-            file = entry.path().string();
-            return true;
-        }
+bool FileRequestHandler::IsSafeTarget(std::string_view target) {
+    for (const auto& part : fs::path(target).lexically_normal()) {
+        if (part == "..")
+            return false;
     }
-    return false;
+    return true;
 }
-bool FileRequestHandler::FileInRootStaticDir(std::string_view file) const {
-    auto path = fs::weakly_canonical(file).string();
-    if (path.find(static_path_.string()) == 0)
-        return true;
+
+bool FileRequestHandler::NotModified(const StringRequest& req, const StaticIndex::File& file) {
+    // If-None-Match важнее If-Modified-Since
+    if (auto it = req.find(http::field::if_none_match); it != req.end())
+        return Negotiation::ETagMatches(it->value(), file.etag);
+    if (auto it = req.find(http::field::if_modified_since); it != req.end()) {
+        auto since = Negotiation::ParseHttpDate(it->value());
+        return since && file.modified <= *since;
+    }
     return false;
 }
 
 FileRequestResult FileRequestHandler::StaticFilesResponse(
-    std::string_view target, bool with_body,
-    unsigned http_version, bool keep_alive) const {
+    const StringRequest& req, std::string_view target, bool with_body) const {
     const auto text_response = [&](http::status status, std::string_view text) {
-        return MakeStringResponse(status, text, http_version,
-            keep_alive, ContentType::TEXT_PLAIN);
+        return MakeStringResponse(status, text, req.version(),
+            req.keep_alive(), ContentType::TEXT_PLAIN);
     };
     if (target == "/")
         target = "/index.html";
-    std::string fullName = static_path_.string() + target.data();
-    if (!FileInRootStaticDir(fullName))
+    if (!IsSafeTarget(target))
         return text_response(http::status::bad_request, "Bad Request");
-    if (!CheckFileExist(fullName))
+    // файлы ищутся в индексе, построенном при запуске
+    auto found = index_->Find(target);
+    if (!found)
         return text_response(http::status::not_found, "File not found");
-    http::file_body::value_type file;
-    if (sys::error_code ec; file.open(fullName.c_str(), beast::file_mode::read, ec), ec) {
+    // сжатое представление отдаётся клиентам, принимающим gzip
+    const bool gzipped = found->gzip
+        && Negotiation::AcceptsEncoding(req[http::field::accept_encoding], "gzip"sv);
+    const auto& indexed = gzipped ? found->gzip : found;
+    const auto set_headers = [&](auto& res, http::status status) {
+        res.version(req.version());
+        res.result(status);
+        res.keep_alive(req.keep_alive());
+        res.set(http::field::etag, indexed->etag);
+        res.set(http::field::last_modified, indexed->last_modified);
+        res.set(http::field::cache_control,
+            indexed->fingerprinted ? MiscDefs::IMMUTABLE : MiscDefs::NO_CACHE);
+        res.set(http::field::accept_ranges, MiscDefs::BYTES);
+        if (found->gzip)
+            res.set(http::field::vary, "Accept-Encoding"sv);
+    };
+    if (NotModified(req, *indexed)) {
+        EmptyResponse res;
+        set_headers(res, http::status::not_modified);
+        return std::move(res);
+    }
+    // диапазон учитывается, только если If-Range совпадает с текущей версией
+    auto range = Negotiation::ParseRange(req[http::field::range], indexed->size);
+    if (auto it = req.find(http::field::if_range); it != req.end()
+            && it->value() != indexed->etag && it->value() != indexed->last_modified)
+        range = {};
+    using RangeStatus = Negotiation::ByteRange::Status;
+    if (range.status == RangeStatus::Unsatisfiable) {
+        StringResponse res;
+        set_headers(res, http::status::range_not_satisfiable);
+        res.set(http::field::content_range, "bytes */"s + std::to_string(indexed->size));
+        res.content_length(0);
+        return std::move(res);
+    }
+    const bool partial = range.status == RangeStatus::Satisfiable;
+    const uint64_t offset = partial ? range.first : 0;
+    const uint64_t size = partial ? range.last - range.first + 1 : indexed->size;
+    const auto status = partial ? http::status::partial_content : http::status::ok;
+    const auto set_content = [&](auto& res) {
+        set_headers(res, status);
+        res.set(http::field::content_type, indexed->content_type);
+        if (gzipped)
+            res.set(http::field::content_encoding, "gzip"sv);
+        if (partial) {
+            res.set(http::field::content_range, "bytes "s + std::to_string(range.first) + '-'
+                + std::to_string(range.last) + '/' + std::to_string(indexed->size));
+        }
+        res.content_length(size);
+    };
+    if (!with_body) {
+        EmptyResponse res;
+        set_content(res);
+        return std::move(res);
+    }
+    if (indexed->data && !partial) {
+        // небольшие файлы отдаются из памяти без копирования
+        SharedResponse res;
+        set_content(res);
+        res.body() = indexed->data;
+        return std::move(res);
+    }
+    if (indexed->data) {
+        StringResponse res;
+        set_content(res);
+        res.body().assign(*indexed->data, static_cast<size_t>(offset), static_cast<size_t>(size));
+        return std::move(res);
+    }
+    // большие файлы отправляются с диска; на Linux - через sendfile
+    FileResponse res;
+    if (sys::error_code ec; res.body().file.open(indexed->path.c_str(), beast::file_mode::read, ec), ec) {
         return text_response(http::status::gone,
-            app::JsonMessage("Gone"sv, "Failed to open file "s + fullName));
+            app::JsonMessage("Gone"sv, "Failed to open file "s + indexed->path.string()));
     }
-    http::response<http::file_body> res;
-    res.version(http_version);
-    res.result(http::status::ok);
-    std::string ext = fs::path(fullName).extension().string();
-    res.set(http::field::content_type, ContentType::get(ext).data());
-
-    if (with_body)
-        res.body() = std::move(file);
-    // Метод prepare_payload заполняет заголовки Content-Length и Transfer-Encoding
-    // в зависимости от свойств тела сообщения
-    res.prepare_payload();
+    res.body().offset = offset;
+    res.body().size = size;
+    set_content(res);
     return std::move(res);
 }
 
 
-FileRequestResult FileRequestHandler::MakeGetResponse(const StringRequest& req, bool with_body) const {
-    const auto text_response = [&](http::status status, std::string_view text) {
-        return MakeStringResponse(status, text, req.version(), req.keep_alive());
-    };
-    std::string target;
-    switch (ParseTarget(req.target(), target)) {
-    case TypeRequest::StaticFiles:
-        return StaticFilesResponse(target, with_body, req.version(),
-            req.keep_alive());
-    default:
-        // if bad URI
-        return text_response(http::status::bad_request,
-            with_body ? app::JsonMessage("badRequest", "Get/Head tagret(in file) not found") : ""s
-        );
-    }
+FileRequestResult FileRequestHandler::MakeGetResponse(const StringRequest& req,
+        const http_server::RequestTarget& target, bool with_body) const {
+    // статические файлы - всё, что не относится к API
+    if (target.Path().find(Endpoint::API) == std::string_view::npos)
+        return StaticFilesResponse(req, target.Path(), with_body);
+    // if bad URI
+    return MakeStringResponse(http::status::bad_request,
+        with_body ? app::JsonMessage("badRequest", "Get/Head tagret(in file) not found") : ""s,
+        req.version(), req.keep_alive());
 }
 
 FileRequestResult FileRequestHandler::MakePostResponse(const StringRequest& req) const {
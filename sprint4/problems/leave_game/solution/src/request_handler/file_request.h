@@ -3,6 +3,7 @@
 #include "response.h"
 #include "defs.h"
 #include "base_request.h"
+#include "static_index.h"
 
 namespace http_handler {
 namespace fs = std::filesystem;
@@ -11,15 +12,21 @@ using namespace defs;
 class FileRequestHandler : public BaseRequestHandler {
 private:
 	const fs::path static_path_;
+	std::shared_ptr<StaticIndex> index_;
 
 public:
-	FileRequestHandler(const fs::path& static_path)
-		: static_path_{ CheckStaticPath(static_path) } {}
+	FileRequestHandler(const fs::path& static_path,
+			uint64_t cache_file_limit = StaticIndex::DEFAULT_CACHE_FILE_LIMIT)
+		: static_path_{ CheckStaticPath(static_path) }
+		, index_{ std::make_shared<StaticIndex>(static_path_, cache_file_limit) } {}
     virtual ~FileRequestHandler() {}
+    // Обновлять индекс статических файлов при изменениях каталога
+    void Watch(net::io_context& ioc) {
+        index_->Watch(ioc);
+    }
 private: 
-    TypeRequest ParseTarget(std::string_view target, std::string& res) const;
-    virtual FileRequestResult MakeGetResponse(
-        const StringRequest& req, bool with_body) const override;
+    virtual FileRequestResult MakeGetResponse(const StringRequest& req,
+        const http_server::RequestTarget& target, bool with_body) const override;
 	virtual FileRequestResult MakePostResponse(
         const StringRequest& req) const override;
     virtual FileRequestResult MakeOptionsResponse(
@@ -31,10 +38,13 @@ private:
     virtual FileRequestResult MakeDeleteResponse(
         const StringRequest& req) const override;
 	static fs::path CheckStaticPath(const fs::path& path_static);
-	FileRequestResult StaticFilesResponse(
-		std::string_view responseText, bool with_body,
-		unsigned http_version, bool keep_alive) const;
-	bool CheckFileExist(std::string& file) const;
-	bool FileInRootStaticDir(std::string_view file) const;
+	// Отдаёт файл с учётом условных заголовков (If-None-Match,
+	// If-Modified-Since) и одного диапазона Range
+	FileRequestResult StaticFilesResponse(const StringRequest& req,
+		std::string_view target, bool with_body) const;
+	// Не изменился ли файл с версии, которая есть у клиента
+	static bool NotModified(const StringRequest& req, const StaticIndex::File& file);
+	// Путь не выходит за корень каталога (нет перехода "..")
+	static bool IsSafeTarget(std::string_view target);
 };
 } // namespace http_handler
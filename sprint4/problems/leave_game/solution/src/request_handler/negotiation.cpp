@@ -0,0 +1,164 @@
+#include "negotiation.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <time.h>
+
+namespace http_handler {
+using namespace std::literals;
+
+namespace {
+std::string_view Trim(std::string_view str) {
+    const auto begin = str.find_first_not_of(" \t");
+    if (begin == std::string_view::npos)
+        return std::string_view{};
+    return str.substr(begin, str.find_last_not_of(" \t") - begin + 1);
+}
+
+// Обходит элементы списка вида "значение;q=0.5, значение" и передаёт
+// в fn значение и его качество q (по умолчанию 1)
+template <typename Fn>
+void ForEachWeighted(std::string_view list, Fn&& fn) {
+    while (!list.empty()) {
+        const auto comma = list.find(',');
+        auto item = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+        const auto semicolon = item.find(';');
+        double q = 1.0;
+        auto params = semicolon == std::string_view::npos ? std::string_view{} : item.substr(semicolon + 1);
+        while (!params.empty()) {
+            const auto next = params.find(';');
+            auto param = Trim(params.substr(0, next));
+            params = next == std::string_view::npos ? std::string_view{} : params.substr(next + 1);
+            if (param.starts_with("q="sv)) {
+                param.remove_prefix(2);
+                auto [ptr, ec] = std::from_chars(param.data(), param.data() + param.size(), q);
+                if (ec != std::errc{})
+                    q = 0.0;
+            }
+        }
+        fn(Trim(item.substr(0, semicolon)), q);
+    }
+}
+}  // namespace
+
+bool Negotiation::ETagMatches(std::string_view if_none_match, std::string_view etag) {
+    if_none_match = Trim(if_none_match);
+    if (if_none_match == "*"sv)
+        return true;
+    while (!if_none_match.empty()) {
+        const auto comma = if_none_match.find(',');
+        auto tag = Trim(if_none_match.substr(0, comma));
+        // If-None-Match сравнивается слабо: W/"1" совпадает с "1"
+        if (tag.starts_with("W/"sv))
+            tag.remove_prefix(2);
+        if (tag == etag)
+            return true;
+        if (comma == std::string_view::npos)
+            break;
+        if_none_match.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+double Negotiation::AcceptQuality(std::string_view accept, std::string_view type) {
+    const auto slash = type.find('/');
+    // 0 - диапазон не подходит, 1 - "*/*", 2 - "тип/*", 3 - точное совпадение
+    int best_match = 0;
+    double quality = 0.0;
+    ForEachWeighted(accept, [&](std::string_view media, double q) {
+        int match = 0;
+        if (media == type)
+            match = 3;
+        else if (media.size() == slash + 2 && media.starts_with(type.substr(0, slash + 1))
+                && media.back() == '*')
+            match = 2;
+        else if (media == "*/*"sv)
+            match = 1;
+        if (match > best_match) {
+            best_match = match;
+            quality = q;
+        }
+    });
+    return quality;
+}
+
+bool Negotiation::AcceptsEncoding(std::string_view accept_encoding, std::string_view coding) {
+    // 0 - не упомянуто, 1 - "*", 2 - явно
+    int best_match = 0;
+    double quality = 0.0;
+    ForEachWeighted(accept_encoding, [&](std::string_view value, double q) {
+        int match = value == coding ? 2 : value == "*"sv ? 1 : 0;
+        if (match > best_match) {
+            best_match = match;
+            quality = q;
+        }
+    });
+    return quality > 0.0;
+}
+
+std::string Negotiation::FormatHttpDate(std::time_t time) {
+    std::tm tm{};
+    gmtime_r(&time, &tm);
+    char buffer[32];
+    const auto size = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return std::string(buffer, size);
+}
+
+std::optional<std::time_t> Negotiation::ParseHttpDate(std::string_view date) {
+    // strptime требует строку с завершающим нулём
+    char buffer[32];
+    date = Trim(date);
+    if (date.size() >= sizeof(buffer))
+        return std::nullopt;
+    std::memcpy(buffer, date.data(), date.size());
+    buffer[date.size()] = '\0';
+    std::tm tm{};
+    const char* end = strptime(buffer, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (!end || *end != '\0')
+        return std::nullopt;
+    return timegm(&tm);
+}
+
+Negotiation::ByteRange Negotiation::ParseRange(std::string_view range, uint64_t size) {
+    using Status = ByteRange::Status;
+    const auto parse_number = [](std::string_view str, uint64_t& value) {
+        auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        return !str.empty() && ec == std::errc{} && ptr == str.data() + str.size();
+    };
+    range = Trim(range);
+    if (!range.starts_with("bytes="sv))
+        return {};
+    range.remove_prefix(6);
+    const auto dash = range.find('-');
+    if (dash == std::string_view::npos || range.find(',') != std::string_view::npos)
+        return {};
+    const auto first = Trim(range.substr(0, dash));
+    const auto last = Trim(range.substr(dash + 1));
+    ByteRange result{Status::Satisfiable};
+    if (first.empty()) {
+        // суффикс: последние n байт
+        uint64_t suffix = 0;
+        if (!parse_number(last, suffix))
+            return {};
+        if (suffix == 0 || size == 0)
+            return {Status::Unsatisfiable};
+        result.first = size - std::min(suffix, size);
+        result.last = size - 1;
+        return result;
+    }
+    if (!parse_number(first, result.first))
+        return {};
+    result.last = size == 0 ? 0 : size - 1;
+    if (!last.empty()) {
+        uint64_t value = 0;
+        if (!parse_number(last, value) || value < result.first)
+            return {};
+        result.last = std::min(value, result.last);
+    }
+    if (result.first >= size)
+        return {Status::Unsatisfiable};
+    return result;
+}
+
+}  // namespace http_handler
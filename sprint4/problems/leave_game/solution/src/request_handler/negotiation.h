@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace http_handler {
+
+// Разбор заголовков условных запросов и согласования представления
+class Negotiation {
+public:
+    Negotiation() = delete;
+
+    // Совпадает ли etag с одним из тегов If-None-Match (сравнение слабое)
+    static bool ETagMatches(std::string_view if_none_match, std::string_view etag);
+    // Качество q типа type по заголовку Accept (0 - тип не принимается).
+    // Берётся самый точный подходящий диапазон: type, затем "тип/*", затем "*/*"
+    static double AcceptQuality(std::string_view accept, std::string_view type);
+    // Принимает ли клиент кодирование coding (например, gzip) по заголовку
+    // Accept-Encoding: явно указанное кодирование важнее "*"
+    static bool AcceptsEncoding(std::string_view accept_encoding, std::string_view coding);
+
+    // Дата HTTP (IMF-fixdate): "Sun, 06 Nov 1994 08:49:37 GMT"
+    static std::string FormatHttpDate(std::time_t time);
+    // Разбирает дату HTTP в формате IMF-fixdate; nullopt - дата некорректна
+    static std::optional<std::time_t> ParseHttpDate(std::string_view date);
+
+    // Диапазон байт [first, last] из заголовка Range
+    struct ByteRange {
+        enum class Status {
+            None,           // заголовка нет, он некорректен или диапазонов несколько
+            Satisfiable,
+            Unsatisfiable   // диапазон вне файла - ответ 416
+        };
+        Status status = Status::None;
+        uint64_t first = 0;
+        uint64_t last = 0;
+    };
+    // Разбирает единственный диапазон "bytes=a-b", "bytes=a-" или "bytes=-n"
+    // для ресурса размером size. Несколько диапазонов не поддерживаются:
+    // такой запрос обслуживается целиком
+    static ByteRange ParseRange(std::string_view range, uint64_t size);
+};
+
+}  // namespace http_handler
@@ -1,4 +1,5 @@
 #include "request_handler.h"
+#include "../util/token.h"
 
 namespace http_handler {
 StringResponse RequestHandler::ReportServerError(unsigned version, bool keep_alive) const
@@ -7,4 +8,73 @@ StringResponse RequestHandler::ReportServerError(unsigned version, bool keep_ali
 		"request processing error"sv);
 	return BaseRequestHandler::MakeStringResponse(http::status::bad_request, text, version, keep_alive);
 }
+
+std::optional<StringResponse> RequestHandler::CheckAdmin(std::string_view authorization,
+		unsigned version, bool keep_alive) const {
+	std::optional<StringResponse> response;
+	// без настроенного токена служебные endpoint'ы не существуют
+	if (admin_token_.empty())
+		response = Response::MakeJSON(http::status::not_found, ErrorCode::NOT_FOUND, ErrorMessage::ADMIN_DISABLED);
+	else if (!security::CheckBearer(authorization, admin_token_))
+		response = Response::MakeJSON(http::status::unauthorized, ErrorCode::INVALID_TOKEN,
+			ErrorMessage::INVALID_ADMIN_TOKEN);
+	else
+		return std::nullopt;
+	response->version(version);
+	response->keep_alive(keep_alive);
+	return response;
+}
+
+StringResponse RequestHandler::MakeMetricsResponse(http::verb method, unsigned version, bool keep_alive) {
+	return MakeReportResponse(method, version, keep_alive, [] {
+		return METRICS().Format();
+	}, MiscDefs::PROMETHEUS_TEXT);
+}
+
+StringResponse RequestHandler::MakeTickProfileResponse(http::verb method, unsigned version, bool keep_alive) const {
+	return MakeReportResponse(method, version, keep_alive, [this] {
+		const auto& profiler = coordinator_->GetTickProfiler();
+		return boost::json::serialize(ticker::TickProfiler::ToJson(profiler.GetReport()));
+	}, ContentType::APP_JSON);
+}
+
+StringResponse RequestHandler::MakeTraceResponse(std::string_view path, http::verb method, unsigned version,
+		bool keep_alive) {
+	if (path == Endpoint::TRACE) {
+		return MakeReportResponse(method, version, keep_alive, [] {
+			return TRACER().Dump();
+		}, ContentType::APP_JSON);
+	}
+	if (method != http::verb::post) {
+		auto response = Response::MakeMethodNotAllowed(ErrorMessage::POST_IS_EXPECTED,
+			MiscMessage::ALLOWED_POST_METHOD);
+		response.version(version);
+		response.keep_alive(keep_alive);
+		return response;
+	}
+	// включение очищает буферы, события прошлой записи теряются
+	if (path == Endpoint::TRACE_START)
+		TRACER().Enable();
+	else
+		TRACER().Disable();
+	return BaseRequestHandler::MakeStringResponse(http::status::ok, "{}"sv, version, keep_alive,
+		ContentType::APP_JSON, true);
+}
+
+StringResponse RequestHandler::MakeReportResponse(http::verb method, unsigned version, bool keep_alive,
+		const std::function<std::string()>& make_body, std::string_view content_type) {
+	if (method != http::verb::get && method != http::verb::head) {
+		auto response = Response::MakeMethodNotAllowed(ErrorMessage::GET_IS_EXPECTED,
+			MiscMessage::ALLOWED_GET_HEAD_METHOD);
+		response.version(version);
+		response.keep_alive(keep_alive);
+		return response;
+	}
+	auto response = BaseRequestHandler::MakeStringResponse(http::status::ok, make_body(),
+		version, keep_alive, content_type, true);
+	// для HEAD остаётся только Content-Length
+	if (method == http::verb::head)
+		response.body().clear();
+	return response;
+}
 }  // namespace http_handler
@@ -6,6 +6,7 @@
 #include <boost/json.hpp>
 #include <functional>
 #include <map>
+#include <optional>
 #include <variant>
 #include <boost/asio.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -16,6 +17,9 @@
 #include "response.h"
 #include "api_request.h"
 #include "file_request.h"
+#include "../coordinator.h"
+#include "../metrics.h"
+#include "../util/trace.h"
 
 namespace http_handler {
 namespace beast = boost::beast;
@@ -27,44 +31,118 @@ using namespace defs;
 class RequestHandler : public std::enable_shared_from_this<RequestHandler> {
     using Strand = net::strand<net::io_context::executor_type>;
 public:
-    RequestHandler(const fs::path& static_path, Strand api_strand, app::App &app, bool on_tick_api)
-        : file_handler{ static_path }
-        , api_strand_(api_strand)
-        , api_handler_(api_strand, app, on_tick_api) {
+    RequestHandler(const fs::path& static_path, std::shared_ptr<app::Coordinator> coordinator,
+            app::App &app, bool on_tick_api,
+            uint64_t static_cache_limit = StaticIndex::DEFAULT_CACHE_FILE_LIMIT,
+            std::string admin_token = {})
+        : file_handler{ static_path, static_cache_limit }
+        , coordinator_(std::move(coordinator))
+        , app_(app)
+        , on_tick_api_(on_tick_api)
+        , admin_token_(std::move(admin_token))
+        , api_handler_(app, on_tick_api) {
     }
 
     RequestHandler(const RequestHandler&) = delete;
     RequestHandler& operator=(const RequestHandler&) = delete;
 
+    // Обновлять индекс статических файлов при изменениях каталога
+    void WatchStaticFiles(net::io_context& ioc) {
+        file_handler.Watch(ioc);
+    }
+
+    // target разобран сессией при чтении запроса; запрос и target
+    // перемещаются в обработчик без копирования
     template <typename Body, typename Allocator, typename Send>
-    void operator()(tcp::endpoint, http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send)
+    void operator()(http_server::RequestTarget&& target,
+            http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send_response)
 	{
         auto version = req.version();
         auto keep_alive = req.keep_alive();
-        std::string target{StringRequest(req).target().data(), StringRequest(req).target().size()};
-        target = http_server::uriDecode(target);
+        const auto path = target.Path();
         auto api = Endpoint::API;
-        bool is_target = target.size() > api.size() && (target.substr(0, api.size()) == api);
+        bool is_target = path.size() > api.size() && path.starts_with(api);
+        // endpoint определяется один раз, дальше решения принимаются по нему
+        const auto type = path == Endpoint::METRICS ? defs::TypeRequest::Metrics
+            : path == Endpoint::TICK_PROFILE ? defs::TypeRequest::TickProfile
+            : IsTracePath(path) ? defs::TypeRequest::Trace
+            : is_target ? ApiRequestHandler::GetRequestType(path) : defs::TypeRequest::StaticFiles;
+        auto send = MeasuredSend(type, std::forward<Send>(send_response));
         try {
+            if (IsAdmin(type)) {
+                if (auto denied = CheckAdmin(req.base()[http::field::authorization], version, keep_alive))
+                    return send(std::move(*denied));
+            }
+            if (type == defs::TypeRequest::Metrics)
+                return send(MakeMetricsResponse(req.method(), version, keep_alive));
+            if (type == defs::TypeRequest::TickProfile)
+                return send(MakeTickProfileResponse(req.method(), version, keep_alive));
+            if (type == defs::TypeRequest::Trace)
+                return send(MakeTraceResponse(path, req.method(), version, keep_alive));
             /*req относится к API*/
             if (is_target) {
+                if (on_tick_api_ && req.method() == http::verb::post && type == defs::TypeRequest::Tick) {
+                    // тик ждёт все сессии, поэтому ответ отправляется по его завершении
+                    if (auto delta = app_.ParseTickDelta(req.body())) {
+                        return coordinator_->Tick(*delta, [send, version, keep_alive] {
+                            auto response = Response::Make(http::status::ok, "{}"sv);
+                            response.version(version);
+                            response.keep_alive(keep_alive);
+                            send(std::move(response));
+                        });
+                    }
+                }
+                // описания карт построены при запуске и отдаются готовыми
+                if ((type == defs::TypeRequest::Maps || type == defs::TypeRequest::Map)
+                        && api_handler_.HandleMaps(req, path, send))
+                    return;
+                // карты неизменяемы, состояние читается из снимка сессии, а команды
+                // движения уходят в её очередь без блокировок - такие запросы
+                // не требуют strand. strand выбирается до перемещения запроса
+                std::optional<Strand> strand;
+                if (!IsLockFree(type))
+                    strand = SelectStrand(req, type);
                 auto handle = [self = shared_from_this(), send,
-                    req = std::forward<decltype(req)>(req), version, keep_alive] {
+                    req = std::move(req), target = std::move(target), version, keep_alive] {
                     try {
-                        return send(std::move(self->api_handler_.Handle(req)));
+                        auto response = [&] {
+                            util::TraceSpan span{"handler"sv, "http"sv};
+                            return self->api_handler_.Handle(req, target);
+                        }();
+                        return send(std::move(response));
                     }
                     catch (...) {
                         send(self->ReportServerError(version, keep_alive));
                     }
                 };
-                return net::dispatch(api_strand_, handle);
+                if (!strand)
+                    return handle();
+                // глубина очереди strand'а: задание поставлено, но ещё не начато
+                const auto queue = *strand == coordinator_->GetStrand()
+                    ? metrics::Registry::Strand::Coordinator : metrics::Registry::Strand::Session;
+                METRICS().StrandQueued(queue);
+                // ожидание strand'а попадает в трассировку того же запроса
+                const auto queued = util::Tracer::Enabled()
+                    ? util::Tracer::Clock::now() : util::Tracer::Clock::time_point{};
+                return net::dispatch(*strand, [handle = std::move(handle), queue, queued,
+                        request = util::Tracer::CurrentRequest()] {
+                    METRICS().StrandStarted(queue);
+                    if (queued != util::Tracer::Clock::time_point{})
+                        TRACER().Record("strand_wait"sv, "http"sv, queued, util::Tracer::Clock::now(), request);
+                    util::TraceRequestScope trace_scope{request};
+                    handle();
+                });
             }
             // Возвращаем результат обработки запроса к файлу
+            auto result = [&] {
+                util::TraceSpan span{"handler"sv, "http"sv};
+                return file_handler.Handle(req, target);
+            }();
             return std::visit(
                 [&send](auto&& result) {
                     send(std::forward<decltype(result)>(result));
                 },
-                file_handler.Handle(req)
+                std::move(result)
             );
         }
         catch (...) {
@@ -73,8 +151,59 @@ public:
     }
 private:
     FileRequestHandler file_handler;
-    Strand api_strand_;
+    std::shared_ptr<app::Coordinator> coordinator_;
+    app::App& app_;
+    bool on_tick_api_;
+    // токен служебных endpoint'ов, пустой - они отключены
+    std::string admin_token_;
 	ApiRequestHandler api_handler_;
+
+    // Вход в игру выполняется в strand сессии, остальные запросы -
+    // в strand координатора
+    template <typename Body, typename Allocator>
+    Strand SelectStrand(const http::request<Body, http::basic_fields<Allocator>>& req,
+            defs::TypeRequest type) {
+        if (type == defs::TypeRequest::Join) {
+            if (auto session = app_.JoinTargetSession(req.body()))
+                return coordinator_->GetSessionStrand(session);
+        }
+        return coordinator_->GetStrand();
+    }
+    // Передаёт ответ в send и учитывает время обработки запроса в метриках
+    template <typename Send>
+    static auto MeasuredSend(defs::TypeRequest type, Send&& send) {
+        return [type, start = std::chrono::steady_clock::now(), send = std::forward<Send>(send)](auto&& response) {
+            METRICS().ObserveRequest(type, response.result_int(),
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+            send(std::forward<decltype(response)>(response));
+        };
+    }
+    // Служебные endpoint'ы открыты только с "Authorization: Bearer <admin_token_>"
+    static bool IsAdmin(defs::TypeRequest type) {
+        return type == defs::TypeRequest::Metrics || type == defs::TypeRequest::TickProfile
+            || type == defs::TypeRequest::Trace;
+    }
+    // Ответ с отказом, nullopt - доступ разрешён
+    std::optional<StringResponse> CheckAdmin(std::string_view authorization, unsigned version,
+        bool keep_alive) const;
+    // Метрики в текстовом формате Prometheus: GET и HEAD
+    static StringResponse MakeMetricsResponse(http::verb method, unsigned version, bool keep_alive);
+    // Профиль тиков координатора в JSON: GET и HEAD
+    StringResponse MakeTickProfileResponse(http::verb method, unsigned version, bool keep_alive) const;
+    // Дамп трассировки (GET, HEAD) и её включение и выключение (POST)
+    static StringResponse MakeTraceResponse(std::string_view path, http::verb method, unsigned version,
+        bool keep_alive);
+    static bool IsTracePath(std::string_view path) {
+        return path == Endpoint::TRACE || path == Endpoint::TRACE_START || path == Endpoint::TRACE_STOP;
+    }
+    // Отчёт только для чтения: 405 для методов кроме GET и HEAD, для HEAD тело пустое
+    static StringResponse MakeReportResponse(http::verb method, unsigned version, bool keep_alive,
+        const std::function<std::string()>& make_body, std::string_view content_type);
+    static bool IsLockFree(defs::TypeRequest type) {
+        return type == defs::TypeRequest::Maps || type == defs::TypeRequest::Map
+            || type == defs::TypeRequest::Action || type == defs::TypeRequest::State
+            || type == defs::TypeRequest::Players;
+    }
     StringResponse ReportServerError(unsigned version, bool keep_alive) const;
 };
 
@@ -3,6 +3,8 @@
 #include <string_view>
 #include <string>
 #include <variant>
+#include <memory>
+#include <boost/optional.hpp>
 #include <boost/json.hpp>
 
 #include <boost/beast/core.hpp>
@@ -11,8 +13,41 @@
 namespace http_handler {
 namespace beast = boost::beast;
 namespace http = beast::http;
+namespace net = boost::asio;
 using StringResponse = http::response<http::string_body>;
 
+// Тело ответа - разделяемая неизменяемая строка. Готовые тела (описания
+// карт) отправляются из общего буфера без копирования
+struct SharedStringBody {
+    using value_type = std::shared_ptr<const std::string>;
+
+    static std::uint64_t size(const value_type& body) {
+        return body ? body->size() : 0;
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = net::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer(const http::header<isRequest, Fields>&, const value_type& body)
+            : body_(body) {
+        }
+        void init(beast::error_code& ec) {
+            ec = {};
+        }
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+            ec = {};
+            if (!body_ || body_->empty())
+                return boost::none;
+            return std::make_pair(const_buffers_type{body_->data(), body_->size()}, false);
+        }
+    private:
+        const value_type& body_;
+    };
+};
+using SharedResponse = http::response<SharedStringBody>;
+
 class Response
 {
     public:
@@ -0,0 +1,297 @@
+#include "static_index.h"
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/format.hpp>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "base_request.h"
+#include "negotiation.h"
+#include "../log.h"
+#include "../util/gzip.h"
+
+namespace http_handler {
+
+namespace {
+std::shared_ptr<const std::string> ReadFile(const fs::path& path, uint64_t size) {
+    std::ifstream in{path, std::ios::binary};
+    if (!in)
+        return nullptr;
+    std::string data(size, '\0');
+    in.read(data.data(), static_cast<std::streamsize>(size));
+    data.resize(static_cast<size_t>(in.gcount()));
+    return std::make_shared<const std::string>(std::move(data));
+}
+
+#ifdef __linux__
+// Поток, в котором индексы перестраиваются по событиям каталога
+net::thread_pool& RefreshPool() {
+    static net::thread_pool pool{1};
+    return pool;
+}
+#endif
+}  // namespace
+
+StaticIndex::StaticIndex(fs::path root, uint64_t cache_file_limit)
+    : root_(std::move(root))
+    , cache_file_limit_(cache_file_limit)
+    , index_(Build(nullptr)) {
+}
+
+StaticIndex::~StaticIndex() {
+#ifdef __linux__
+    if (watch_fd_ >= 0)
+        ::close(watch_fd_);
+#endif
+}
+
+void StaticIndex::AppendLower(std::string& out, std::string_view str) {
+    for (char c : str)
+        out += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+std::shared_ptr<const StaticIndex::File> StaticIndex::Find(std::string_view target) const {
+    std::string key;
+    key.reserve(target.size());
+    AppendLower(key, target);
+    auto index = index_.Load();
+    if (auto it = index->files.find(key); it != index->files.end())
+        return it->second;
+    return nullptr;
+}
+
+void StaticIndex::Refresh() {
+    std::lock_guard lock{refresh_mutex_};
+    index_.Store(Build(index_.Load().get()));
+}
+
+std::shared_ptr<const StaticIndex::Index> StaticIndex::Build(const Index* previous) const {
+    auto index = std::make_shared<Index>();
+    index->dirs.push_back(root_);
+    std::error_code ec;
+    // ошибки отдельных файлов (удалён во время обхода, нет прав) пропускаются
+    for (fs::recursive_directory_iterator it{root_, fs::directory_options::skip_permission_denied, ec}, end;
+            !ec && it != end; it.increment(ec)) {
+        const auto& entry = *it;
+        std::error_code file_ec;
+        if (entry.is_directory(file_ec)) {
+            index->dirs.push_back(entry.path());
+            continue;
+        }
+        if (!entry.is_regular_file(file_ec))
+            continue;
+        auto file = std::make_shared<File>();
+        file->path = entry.path();
+        file->size = entry.file_size(file_ec);
+        if (file_ec)
+            continue;
+        file->mtime = entry.last_write_time(file_ec);
+        if (file_ec)
+            continue;
+        std::string key;
+        for (const auto& part : fs::relative(file->path, root_)) {
+            key += '/';
+            AppendLower(key, part.string());
+        }
+        std::string ext;
+        AppendLower(ext, file->path.extension().string());
+        file->content_type = ContentType::get(ext);
+        file->etag = (boost::format("\"%x-%x\"")
+            % file->mtime.time_since_epoch().count() % file->size).str();
+        file->modified = std::chrono::system_clock::to_time_t(
+            std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+                fs::file_time_type::clock::to_sys(file->mtime)));
+        file->last_modified = Negotiation::FormatHttpDate(file->modified);
+        file->fingerprinted = IsFingerprinted(file->path.filename().string());
+        // неизменившийся файл берётся из прежнего индекса без чтения и сжатия
+        std::shared_ptr<const File> unchanged;
+        if (previous) {
+            auto old = previous->files.find(key);
+            if (old != previous->files.end()
+                    && old->second->size == file->size && old->second->mtime == file->mtime)
+                unchanged = old->second;
+        }
+        if (file->size <= cache_file_limit_) {
+            if (unchanged)
+                file->data = unchanged->data;
+            if (!file->data)
+                file->data = ReadFile(file->path, file->size);
+            if (file->data)
+                index->cached_bytes += file->data->size();
+        }
+        if (IsCompressible(file->content_type)) {
+            file->gzip = MakeGzip(*file, unchanged.get());
+            if (file->gzip && file->gzip->data)
+                index->cached_bytes += file->gzip->data->size();
+        }
+        index->files.insert_or_assign(std::move(key), std::move(file));
+    }
+    return index;
+}
+
+std::shared_ptr<const StaticIndex::File> StaticIndex::MakeGzip(const File& file, const File* unchanged) const {
+    auto gzip = std::make_shared<File>(file);
+    gzip->gzip = nullptr;
+    gzip->etag.insert(gzip->etag.size() - 1, "-gzip"sv);
+    // .gz, собранный заранее рядом с файлом, используется, если он не старше файла
+    std::error_code ec;
+    auto sibling = file.path;
+    sibling += ".gz";
+    if (fs::is_regular_file(sibling, ec)) {
+        const auto mtime = fs::last_write_time(sibling, ec);
+        const auto size = ec ? 0 : fs::file_size(sibling, ec);
+        if (!ec && mtime >= file.mtime) {
+            gzip->path = std::move(sibling);
+            gzip->size = size;
+            gzip->data = size <= cache_file_limit_ ? ReadFile(gzip->path, size) : nullptr;
+            return gzip;
+        }
+    }
+    // сжатое ранее содержимое неизменившегося файла не пересжимается
+    if (unchanged && unchanged->gzip && unchanged->gzip->path == file.path)
+        return unchanged->gzip;
+    if (file.size > MAX_COMPRESS_SIZE)
+        return nullptr;
+    auto data = file.data ? file.data : ReadFile(file.path, file.size);
+    if (!data)
+        return nullptr;
+    auto compressed = util::GzipCompress(*data);
+    // сжатие, экономящее меньше 10%, не окупает распаковку на клиенте
+    if (compressed.size() > data->size() / 10 * 9 || compressed.size() > cache_file_limit_)
+        return nullptr;
+    gzip->size = compressed.size();
+    gzip->data = std::make_shared<const std::string>(std::move(compressed));
+    return gzip;
+}
+
+bool StaticIndex::IsCompressible(std::string_view content_type) {
+    return content_type.starts_with("text/"sv)
+        || content_type == ContentType::APP_JSON
+        || content_type == ContentType::APP_XML
+        || content_type == ContentType::IMAGE_SVG;
+}
+
+bool StaticIndex::IsFingerprinted(std::string_view filename) {
+    constexpr size_t MIN_HASH_SIZE = 8;
+    // первая часть - само имя, последняя - расширение
+    const auto begin = filename.find_first_of(".-");
+    const auto end = filename.rfind('.');
+    if (begin == std::string_view::npos || end == std::string_view::npos || begin >= end)
+        return false;
+    auto parts = filename.substr(begin + 1, end - begin - 1);
+    while (!parts.empty()) {
+        const auto sep = parts.find_first_of(".-");
+        const auto part = parts.substr(0, sep);
+        if (part.size() >= MIN_HASH_SIZE && part.find_first_not_of("0123456789abcdefABCDEF") == std::string_view::npos)
+            return true;
+        if (sep == std::string_view::npos)
+            break;
+        parts.remove_prefix(sep + 1);
+    }
+    return false;
+}
+
+size_t StaticIndex::GetFileCount() const {
+    return index_.Load()->files.size();
+}
+
+size_t StaticIndex::GetCachedBytes() const {
+    return index_.Load()->cached_bytes;
+}
+
+#ifdef __linux__
+class StaticIndex::Watcher : public std::enable_shared_from_this<Watcher> {
+public:
+    // события и таймер обрабатываются в одном strand
+    Watcher(net::io_context& ioc, int fd, std::shared_ptr<StaticIndex> index)
+        : strand_(net::make_strand(ioc))
+        , inotify_(strand_, fd)
+        , timer_(strand_)
+        , index_(std::move(index)) {
+    }
+
+    void ReadEvents() {
+        inotify_.async_read_some(net::buffer(events_),
+            [self = shared_from_this()](const boost::system::error_code& ec, std::size_t) {
+                if (ec) {
+                    if (ec != net::error::operation_aborted)
+                        LOGSRV().Msg("Static files watch stopped", ec.message());
+                    return;
+                }
+                self->ScheduleRefresh();
+                self->ReadEvents();
+            });
+    }
+
+private:
+    net::strand<net::io_context::executor_type> strand_;
+    net::posix::stream_descriptor inotify_;
+    net::steady_timer timer_;
+    std::array<char, 4096> events_;
+    std::shared_ptr<StaticIndex> index_;
+
+    void ScheduleRefresh() {
+        // каждое событие переносит перестроение: пачка событий даёт одно
+        timer_.expires_after(REFRESH_DELAY);
+        timer_.async_wait([self = shared_from_this()](const boost::system::error_code& ec) {
+            if (!ec)
+                self->index_->QueueRefresh();
+        });
+    }
+};
+
+void StaticIndex::Watch(net::io_context& ioc) {
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        LOGSRV().Msg("Static files watch failed", std::strerror(errno));
+        return;
+    }
+    watch_fd_ = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (watch_fd_ < 0) {
+        LOGSRV().Msg("Static files watch failed", std::strerror(errno));
+        ::close(fd);
+        return;
+    }
+    auto watcher = std::make_shared<Watcher>(ioc, fd, shared_from_this());
+    AddWatches(*index_.Load());
+    watcher->ReadEvents();
+}
+
+void StaticIndex::AddWatches(const Index& index) {
+    constexpr uint32_t MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE
+        | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF;
+    // повторное добавление каталога не создаёт новое наблюдение
+    for (const auto& dir : index.dirs)
+        inotify_add_watch(watch_fd_, dir.c_str(), MASK);
+}
+
+void StaticIndex::QueueRefresh() {
+    if (refresh_queued_.exchange(true))
+        return;
+    net::post(RefreshPool(), [self = shared_from_this()] {
+        // изменения во время перестроения поставят следующее
+        self->refresh_queued_ = false;
+        try {
+            self->Refresh();
+            self->AddWatches(*self->index_.Load());
+        } catch (const std::exception& ex) {
+            LOGSRV().Msg("Static files refresh failed", ex.what());
+        }
+    });
+}
+#else
+void StaticIndex::Watch(net::io_context&) {
+}
+#endif
+
+}  // namespace http_handler
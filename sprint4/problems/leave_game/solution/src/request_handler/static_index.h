@@ -0,0 +1,119 @@
+#pragma once
+#include "../sdk.h"
+#include <boost/asio/io_context.hpp>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../util/atomic_shared_ptr.h"
+
+namespace http_handler {
+namespace net = boost::asio;
+namespace fs = std::filesystem;
+
+// Индекс статических файлов каталога --www-root.
+// Строится при запуске: путь в нижнем регистре -> размер, время изменения,
+// Content-Type и ETag; файлы не больше лимита читаются в память. Запрос
+// статического файла - поиск в хеш-таблице, без обращений к файловой системе.
+// Индекс публикуется целиком (read-copy-update), при изменениях каталога
+// (inotify) строится заново, неизменившиеся файлы не перечитываются.
+// Перестроение по событиям откладывается на REFRESH_DELAY, чтобы пачка
+// изменений (выкладка) дала одно перестроение, и выполняется в отдельном
+// потоке: обход каталога и сжатие файлов не занимают потоки ввода-вывода.
+class StaticIndex : public std::enable_shared_from_this<StaticIndex> {
+public:
+    struct File {
+        fs::path path;
+        uint64_t size = 0;
+        fs::file_time_type mtime;
+        std::string_view content_type;
+        std::string etag;
+        // время изменения с точностью до секунды и его запись для Last-Modified
+        std::time_t modified = 0;
+        std::string last_modified;
+        // в имени есть отпечаток содержимого (app.3f9a2c1e.js): файл
+        // с таким именем не меняется и кэшируется клиентом надолго
+        bool fingerprinted = false;
+        // содержимое файла, если он не больше лимита кэша, иначе nullptr
+        std::shared_ptr<const std::string> data;
+        // сжатое gzip представление для текстовых типов: готовый файл
+        // "<имя>.gz" рядом с исходным или сжатое при построении индекса
+        // содержимое; nullptr - сжатие не выгодно
+        std::shared_ptr<const File> gzip;
+    };
+    static constexpr uint64_t DEFAULT_CACHE_FILE_LIMIT = 2 * 1024 * 1024;
+    // Файлы больше этого размера при построении индекса не сжимаются
+    static constexpr uint64_t MAX_COMPRESS_SIZE = 64 * 1024 * 1024;
+    // Пауза после последнего события каталога перед перестроением индекса
+    static constexpr std::chrono::milliseconds REFRESH_DELAY{200};
+
+    StaticIndex(fs::path root, uint64_t cache_file_limit = DEFAULT_CACHE_FILE_LIMIT);
+    StaticIndex(const StaticIndex&) = delete;
+    StaticIndex& operator=(const StaticIndex&) = delete;
+    ~StaticIndex();
+
+    // target - путь запроса после декодирования, регистр не важен.
+    // nullptr - файла нет
+    std::shared_ptr<const File> Find(std::string_view target) const;
+    // Перестраивает индекс по текущему содержимому каталога
+    void Refresh();
+    // Следит за каталогом через inotify и обновляет индекс при изменениях.
+    // События обрабатываются в strand на ioc, перестроение - в потоке
+    // обновления индекса. Вне Linux ничего не делает
+    void Watch(net::io_context& ioc);
+
+    size_t GetFileCount() const;
+    size_t GetCachedBytes() const;
+
+    // Есть ли в имени файла отпечаток - часть из 8 и более шестнадцатеричных
+    // цифр, отделённая '.' или '-' (app.3f9a2c1e.js, logo-0d5c9a7b41.png)
+    static bool IsFingerprinted(std::string_view filename);
+    // Стоит ли сжимать содержимое этого типа: текст, JSON, XML, SVG
+    static bool IsCompressible(std::string_view content_type);
+
+private:
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const noexcept {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+    struct Index {
+        std::unordered_map<std::string, std::shared_ptr<const File>, KeyHash, std::equal_to<>> files;
+        std::vector<fs::path> dirs;
+        size_t cached_bytes = 0;
+    };
+
+    const fs::path root_;
+    const uint64_t cache_file_limit_;
+    util::AtomicSharedPtr<const Index> index_;
+    std::mutex refresh_mutex_;
+#ifdef __linux__
+    // Чтение событий и таймер отложенного перестроения. Живёт в обработчиках
+    // на io_context: индекс, который держит поток обновления, не владеет
+    // объектами ввода-вывода и может пережить io_context
+    class Watcher;
+    // копия дескриптора inotify для добавления наблюдений из потока обновления
+    int watch_fd_ = -1;
+    // перестроение поставлено в поток обновления и ещё не началось
+    std::atomic<bool> refresh_queued_{false};
+
+    void AddWatches(const Index& index);
+    void QueueRefresh();
+#endif
+
+    std::shared_ptr<const Index> Build(const Index* previous) const;
+    // unchanged - тот же файл из прежнего индекса, если он не изменился
+    std::shared_ptr<const File> MakeGzip(const File& file, const File* unchanged) const;
+    // Ключ индекса: путь от корня с '/' в начале, в нижнем регистре
+    static void AppendLower(std::string& out, std::string_view str);
+};
+
+}  // namespace http_handler
@@ -1,174 +1,213 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <string_view>
 #include <string>
-#include <functional>
-#include <unordered_map>
-#include <vector>
 
 #include "defs.h"
 #include "response.h"
 #include "../util/token.h"
-#include "../http_server.h"
+#include "../request_target.h"
 
 namespace uri_api
 {
 namespace beast = boost::beast;
 namespace http = beast::http;
 using namespace defs;
-using FunctionWithAuthorize = std::function<http_handler::StringResponse(const security::Token& token, std::string_view body)>;
-using FunctionWithoutAuthorize = std::function<http_handler::StringResponse(std::string_view body)>;
-using FunctionTargetProcessing = std::function<http_handler::StringResponse(std::string_view target, std::string_view body)>;
-
-template <typename Fn, typename Body, typename Allocator>
-http_handler::StringResponse ExecuteAuthorized(const http::request<Body, http::basic_fields<Allocator>>& req, Fn&& action) { 
-    if (auto token = security::ExtractTokenFromStringViewAndCheckIt(req.base()[http::field::authorization])) {
-        return action(*token, req.body());
-    } else {
-        return http_handler::Response::MakeUnauthorizedErrorInvalidToken();
-    }
-}
+using StringRequest = http::request<http::string_body>;
+using http_handler::StringResponse;
+using http_server::RequestTarget;
+
+// Данные запроса для обработчиков с параметрами и условными ответами
+struct RequestData {
+    // часть target после '?'
+    std::string_view query;
+    std::string_view body;
+    std::string_view if_none_match;
+    std::string_view accept;
+};
 
-class UriElement {
-    struct AllowedMethods {
-        std::vector<http::verb> data_;
-        std::string_view error_;
-        std::string_view allowed_;
-
-        AllowedMethods()
-        : data_()
-        , error_()
-        , allowed_()
-        {};
-    };
-
-    struct AuthorizeData {
-        bool need_;
-        AuthorizeData()
-        : need_(false)
-        {};
-    };
-
-    struct TargetProcessing {
-        bool need_;
-        TargetProcessing()
-            : need_(false)
-        {};
-    };
-
-    struct ContentType {
-        bool need_to_check_;
-        std::string_view value_;
-        std::string_view error_;
-
-        ContentType()
-        : need_to_check_(false)
-        {};
-    };
-public:
-    UriElement()
-    : methods_()
-    , authorize_()
-    , content_type_()
-    , target_processing_()
-    {};
-    UriElement& SetAllowedMethods(std::vector<http::verb> methods, std::string_view method_error_message, std::string_view allowed_methods) {
-        methods_.data_ = std::move(methods);
-        methods_.error_ = method_error_message;
-        methods_.allowed_ = allowed_methods;
-
-        return *this;
-    }
+// ---------- Политики маршрута ----------
 
-    UriElement& SetNeedAuthorization(bool need_authorize_) {
-        authorize_.need_ = need_authorize_;
-        return *this;
+// Разрешённые методы: остальные получают 405 с заголовком Allow
+template <http::verb... Verbs>
+struct MethodPolicy {
+    static constexpr bool Allows(http::verb verb) {
+        return ((verb == Verbs) || ...);
     }
+};
+struct GetHead : MethodPolicy<http::verb::get, http::verb::head> {
+    static constexpr std::string_view ERROR = ErrorMessage::GET_IS_EXPECTED;
+    static constexpr std::string_view ALLOW = MiscMessage::ALLOWED_GET_HEAD_METHOD;
+};
+struct PostOnly : MethodPolicy<http::verb::post> {
+    static constexpr std::string_view ERROR = ErrorMessage::POST_IS_EXPECTED;
+    static constexpr std::string_view ALLOW = MiscMessage::ALLOWED_POST_METHOD;
+};
 
-    UriElement& SetNeedTargetProcessing(bool need_target_processing_) {
-        target_processing_.need_ = need_target_processing_;
-        return *this;
+// Авторизация: обработчик вызывается без токена
+struct NoAuthorization {
+    template <typename Fn>
+    static StringResponse Call(const StringRequest&, Fn&& fn) {
+        return fn();
     }
-
-    UriElement& SetProcessFunction(FunctionWithAuthorize f) {
-        process_function_ = std::move(f);
-        return *this;
+};
+// Авторизация по заголовку "Authorization: Bearer <токен>": обработчик
+// получает токен первым аргументом, без токена - 401
+struct BearerAuthorization {
+    template <typename Fn>
+    static StringResponse Call(const StringRequest& req, Fn&& fn) {
+        if (auto token = security::ExtractTokenFromStringViewAndCheckIt(req.base()[http::field::authorization]))
+            return fn(*token);
+        return http_handler::Response::MakeUnauthorizedErrorInvalidToken();
     }
+};
 
-    UriElement& SetProcessFunction(FunctionWithoutAuthorize f) {
-        process_function_without_authorize_ = std::move(f);
-        return *this;
+// Что обработчик получает из запроса
+struct BodyArg {
+    static std::string_view Get(const StringRequest& req, const RequestTarget&) {
+        return req.body();
     }
-
-    UriElement& SetProcessFunction(FunctionTargetProcessing f) {
-        process_function_target_processing_ = std::move(f);
-        return *this;
+};
+struct PathArg {
+    static std::string_view Get(const StringRequest&, const RequestTarget& target) {
+        return target.Path();
     }
-
-    UriElement& SetContentType(std::string_view type, std::string_view error_message) {
-        content_type_.need_to_check_ = true;
-        content_type_.value_ = type;
-        content_type_.error_ = error_message;
-        return *this;
+};
+struct QueryArg {
+    static std::string_view Get(const StringRequest&, const RequestTarget& target) {
+        return target.Query();
+    }
+};
+struct RequestDataArg {
+    static RequestData Get(const StringRequest& req, const RequestTarget& target) {
+        return RequestData{target.Query(), req.body(),
+            req.base()[http::field::if_none_match], req.base()[http::field::accept]};
     }
+};
 
-    template <typename Body, typename Allocator>
-    http_handler::StringResponse ProcessRequest(const http::request<Body, http::basic_fields<Allocator>>& req) {
-        if( methods_.data_.empty() || std::find(methods_.data_.begin(), 
-            methods_.data_.end(), req.method()) != methods_.data_.end()) {
-            //Check content type if necessary
-            if(content_type_.need_to_check_ && content_type_.value_ 
-                != req.base()[boost::beast::http::field::content_type]) {
-                return http_handler::Response::MakeBadRequestInvalidArgument(content_type_.error_);
-            }
-            //Check authorization if necessary and call necessary processing function
-            if(authorize_.need_) {
-                return ExecuteAuthorized(req, [&](const security::Token& token, std::string_view body){
-                    return process_function_(token, body);
-                }); 
-            }
-            std::string target = http_server::uriDecode(req.target());
-            if (target_processing_.need_)
-                return process_function_target_processing_(target, req.body());
-            auto stop = target.find('?');
-            if ( stop != std::string::npos) {
-                return process_function_without_authorize_(target.substr(stop + 1));
-            }
-            return process_function_without_authorize_(req.body());
-        }            
-        return http_handler::Response::MakeMethodNotAllowed(methods_.error_, methods_.allowed_);
+// Сопоставление пути: только точное или ещё и вложенные пути ("/maps/{id}")
+enum class Match {
+    Exact,
+    Prefix
+};
+
+// Маршрут: путь, его тип, политики и обработчик - функция-член владельца
+// таблицы. Всё известно при компиляции, вызов обработчика прямой
+template <const std::string_view& Path, TypeRequest Type, Match MatchKind,
+          typename Methods, typename Authorization, typename Arg, auto Handler>
+struct Route {
+    static constexpr std::string_view PATH = Path;
+    static constexpr TypeRequest TYPE = Type;
+    static constexpr Match MATCH = MatchKind;
+
+    template <typename Owner>
+    static StringResponse Invoke(Owner& owner, const StringRequest& req, const RequestTarget& target) {
+        if (!Methods::Allows(req.method()))
+            return http_handler::Response::MakeMethodNotAllowed(Methods::ERROR, Methods::ALLOW);
+        return Authorization::Call(req, [&](const auto&... token) {
+            return std::invoke(Handler, owner, token..., Arg::Get(req, target));
+        });
     }
-private:
-    AllowedMethods methods_;
-    AuthorizeData authorize_;
-    ContentType content_type_;
-    TargetProcessing target_processing_;
-    FunctionWithAuthorize process_function_;
-    FunctionWithoutAuthorize process_function_without_authorize_;
-    FunctionTargetProcessing process_function_target_processing_;
 };
 
-class UriData {
+// Таблица маршрутов, построенная при компиляции. Точные пути ищутся по
+// совершенной хеш-функции: подобранный при компиляции seed разводит все
+// пути по разным ячейкам, поиск - хеш, одна ячейка и одно сравнение строк.
+// Вложенные пути Prefix-маршрутов проверяются после промаха.
+// Вызов обработчика - по индексу в массиве указателей на функции
+template <typename Owner, typename... Routes>
+class Router {
 public:
-    UriData() = default;
-    UriElement* AddEndpoint(std::string_view uri) {
-        auto [it, ret] = data_.try_emplace(std::string(uri));
-        return &it->second;
-    }
-    template <typename Body, typename Allocator>
-    http_handler::StringResponse Process(const http::request<Body, http::basic_fields<Allocator>>& req) {
-        std::string target = http_server::uriDecode(req.target());
-        auto stop = target.find('?');
-        target = std::string(target.substr(0, stop));
-        if (target.find(Endpoint::MAPS) == 0)
-            target = std::string{ Endpoint::MAPS };
-        auto it = data_.find(target);
-        if(it != data_.end()) {
-            return it->second.ProcessRequest(req);
+    static constexpr size_t SIZE = sizeof...(Routes);
+    static constexpr size_t NOT_FOUND = SIZE;
+    static_assert(SIZE > 0 && SIZE < std::numeric_limits<uint8_t>::max());
+
+    static constexpr size_t Find(std::string_view path) {
+        const size_t index = SLOTS[Hash(path, SEED) & (TABLE_SIZE - 1)];
+        if (index != NOT_FOUND && PATHS[index] == path)
+            return index;
+        for (size_t i = 0; i < SIZE; ++i) {
+            if (MATCHES[i] == Match::Prefix && path.size() > PATHS[i].size()
+                    && path.starts_with(PATHS[i]) && path[PATHS[i].size()] == '/')
+                return i;
         }
-        return http_handler::Response::MakeJSON(http::status::bad_request, ErrorCode::BAD_REQUEST, ErrorMessage::INVALID_ENDPOINT);
+        return NOT_FOUND;
+    }
+    static constexpr TypeRequest GetType(size_t index) {
+        return index == NOT_FOUND ? TypeRequest::None : TYPES[index];
     }
+    static constexpr std::string_view GetPath(size_t index) {
+        return PATHS[index];
+    }
+
+    static StringResponse Dispatch(Owner& owner, const StringRequest& req, const RequestTarget& target) {
+        const auto index = Find(target.Path());
+        if (index == NOT_FOUND)
+            return http_handler::Response::MakeJSON(http::status::bad_request,
+                ErrorCode::BAD_REQUEST, ErrorMessage::INVALID_ENDPOINT);
+        return INVOKERS[index](owner, req, target);
+    }
+
 private:
-    std::unordered_map<std::string, UriElement> data_;
+    using Invoker = StringResponse (*)(Owner&, const StringRequest&, const RequestTarget&);
+
+    static constexpr std::array<std::string_view, SIZE> PATHS{Routes::PATH...};
+    static constexpr std::array<TypeRequest, SIZE> TYPES{Routes::TYPE...};
+    static constexpr std::array<Match, SIZE> MATCHES{Routes::MATCH...};
+    static constexpr std::array<Invoker, SIZE> INVOKERS{&Routes::template Invoke<Owner>...};
+
+    // Не меньше двух ячеек на маршрут, размер - степень двойки
+    static constexpr size_t TABLE_SIZE = [] {
+        size_t size = 1;
+        while (size < SIZE * 2)
+            size *= 2;
+        return size;
+    }();
+
+    // Пути API начинаются одинаково, поэтому хешируются длина и последние
+    // HASHED_TAIL символов (FNV-1a с начальным значением от seed). Полное
+    // совпадение проверяется сравнением строк после выбора ячейки
+    static constexpr size_t HASHED_TAIL = 8;
+    static constexpr uint32_t Hash(std::string_view str, uint32_t seed) {
+        uint32_t hash = (2166136261u ^ (seed * 16777619u)) + static_cast<uint32_t>(str.size());
+        for (char c : str.substr(str.size() - std::min(str.size(), HASHED_TAIL))) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 16777619u;
+        }
+        return hash ^ (hash >> 15);
+    }
+
+    using Slots = std::array<uint8_t, TABLE_SIZE>;
+    // Раскладывает пути по ячейкам; false - есть совпадение ячеек
+    static constexpr bool Place(uint32_t seed, Slots& slots) {
+        for (auto& slot : slots)
+            slot = static_cast<uint8_t>(NOT_FOUND);
+        for (size_t i = 0; i < SIZE; ++i) {
+            auto& slot = slots[Hash(PATHS[i], seed) & (TABLE_SIZE - 1)];
+            if (slot != NOT_FOUND)
+                return false;
+            slot = static_cast<uint8_t>(i);
+        }
+        return true;
+    }
+    static constexpr uint32_t MAX_SEED = 1 << 16;
+    static constexpr uint32_t SEED = [] {
+        Slots slots{};
+        uint32_t seed = 0;
+        while (seed < MAX_SEED && !Place(seed, slots))
+            ++seed;
+        return seed;
+    }();
+    static_assert(SEED < MAX_SEED, "paths differ only before the hashed tail");
+    static constexpr Slots SLOTS = [] {
+        Slots slots{};
+        Place(SEED, slots);
+        return slots;
+    }();
 };
 }
@@ -0,0 +1,123 @@
+#include "ws_session.h"
+
+#include "defs.h"
+#include "response.h"
+#include "../log.h"
+#include "../metrics.h"
+
+namespace http_handler {
+using namespace defs;
+
+WsSession::WsSession(beast::tcp_stream&& stream, app::App& app, app::StateFeed& feed)
+    : ws_(std::move(stream))
+    , app_(app)
+    , feed_(feed) {
+    METRICS().ConnectionOpened(metrics::Registry::Connection::WebSocket);
+}
+
+WsSession::~WsSession() {
+    METRICS().ConnectionClosed(metrics::Registry::Connection::WebSocket);
+}
+
+void WsSession::Run(HttpRequest&& request, const http_server::RequestTarget& target) {
+    request_ = std::move(request);
+    if (target.Path() != Endpoint::GAME_WS)
+        return Reject(Response::MakeJSON(http::status::not_found,
+            ErrorCode::BAD_REQUEST, ErrorMessage::INVALID_ENDPOINT));
+    auto token = security::ExtractTokenFromStringViewAndCheckIt(
+        request_.base()[http::field::authorization]);
+    if (!token)
+        return Reject(Response::MakeUnauthorizedErrorInvalidToken());
+    if (!app_.ResolveToken(*token))
+        return Reject(Response::MakeUnauthorizedErrorUnknownToken());
+    token_ = std::move(*token);
+    // таймаут HTTP-сессии заменяется пингами WebSocket
+    beast::get_lowest_layer(ws_).expires_never();
+    ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+    ws_.async_accept(request_,
+        beast::bind_front_handler(&WsSession::OnAccept, shared_from_this()));
+}
+
+void WsSession::Reject(http::response<http::string_body>&& response) {
+    response.version(request_.version());
+    response.keep_alive(false);
+    auto safe_response = std::make_shared<http::response<http::string_body>>(std::move(response));
+    http::async_write(beast::get_lowest_layer(ws_), *safe_response,
+        [self = shared_from_this(), safe_response](beast::error_code ec, std::size_t) {
+            if (ec)
+                return LOGSRV().Error(ec, server_logging::Server::Where::write);
+            beast::get_lowest_layer(self->ws_).socket().shutdown(net::ip::tcp::socket::shutdown_send, ec);
+        });
+}
+
+void WsSession::OnAccept(beast::error_code ec) {
+    if (ec)
+        return LOGSRV().Error(ec, server_logging::Server::Where::accept);
+    auto player = app_.ResolveToken(token_);
+    if (!player)
+        return Close(websocket::close_code::policy_error);
+    feed_.Subscribe(*player->session, weak_from_this());
+    Read();
+}
+
+void WsSession::Read() {
+    ws_.async_read(buffer_, beast::bind_front_handler(&WsSession::OnRead, shared_from_this()));
+}
+
+void WsSession::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+    if (ec == websocket::error::closed)
+        return;
+    if (ec)
+        return LOGSRV().Error(ec, server_logging::Server::Where::read);
+    auto command = beast::buffers_to_string(buffer_.data());
+    buffer_.consume(buffer_.size());
+    // команда с ошибкой разбора пропускается, а ушедший из игры игрок
+    // закрывает канал
+    auto [body, err] = app_.ActionMove(token_, command);
+    if (err == app::error_code::UnknownToken)
+        return Close(websocket::close_code::normal);
+    Read();
+}
+
+void WsSession::Close(websocket::close_code code) {
+    if (closing_)
+        return;
+    closing_ = true;
+    pending_.reset();
+    // ожидающее чтение завершится закрытием, после чего сессия удаляется
+    // и выпадает из подписчиков StateFeed
+    ws_.async_close(code, [self = shared_from_this()](beast::error_code) {});
+}
+
+void WsSession::Push(app::StateFeed::Frame frame) {
+    net::post(ws_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable {
+        if (self->closing_)
+            return;
+        // игрок ушёл из игры (простой), команд от него нет, поэтому
+        // токен перепроверяется здесь, а не только в OnRead
+        if (!self->app_.ResolveToken(self->token_))
+            return self->Close(websocket::close_code::policy_error);
+        // кадр, не успевший уйти, заменяется более новым
+        self->pending_ = std::move(frame);
+        if (!self->writing_)
+            self->WriteNext();
+    });
+}
+
+void WsSession::WriteNext() {
+    writing_ = std::move(pending_);
+    pending_.reset();
+    ws_.text(true);
+    ws_.async_write(net::buffer(*writing_),
+        beast::bind_front_handler(&WsSession::OnWrite, shared_from_this()));
+}
+
+void WsSession::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    writing_.reset();
+    if (ec)
+        return LOGSRV().Error(ec, server_logging::Server::Where::write);
+    if (pending_ && !closing_)
+        WriteNext();
+}
+
+}  // namespace http_handler
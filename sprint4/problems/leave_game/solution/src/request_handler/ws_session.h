@@ -0,0 +1,62 @@
+#pragma once
+#include "../sdk.h"
+#include <memory>
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include "../app.h"
+#include "../request_target.h"
+#include "../state_feed.h"
+
+namespace http_handler {
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+namespace net = boost::asio;
+
+// WebSocket-канал игрока (GET /api/v1/game/ws с заголовком Upgrade).
+// Токен из заголовка Authorization проверяется при подключении и перед
+// каждым кадром состояния: канал ушедшего из игры игрока закрывается.
+// Клиент присылает команды движения в формате запроса action ({"move": "L"}),
+// сервер после каждого тика присылает состояние сессии в формате ответа state.
+// Медленный клиент не копит кадры: пока идёт запись, ожидает отправки
+// только последний пришедший кадр, более старые отбрасываются
+class WsSession : public std::enable_shared_from_this<WsSession>
+                , public app::StateFeed::Subscriber {
+public:
+    using HttpRequest = http::request<http::string_body>;
+
+    WsSession(beast::tcp_stream&& stream, app::App& app, app::StateFeed& feed);
+    ~WsSession();
+    WsSession(const WsSession&) = delete;
+    WsSession& operator=(const WsSession&) = delete;
+
+    // Проверяет запрос и токен и завершает рукопожатие
+    void Run(HttpRequest&& request, const http_server::RequestTarget& target);
+    void Push(app::StateFeed::Frame frame) override;
+
+private:
+    websocket::stream<beast::tcp_stream> ws_;
+    app::App& app_;
+    app::StateFeed& feed_;
+    HttpRequest request_;
+    app::Token token_{std::string{}};
+    beast::flat_buffer buffer_;
+    // доступны только из strand соединения
+    app::StateFeed::Frame writing_;
+    app::StateFeed::Frame pending_;
+    bool closing_ = false;
+
+    void Reject(http::response<http::string_body>&& response);
+    void OnAccept(beast::error_code ec);
+    void Read();
+    void OnRead(beast::error_code ec, std::size_t bytes_read);
+    void Close(websocket::close_code code);
+    void WriteNext();
+    void OnWrite(beast::error_code ec, std::size_t bytes_written);
+};
+
+}  // namespace http_handler
@@ -0,0 +1,58 @@
+#include "request_target.h"
+
+namespace http_server {
+
+namespace {
+int HexValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+void AppendDecoded(std::string& out, std::string_view src) {
+    for (size_t pos = 0; pos < src.size(); ++pos) {
+        const char c = src[pos];
+        // '%' без двух шестнадцатеричных цифр остаётся как есть
+        if (c == '%' && pos + 2 < src.size()) {
+            const int high = HexValue(src[pos + 1]);
+            const int low = HexValue(src[pos + 2]);
+            if (high >= 0 && low >= 0) {
+                out += static_cast<char>(high * 16 + low);
+                pos += 2;
+                continue;
+            }
+        }
+        if (c == '+')
+            out += ' ';
+        else if (c >= 'A' && c <= 'Z')
+            out += static_cast<char>(c - 'A' + 'a');
+        else
+            out += c;
+    }
+}
+}  // namespace
+
+std::string uriDecode(std::string_view src) {
+    std::string out;
+    out.reserve(src.size());
+    AppendDecoded(out, src);
+    return out;
+}
+
+RequestTarget::RequestTarget(std::string_view raw) {
+    // декодированная строка не длиннее исходной: одно выделение памяти
+    decoded_.reserve(raw.size());
+    const auto question = raw.find('?');
+    AppendDecoded(decoded_, raw.substr(0, question));
+    path_size_ = decoded_.size();
+    if (question != std::string_view::npos) {
+        decoded_ += '?';
+        AppendDecoded(decoded_, raw.substr(question + 1));
+    }
+}
+
+}  // namespace http_server
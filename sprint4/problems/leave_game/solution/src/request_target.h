@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+namespace http_server {
+
+// Декодирует %XX и '+' (пробел), латинские буквы приводит к нижнему регистру
+std::string uriDecode(std::string_view src);
+
+// Target запроса, разобранный один раз при чтении запроса: декодированные
+// путь и строка параметров после '?'. Обе части лежат в одной строке,
+// представления строятся по смещению, поэтому объект перемещается вместе
+// с запросом без копирования и пересчёта
+class RequestTarget {
+public:
+    RequestTarget() = default;
+    explicit RequestTarget(std::string_view raw);
+
+    // Путь без параметров
+    std::string_view Path() const noexcept {
+        return std::string_view{decoded_}.substr(0, path_size_);
+    }
+    // Есть ли в target '?'
+    bool HasQuery() const noexcept {
+        return path_size_ < decoded_.size();
+    }
+    // Часть после '?'; пусто - параметров нет
+    std::string_view Query() const noexcept {
+        return HasQuery() ? std::string_view{decoded_}.substr(path_size_ + 1) : std::string_view{};
+    }
+    // Весь target после декодирования
+    std::string_view Decoded() const noexcept {
+        return decoded_;
+    }
+
+private:
+    std::string decoded_;
+    size_t path_size_ = 0;
+};
+
+}  // namespace http_server
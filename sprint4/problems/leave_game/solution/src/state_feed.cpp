@@ -0,0 +1,60 @@
+#include "state_feed.h"
+#include <algorithm>
+
+#include "app.h"
+
+namespace app {
+
+StateFeed::Frame StateFeed::MakeFrame(std::shared_ptr<const model::SessionSnapshot> snapshot) {
+    const auto& body = App::GetStateBody(*snapshot);
+    return Frame{std::move(snapshot), &body};
+}
+
+void StateFeed::Subscribe(const model::GameSession& session, std::weak_ptr<Subscriber> subscriber) {
+    auto snapshot = session.GetSnapshot();
+    std::lock_guard lock{mutex_};
+    auto [it, inserted] = channels_.try_emplace(&session);
+    if (inserted)
+        it->second.version = snapshot->version;
+    if (auto alive = subscriber.lock()) {
+        it->second.subscribers.push_back(std::move(subscriber));
+        alive->Push(MakeFrame(std::move(snapshot)));
+    }
+}
+
+void StateFeed::Publish() {
+    std::lock_guard lock{mutex_};
+    for (auto it = channels_.begin(); it != channels_.end();) {
+        auto& [session, channel] = *it;
+        std::erase_if(channel.subscribers, [](const auto& subscriber) {
+            return subscriber.expired();
+        });
+        if (channel.subscribers.empty()) {
+            it = channels_.erase(it);
+            continue;
+        }
+        // снимок публикуется атомарно, strand сессии для чтения не нужен
+        auto snapshot = session->GetSnapshot();
+        if (snapshot->version != channel.version) {
+            channel.version = snapshot->version;
+            auto frame = MakeFrame(std::move(snapshot));
+            for (const auto& subscriber : channel.subscribers) {
+                if (auto alive = subscriber.lock())
+                    alive->Push(frame);
+            }
+        }
+        ++it;
+    }
+}
+
+size_t StateFeed::GetSubscriberCount() const {
+    std::lock_guard lock{mutex_};
+    size_t count = 0;
+    for (const auto& [session, channel] : channels_) {
+        count += std::count_if(channel.subscribers.begin(), channel.subscribers.end(),
+            [](const auto& subscriber) { return !subscriber.expired(); });
+    }
+    return count;
+}
+
+}  // namespace app
@@ -0,0 +1,54 @@
+#pragma once
+#include "sdk.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "model/model.h"
+
+namespace app {
+
+// Рассылка состояния сессий подписчикам (WebSocket-клиентам).
+// После тика для каждой сессии с подписчиками берётся её снимок, и если
+// версия изменилась, всем подписчикам уходит один и тот же кадр - тело
+// ответа state, сериализованное один раз на снимок.
+class StateFeed {
+public:
+    // Кадр держит снимок, в котором лежит его текст, поэтому не копируется
+    using Frame = std::shared_ptr<const std::string>;
+
+    class Subscriber {
+    public:
+        // Вызывается под блокировкой StateFeed: реализация не должна
+        // блокироваться и обращаться к StateFeed
+        virtual void Push(Frame frame) = 0;
+    protected:
+        ~Subscriber() = default;
+    };
+
+    StateFeed() = default;
+    StateFeed(const StateFeed&) = delete;
+    StateFeed& operator=(const StateFeed&) = delete;
+
+    // Подписывает на сессию и сразу отправляет текущее состояние.
+    // Подписка снимается, когда подписчик удалён
+    void Subscribe(const model::GameSession& session, std::weak_ptr<Subscriber> subscriber);
+    // Рассылает новые состояния сессий, вызывается после тика
+    void Publish();
+    size_t GetSubscriberCount() const;
+
+    static Frame MakeFrame(std::shared_ptr<const model::SessionSnapshot> snapshot);
+
+private:
+    struct Channel {
+        uint64_t version = 0;
+        std::vector<std::weak_ptr<Subscriber>> subscribers;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<const model::GameSession*, Channel> channels_;
+};
+
+}  // namespace app
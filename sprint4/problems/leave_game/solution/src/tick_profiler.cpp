@@ -0,0 +1,164 @@
+#include "tick_profiler.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ticker {
+using namespace std::literals;
+
+namespace {
+json::string_view ToKey(std::string_view name) {
+    return {name.data(), name.size()};
+}
+
+// Перцентиль по рангу: наименьшее значение, не меньше которого доля p замеров
+uint32_t Rank(const std::vector<uint32_t>& sorted, double p) {
+    auto rank = static_cast<size_t>(p * static_cast<double>(sorted.size()) + 0.999999);
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+json::object ToJson(const Percentiles& percentiles) {
+    return json::object{
+        {"count", percentiles.count},
+        {"p50_us", percentiles.p50.count()},
+        {"p95_us", percentiles.p95.count()},
+        {"p99_us", percentiles.p99.count()},
+        {"max_us", percentiles.max.count()}};
+}
+}  // namespace
+
+void RollingWindow::Add(nanoseconds time) {
+    const auto micro = std::clamp<int64_t>(duration_cast<microseconds>(time).count(),
+        0, std::numeric_limits<uint32_t>::max());
+    samples_[next_] = static_cast<uint32_t>(micro);
+    next_ = (next_ + 1) % SIZE;
+    ++count_;
+}
+
+Percentiles RollingWindow::Get() const {
+    Percentiles result;
+    result.count = count_;
+    if (count_ == 0)
+        return result;
+    std::vector<uint32_t> sorted(samples_.begin(),
+        samples_.begin() + static_cast<ptrdiff_t>(std::min<uint64_t>(count_, SIZE)));
+    std::sort(sorted.begin(), sorted.end());
+    result.p50 = microseconds{Rank(sorted, 0.50)};
+    result.p95 = microseconds{Rank(sorted, 0.95)};
+    result.p99 = microseconds{Rank(sorted, 0.99)};
+    result.max = microseconds{sorted.back()};
+    return result;
+}
+
+TickProfiler::TickProfiler(milliseconds period, milliseconds summary_period)
+    : period_(period)
+    , summary_period_(summary_period) {
+}
+
+void TickProfiler::RecordTimer(milliseconds delta) {
+    if (period_ == 0ms)
+        return;
+    std::lock_guard lock{mutex_};
+    if (delta > period_ + period_ / 4)
+        ++counters_.late_timer_ticks;
+    if (const auto periods = delta / period_; periods > 1)
+        counters_.skipped_periods += static_cast<uint64_t>(periods - 1);
+}
+
+void TickProfiler::RecordHandlerError() {
+    std::lock_guard lock{mutex_};
+    ++counters_.handler_errors;
+}
+
+void TickProfiler::RecordCoalesced() {
+    std::lock_guard lock{mutex_};
+    ++counters_.coalesced_ticks;
+}
+
+void TickProfiler::RecordTick(const TickTimes& times) {
+    std::lock_guard lock{mutex_};
+    ++counters_.ticks;
+    const auto total = times.stages[static_cast<size_t>(Stage::Total)];
+    if (period_ != 0ms && total > period_)
+        ++counters_.overruns;
+    for (size_t stage = 0; stage < STAGES; ++stage) {
+        if (stage != static_cast<size_t>(Stage::Save))
+            stages_[stage].Add(times.stages[stage]);
+    }
+    for (const auto& session : times.sessions) {
+        auto it = sessions_.find(session.session);
+        if (it == sessions_.end())
+            it = sessions_.try_emplace(session.session).first;
+        auto& windows = it->second;
+        for (size_t phase = 0; phase < model::TICK_PHASES; ++phase)
+            windows[phase].Add(session.phases[phase]);
+        windows[RETIRE_PHASE].Add(session.retirement);
+    }
+}
+
+void TickProfiler::RecordSave(nanoseconds time) {
+    std::lock_guard lock{mutex_};
+    stages_[static_cast<size_t>(Stage::Save)].Add(time);
+}
+
+TickReport TickProfiler::GetReport() const {
+    // под мьютексом только копирование окон: сортировка для перцентилей
+    // не должна задерживать запись тика
+    TickReport report;
+    report.period = period_;
+    std::array<RollingWindow, STAGES> stages;
+    std::vector<std::pair<std::string, std::array<RollingWindow, SESSION_PHASES>>> sessions;
+    {
+        std::lock_guard lock{mutex_};
+        report.counters = counters_;
+        stages = stages_;
+        sessions.assign(sessions_.begin(), sessions_.end());
+    }
+    for (size_t stage = 0; stage < STAGES; ++stage)
+        report.stages[stage] = stages[stage].Get();
+    for (const auto& [session, windows] : sessions) {
+        auto& phases = report.sessions[session];
+        for (size_t phase = 0; phase < SESSION_PHASES; ++phase)
+            phases[phase] = windows[phase].Get();
+    }
+    return report;
+}
+
+bool TickProfiler::SummaryDue(steady_clock::time_point now) {
+    if (summary_period_ == 0ms)
+        return false;
+    std::lock_guard lock{mutex_};
+    if (now - last_summary_ < summary_period_)
+        return false;
+    last_summary_ = now;
+    return true;
+}
+
+json::object TickProfiler::ToJson(const TickReport& report) {
+    json::object counters{
+        {"ticks", report.counters.ticks},
+        {"overruns", report.counters.overruns},
+        {"late_timer_ticks", report.counters.late_timer_ticks},
+        {"skipped_periods", report.counters.skipped_periods},
+        {"coalesced_ticks", report.counters.coalesced_ticks},
+        {"handler_errors", report.counters.handler_errors}};
+    json::object stages;
+    for (size_t stage = 0; stage < STAGES; ++stage)
+        stages[ToKey(STAGE_NAMES[stage])] = ticker::ToJson(report.stages[stage]);
+    json::object sessions;
+    for (const auto& [session, phases] : report.sessions) {
+        json::object session_phases;
+        for (size_t phase = 0; phase < model::TICK_PHASES; ++phase)
+            session_phases[ToKey(model::TICK_PHASE_NAMES[phase])] = ticker::ToJson(phases[phase]);
+        session_phases[ToKey(RETIRE_PHASE_NAME)] = ticker::ToJson(phases[RETIRE_PHASE]);
+        sessions[session] = std::move(session_phases);
+    }
+    return json::object{
+        {"period_ms", report.period.count()},
+        {"window", RollingWindow::SIZE},
+        {"counters", std::move(counters)},
+        {"stages", std::move(stages)},
+        {"sessions", std::move(sessions)}};
+}
+
+}  // namespace ticker
@@ -0,0 +1,130 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/json.hpp>
+
+#include "model/model.h"
+
+namespace ticker {
+namespace json = boost::json;
+using namespace std::chrono;
+
+// Этапы тика, общие для всех сессий
+enum class Stage {
+    // от начала тика до ответа последней сессии
+    Sessions,
+    // удаление ушедших игроков из таблиц и запись в базу
+    Retirement,
+    // подписчики тика
+    Notify,
+    // запись файла состояния, замеряется при каждом сохранении
+    Save,
+    Total
+};
+inline constexpr size_t STAGES = 5;
+inline constexpr std::array<std::string_view, STAGES> STAGE_NAMES{
+    "sessions", "retirement", "notify", "save", "total"};
+
+// Фазы тика внутри сессии: фазы GameSession::Tick и поиск простаивающих собак
+inline constexpr size_t SESSION_PHASES = model::TICK_PHASES + 1;
+inline constexpr size_t RETIRE_PHASE = model::TICK_PHASES;
+inline constexpr std::string_view RETIRE_PHASE_NAME = "retire_idle_dogs";
+
+struct Percentiles {
+    uint64_t count = 0;
+    microseconds p50{0};
+    microseconds p95{0};
+    microseconds p99{0};
+    microseconds max{0};
+};
+
+// Последние SIZE замеров. Перцентили считаются по окну при запросе отчёта,
+// добавление замера - запись в кольцо
+class RollingWindow {
+public:
+    static constexpr size_t SIZE = 512;
+
+    void Add(nanoseconds time);
+    Percentiles Get() const;
+
+private:
+    std::array<uint32_t, SIZE> samples_{};
+    size_t next_ = 0;
+    uint64_t count_ = 0;
+};
+
+// Замеры тика одной сессии
+struct SessionTickTimes {
+    // id карты сессии
+    std::string session;
+    model::TickTimings phases{};
+    nanoseconds retirement{0};
+};
+
+struct TickTimes {
+    std::vector<SessionTickTimes> sessions;
+    // Stage::Save заполняется отдельно, в RecordSave
+    std::array<nanoseconds, STAGES> stages{};
+};
+
+struct TickCounters {
+    uint64_t ticks = 0;
+    // тик выполнялся дольше периода
+    uint64_t overruns = 0;
+    // таймер сработал позже периода больше чем на четверть
+    uint64_t late_timer_ticks = 0;
+    // целые периоды, за которые таймер не срабатывал
+    uint64_t skipped_periods = 0;
+    // тики таймера, склеенные с ожидающим тиком, пока выполнялся предыдущий
+    uint64_t coalesced_ticks = 0;
+    uint64_t handler_errors = 0;
+};
+
+struct TickReport {
+    milliseconds period{0};
+    TickCounters counters;
+    std::array<Percentiles, STAGES> stages;
+    std::map<std::string, std::array<Percentiles, SESSION_PHASES>> sessions;
+};
+
+// Профиль тиков: скользящие перцентили этапов и фаз по сессиям, счётчики
+// перегрузки. Пишут таймер и координатор из strand координатора, отчёт
+// читается из любого потока, поэтому всё под одним мьютексом: запись -
+// несколько раз за тик
+class TickProfiler {
+public:
+    // period - период тика, 0 - тики по запросу API, перегрузка не считается;
+    // summary_period - период сводки в журнале, 0 - без сводок
+    explicit TickProfiler(milliseconds period = milliseconds{0},
+        milliseconds summary_period = milliseconds{0});
+
+    // Срабатывание таймера, delta - время с прошлого срабатывания
+    void RecordTimer(milliseconds delta);
+    void RecordHandlerError();
+    void RecordCoalesced();
+    void RecordTick(const TickTimes& times);
+    void RecordSave(nanoseconds time);
+
+    TickReport GetReport() const;
+    // true не чаще раза в summary_period, первый раз - через summary_period
+    bool SummaryDue(steady_clock::time_point now);
+
+    static json::object ToJson(const TickReport& report);
+
+private:
+    mutable std::mutex mutex_;
+    const milliseconds period_;
+    const milliseconds summary_period_;
+    steady_clock::time_point last_summary_ = steady_clock::now();
+    TickCounters counters_;
+    std::array<RollingWindow, STAGES> stages_;
+    std::map<std::string, std::array<RollingWindow, SESSION_PHASES>, std::less<>> sessions_;
+};
+
+}  // namespace ticker
@@ -1,6 +1,10 @@
 #pragma once
 #include <boost/asio.hpp>
 #include <chrono>
+#include <memory>
+
+#include "log.h"
+#include "tick_profiler.h"
 
 namespace ticker {
 namespace net = boost::asio;
@@ -11,11 +15,14 @@ public:
     using Strand = net::strand<net::io_context::executor_type>;
     using Handler = std::function<void(milliseconds delta)>;
 
-    // Функция handler будет вызываться внутри strand с интервалом period
-    Ticker(Strand strand, milliseconds period, Handler handler)
+    // Функция handler будет вызываться внутри strand с интервалом period.
+    // profiler, если задан, получает задержки таймера и ошибки обработчика
+    Ticker(Strand strand, milliseconds period, Handler handler,
+            std::shared_ptr<TickProfiler> profiler = nullptr)
         : strand_{ strand }
         , period_{ period }
-        , handler_{ std::move(handler) } {
+        , handler_{ std::move(handler) }
+        , profiler_{ std::move(profiler) } {
     }
 
     void Start() {
@@ -27,13 +34,23 @@ public:
             });
     }
 
+    // Новые тики не запускаются; тик, уже идущий в координаторе, завершается
+    void Stop() {
+        net::dispatch(strand_, [self = shared_from_this()] {
+            self->stopped_ = true;
+            self->timer_.cancel();
+            });
+    }
+
 private:
     using Clock = steady_clock;
     Strand strand_;
     milliseconds period_;
     net::steady_timer timer_{strand_};
     Handler handler_;
+    std::shared_ptr<TickProfiler> profiler_;
     steady_clock::time_point last_tick_;
+    bool stopped_ = false;
     
     void ScheduleTick() {
         assert(strand_.running_in_this_thread());
@@ -45,14 +62,25 @@ private:
 
     void OnTick(sys::error_code ec) {
         using namespace std::chrono;
-        if (!ec) {
+        if (!ec && !stopped_) {
             auto this_tick = Clock::now();
             auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
             last_tick_ = this_tick;
+            if (profiler_)
+                profiler_->RecordTimer(delta);
             try {
                 handler_(delta);
             }
+            catch (const std::exception& ex) {
+                // тикер продолжает работу, ошибка остаётся в журнале
+                if (profiler_)
+                    profiler_->RecordHandlerError();
+                LOGSRV().Msg("Tick error", ex.what());
+            }
             catch (...) {
+                if (profiler_)
+                    profiler_->RecordHandlerError();
+                LOGSRV().Msg("Tick error", "unknown exception");
             }
             ScheduleTick();
         }
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+namespace util {
+
+/**
+ * shared_ptr с атомарными чтением и записью.
+ * Используется для публикации неизменяемых данных (read-copy-update):
+ * писатель собирает новый объект и подменяет указатель, читатели
+ * получают либо старую, либо новую версию целиком и держат её,
+ * пока владеют полученным shared_ptr.
+ * Если стандартная библиотека не поддерживает std::atomic<std::shared_ptr>
+ * (gcc 11), используются свободные функции std::atomic_load/std::atomic_store.
+ */
+template <typename T>
+class AtomicSharedPtr {
+public:
+    AtomicSharedPtr() = default;
+    explicit AtomicSharedPtr(std::shared_ptr<T> ptr)
+        : ptr_(std::move(ptr)) {
+    }
+    AtomicSharedPtr(const AtomicSharedPtr& other)
+        : ptr_(other.Load()) {
+    }
+    AtomicSharedPtr& operator=(const AtomicSharedPtr& other) {
+        Store(other.Load());
+        return *this;
+    }
+
+    std::shared_ptr<T> Load() const noexcept {
+#ifdef __cpp_lib_atomic_shared_ptr
+        return ptr_.load(std::memory_order_acquire);
+#else
+        return std::atomic_load_explicit(&ptr_, std::memory_order_acquire);
+#endif
+    }
+
+    void Store(std::shared_ptr<T> ptr) noexcept {
+#ifdef __cpp_lib_atomic_shared_ptr
+        ptr_.store(std::move(ptr), std::memory_order_release);
+#else
+        std::atomic_store_explicit(&ptr_, std::move(ptr), std::memory_order_release);
+#endif
+    }
+
+private:
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<T>> ptr_;
+#else
+    std::shared_ptr<T> ptr_;
+#endif
+};
+
+}  // namespace util
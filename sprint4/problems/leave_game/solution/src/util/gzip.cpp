@@ -0,0 +1,50 @@
+#include "gzip.h"
+#include <boost/beast/zlib/deflate_stream.hpp>
+#include <boost/crc.hpp>
+#include <stdexcept>
+
+namespace util {
+
+namespace zlib = boost::beast::zlib;
+
+namespace {
+void PutUint32LE(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>(value & 0xFF));
+        value >>= 8;
+    }
+}
+}  // namespace
+
+uint32_t Crc32(std::string_view data) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data.data(), data.size());
+    return crc.checksum();
+}
+
+std::string GzipCompress(std::string_view data) {
+    // заголовок gzip: deflate, без имени файла и времени, ОС неизвестна
+    static constexpr char HEADER[] = {'\x1f', '\x8b', '\x08', 0, 0, 0, 0, 0, 0, '\xff'};
+    zlib::deflate_stream deflate;
+    // windowBits 15 без обёртки zlib - «сырой» deflate, как требует gzip
+    deflate.reset(9, 15, 8, zlib::Strategy::normal);
+    std::string out{HEADER, sizeof(HEADER)};
+    const size_t header_size = out.size();
+    out.resize(header_size + deflate.upper_bound(data.size()));
+
+    zlib::z_params params;
+    params.next_in = data.data();
+    params.avail_in = data.size();
+    params.next_out = out.data() + header_size;
+    params.avail_out = out.size() - header_size;
+    boost::system::error_code ec;
+    deflate.write(params, zlib::Flush::finish, ec);
+    if (ec && ec != zlib::error::end_of_stream)
+        throw std::runtime_error("gzip compression failed: " + ec.message());
+    out.resize(header_size + params.total_out);
+    PutUint32LE(out, Crc32(data));
+    PutUint32LE(out, static_cast<uint32_t>(data.size()));
+    return out;
+}
+
+}  // namespace util
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Сжимает данные в формат gzip (RFC 1952). Используется для готовых тел
+// ответов, которые сжимаются один раз и отдаются с Content-Encoding: gzip
+std::string GzipCompress(std::string_view data);
+
+// CRC-32 (как в gzip и zip)
+uint32_t Crc32(std::string_view data);
+
+}  // namespace util
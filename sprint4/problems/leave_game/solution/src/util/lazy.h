@@ -0,0 +1,33 @@
+#pragma once
+#include <mutex>
+#include <utility>
+
+namespace util {
+
+/**
+ * Значение, вычисляемое один раз при первом обращении.
+ * Потокобезопасно: при одновременных обращениях build вызывается
+ * ровно одним потоком, остальные ждут и получают готовое значение.
+ * Если build выбросил исключение, следующее обращение повторит попытку.
+ */
+template <typename T>
+class Lazy {
+public:
+    Lazy() = default;
+    Lazy(const Lazy&) = delete;
+    Lazy& operator=(const Lazy&) = delete;
+
+    template <typename Fn>
+    const T& Get(Fn&& build) const {
+        std::call_once(once_, [&] {
+            value_ = std::forward<Fn>(build)();
+        });
+        return value_;
+    }
+
+private:
+    mutable std::once_flag once_;
+    mutable T value_{};
+};
+
+}  // namespace util
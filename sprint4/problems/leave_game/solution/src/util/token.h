@@ -31,6 +31,23 @@ static inline std::string_view GetToken(std::string_view autorization_text) {
     return out;
 }
 
+// Заголовок "Authorization: Bearer <expected>". Сравнение не зависит по времени
+// от позиции первого несовпадения, чтобы токен нельзя было подобрать по символу
+static inline bool CheckBearer(std::string_view autorization_text, std::string_view expected) {
+    std::string_view bearer = "Bearer "sv;
+    if (expected.empty() || !autorization_text.starts_with(bearer))
+        return false;
+    auto token = autorization_text.substr(bearer.size());
+    while (!token.empty() && token.back() == ' ')
+        token.remove_suffix(1);
+    if (token.size() != expected.size())
+        return false;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < token.size(); ++i)
+        diff |= static_cast<unsigned char>(token[i] ^ expected[i]);
+    return diff == 0;
+}
+
 static inline std::optional<Token> ExtractTokenFromStringViewAndCheckIt(std::string_view body)
 {
     if (body.empty())
@@ -0,0 +1,129 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <charconv>
+#include <unistd.h>
+
+namespace util {
+using namespace std::literals;
+
+namespace {
+// Микросекунды с тремя знаками после точки: 1234567 нс -> 1234.567
+void AppendMicros(std::string& out, std::chrono::nanoseconds time) {
+    const auto nanos = std::max<int64_t>(time.count(), 0);
+    char buffer[24];
+    auto end = std::to_chars(buffer, buffer + sizeof(buffer), nanos / 1000).ptr;
+    const auto fraction = static_cast<int>(nanos % 1000);
+    *end++ = '.';
+    *end++ = static_cast<char>('0' + fraction / 100);
+    *end++ = static_cast<char>('0' + fraction / 10 % 10);
+    *end++ = static_cast<char>('0' + fraction % 10);
+    out.append(buffer, end);
+}
+
+void AppendNumber(std::string& out, uint64_t value) {
+    char buffer[24];
+    out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+}  // namespace
+
+void Tracer::Enable() {
+    const auto buffer_events = buffer_events_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard lock{buffers_mutex_};
+        for (auto& buffer : buffers_) {
+            std::lock_guard buffer_lock{buffer->mutex};
+            buffer->events.assign(buffer_events, Event{});
+            buffer->next = 0;
+            buffer->size = 0;
+        }
+    }
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::Disable() {
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+Tracer::Buffer& Tracer::ThreadBuffer() {
+    // буфер принадлежит реестру и переживает поток: его события попадут в дамп
+    thread_local Buffer* buffer = nullptr;
+    if (!buffer) {
+        auto created = std::make_shared<Buffer>();
+        created->events.resize(buffer_events_.load(std::memory_order_relaxed));
+        std::lock_guard lock{buffers_mutex_};
+        created->thread = static_cast<uint32_t>(buffers_.size() + 1);
+        buffers_.push_back(created);
+        buffer = created.get();
+    }
+    return *buffer;
+}
+
+void Tracer::Record(std::string_view name, std::string_view category, Clock::time_point start,
+        Clock::time_point end, uint64_t request) {
+    auto& buffer = ThreadBuffer();
+    // блокировка своего буфера конкурирует только с дампом
+    std::lock_guard lock{buffer.mutex};
+    auto& events = buffer.events;
+    events[buffer.next] = Event{name, category, start, end - start, request};
+    buffer.next = (buffer.next + 1) % events.size();
+    buffer.size = std::min(buffer.size + 1, events.size());
+}
+
+std::vector<std::pair<uint32_t, Tracer::Event>> Tracer::Collect() const {
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    {
+        std::lock_guard lock{buffers_mutex_};
+        buffers = buffers_;
+    }
+    std::vector<std::pair<uint32_t, Event>> result;
+    for (const auto& buffer : buffers) {
+        std::lock_guard lock{buffer->mutex};
+        const auto& events = buffer->events;
+        // после переполнения самое старое событие - на позиции следующей записи
+        const size_t first = buffer->size == events.size() ? buffer->next : 0;
+        for (size_t i = 0; i < buffer->size; ++i)
+            result.emplace_back(buffer->thread, events[(first + i) % events.size()]);
+    }
+    std::stable_sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first != rhs.first ? lhs.first < rhs.first : lhs.second.start < rhs.second.start;
+    });
+    return result;
+}
+
+std::string Tracer::Dump() const {
+    const auto events = Collect();
+    const auto pid = static_cast<uint64_t>(::getpid());
+    std::string out;
+    out.reserve(64 + events.size() * 128);
+    out += "{\"traceEvents\":["sv;
+    bool first = true;
+    for (const auto& [thread, event] : events) {
+        if (!first)
+            out += ',';
+        first = false;
+        // имена - литералы из кода, экранирование не требуется
+        out += "{\"name\":\""sv;
+        out += event.name;
+        out += "\",\"cat\":\""sv;
+        out += event.category;
+        out += "\",\"ph\":\"X\",\"pid\":"sv;
+        AppendNumber(out, pid);
+        out += ",\"tid\":"sv;
+        AppendNumber(out, thread);
+        out += ",\"ts\":"sv;
+        AppendMicros(out, event.start - epoch_);
+        out += ",\"dur\":"sv;
+        AppendMicros(out, event.duration);
+        if (event.request != 0) {
+            out += ",\"args\":{\"request\":"sv;
+            AppendNumber(out, event.request);
+            out += '}';
+        }
+        out += '}';
+    }
+    out += "],\"displayTimeUnit\":\"ms\"}"sv;
+    return out;
+}
+
+}  // namespace util
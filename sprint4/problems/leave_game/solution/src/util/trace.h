@@ -0,0 +1,136 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define TRACER() util::Tracer::GetInstance()
+
+namespace util {
+
+// Запись интервалов выполнения в формате Chrome Trace Event. Трассировка
+// включается во время работы; выключенная стоит одну relaxed-загрузку флага
+// и предсказуемое ветвление в начале интервала. Каждый поток пишет в свой
+// кольцевой буфер, при переполнении затираются старые события
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t DEFAULT_BUFFER_EVENTS = 1 << 16;
+
+    // Завершённый интервал, в дампе - событие "X".
+    // name и category - строковые литералы: буфер хранит только ссылки
+    struct Event {
+        std::string_view name;
+        std::string_view category;
+        Clock::time_point start;
+        Clock::duration duration;
+        // номер HTTP-запроса, 0 - интервал не относится к запросу
+        uint64_t request = 0;
+    };
+
+    static Tracer& GetInstance() {
+        static Tracer obj;
+        return obj;
+    }
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    static bool Enabled() noexcept {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+    // Ёмкость буфера потока в событиях, применяется при следующем Enable
+    void SetBufferEvents(size_t buffer_events) {
+        buffer_events_.store(std::max<size_t>(buffer_events, 1), std::memory_order_relaxed);
+    }
+    // Очищает буферы и начинает запись
+    void Enable();
+    void Disable();
+
+    void Record(std::string_view name, std::string_view category, Clock::time_point start,
+        Clock::time_point end, uint64_t request = CurrentRequest());
+    // События всех потоков, упорядоченные по потокам и времени начала
+    std::vector<std::pair<uint32_t, Event>> Collect() const;
+    // {"traceEvents":[...]} для chrome://tracing, Perfetto и
+    // FlameGraph/stackcollapse-chrome-tracing.py
+    std::string Dump() const;
+
+    // Номер запроса, к которому относятся интервалы текущего потока
+    static uint64_t CurrentRequest() noexcept {
+        return current_request_;
+    }
+    static uint64_t NextRequest() noexcept {
+        return next_request_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    friend class TraceRequestScope;
+
+    struct Buffer {
+        std::mutex mutex;
+        std::vector<Event> events;
+        // позиция следующей записи и число записанных событий
+        size_t next = 0;
+        size_t size = 0;
+        uint32_t thread = 0;
+    };
+
+    static inline std::atomic<bool> enabled_{false};
+    static inline std::atomic<uint64_t> next_request_{1};
+    static inline thread_local uint64_t current_request_ = 0;
+
+    const Clock::time_point epoch_ = Clock::now();
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<Buffer>> buffers_;
+    std::atomic<size_t> buffer_events_{DEFAULT_BUFFER_EVENTS};
+
+    Tracer() = default;
+    Buffer& ThreadBuffer();
+};
+
+// Интервал от конструктора до деструктора
+class TraceSpan {
+public:
+    TraceSpan(std::string_view name, std::string_view category) noexcept {
+        if (Tracer::Enabled()) {
+            name_ = name;
+            category_ = category;
+            start_ = Tracer::Clock::now();
+        }
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+    ~TraceSpan() {
+        if (!name_.empty())
+            TRACER().Record(name_, category_, start_, Tracer::Clock::now());
+    }
+
+private:
+    std::string_view name_;
+    std::string_view category_;
+    Tracer::Clock::time_point start_;
+};
+
+// Интервалы потока внутри области относятся к запросу request
+class TraceRequestScope {
+public:
+    explicit TraceRequestScope(uint64_t request) noexcept
+        : previous_(Tracer::current_request_) {
+        Tracer::current_request_ = request;
+    }
+    TraceRequestScope(const TraceRequestScope&) = delete;
+    TraceRequestScope& operator=(const TraceRequestScope&) = delete;
+    ~TraceRequestScope() {
+        Tracer::current_request_ = previous_;
+    }
+
+private:
+    uint64_t previous_;
+};
+
+}  // namespace util
@@ -0,0 +1,181 @@
+#include <boost/json.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/app.h"
+#include "../src/state_feed.h"
+#include "../src/json_loader.h"
+
+using namespace app;
+using namespace std::literals;
+namespace js = boost::json;
+
+SCENARIO("Per-session request routing") {
+    GIVEN("app with a loaded game") {
+        auto game = json_loader::LoadGame("../tests/config_test.json"sv);
+        App t_app{ *game, { 1, ""s } };
+        const auto body = R"({"userName": "Rex", "mapId": "map1"})"s;
+
+        WHEN("join target is resolved") {
+            auto* session = t_app.JoinTargetSession(body);
+            THEN("the map session is created once") {
+                REQUIRE(session != nullptr);
+                CHECK(t_app.JoinTargetSession(body) == session);
+                CHECK(game->GetGameSessionList().size() == 1);
+            }
+            THEN("invalid join does not create a session") {
+                CHECK(t_app.JoinTargetSession(R"({"userName": "", "mapId": "map1"})"sv) == nullptr);
+                CHECK(t_app.JoinTargetSession(R"({"userName": "Rex", "mapId": "none"})"sv) == nullptr);
+                CHECK(t_app.JoinTargetSession("{"sv) == nullptr);
+                CHECK(game->GetGameSessionList().size() == 1);
+            }
+        }
+
+        WHEN("players join the game") {
+            auto* session = t_app.JoinTargetSession(body);
+            auto [text, err] = t_app.ResponseJoin(body);
+            REQUIRE(err == JoinError::None);
+            Token token{std::string(js::parse(text).at("authToken").as_string())};
+            t_app.ResponseJoin(body);
+
+            THEN("token resolves to the session and the dog") {
+                auto ref = t_app.ResolveToken(token);
+                REQUIRE(ref);
+                CHECK(ref->session == session);
+                CHECK(session->FindDog(ref->dog_id));
+                CHECK_FALSE(t_app.ResolveToken(Token{"00000000000000000000000000000000"s}));
+            }
+            THEN("state and players bodies are serialized once per snapshot") {
+                auto [state, state_err] = t_app.GetState(token);
+                auto [players, players_err] = t_app.GetPlayers(token);
+                REQUIRE(state_err == error_code::None);
+                REQUIRE(players_err == error_code::None);
+                auto snapshot = session->GetSnapshot();
+                auto not_built_again = [] { FAIL("body is serialized again"); return ""s; };
+                CHECK(snapshot->state_body.Get(not_built_again) == state);
+                CHECK(snapshot->roster->body.Get(not_built_again) == players);
+                CHECK(t_app.GetState(token).first == state);
+                CHECK(js::parse(players).as_object().size() == 2);
+            }
+            AND_WHEN("one dog moves during a tick") {
+                session->Tick(0ms);
+                auto before = session->GetSnapshot();
+                auto ref = t_app.ResolveToken(token);
+                session->PushMove(ref->dog_id, model::Move::RIGHT);
+                session->Tick(10ms);
+                auto after = session->GetSnapshot();
+                THEN("the delta since the previous version holds only that dog") {
+                    auto delta = js::parse(App::GetStateDelta(*after, before->version)).as_object();
+                    CHECK(delta.at("since").as_uint64() == before->version);
+                    const auto& players = delta.at("players").as_object();
+                    REQUIRE(players.size() == 1);
+                    CHECK(players.contains(std::to_string(*ref->dog_id)));
+                    CHECK(delta.at("removedPlayers").as_array().empty());
+                }
+                THEN("a delta since an unknown version is the full state") {
+                    CHECK(App::GetStateDelta(*after, after->version + 1) == App::GetStateBody(*after));
+                }
+            }
+            AND_WHEN("dogs stay idle longer than retirement time") {
+                session->Tick(game->GetDogRetirementTime());
+                auto retired = t_app.RetireIdleDogs(*session);
+                THEN("only dogs of this session are retired") {
+                    CHECK(retired.size() == 2);
+                    CHECK(session->GetDogs().empty());
+                    CHECK(t_app.RetireIdleDogs(*session).empty());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Precomputed map bodies") {
+    GIVEN("app with a loaded game") {
+        auto game = json_loader::LoadGame("../tests/config_test.json"sv);
+        App t_app{ *game, { 1, ""s } };
+        const auto& bodies = t_app.GetMapBodies();
+
+        THEN("every map body is built at startup") {
+            auto map = bodies.GetMap("map1"sv);
+            REQUIRE(map);
+            CHECK(bodies.GetMap("map1"sv) == map);
+            CHECK(js::parse(map->body).at("id").as_string() == "map1");
+            CHECK(t_app.GetMapBodyJson("map1"sv).first == map->body);
+            CHECK(js::parse(bodies.GetMaps()->body).as_array().size() == game->GetMaps().size());
+        }
+        THEN("an unknown map has no body") {
+            CHECK_FALSE(bodies.GetMap("none"sv));
+            CHECK_FALSE(t_app.GetMapBodyJson("none"sv).second);
+        }
+        THEN("gzip copy and ETags describe the body") {
+            auto map = bodies.GetMap("map1"sv);
+            REQUIRE(map->gzip.size() > 18);
+            CHECK(map->gzip.substr(0, 2) == "\x1f\x8b"s);
+            const auto* size = reinterpret_cast<const unsigned char*>(map->gzip.data() + map->gzip.size() - 4);
+            CHECK((size[0] | size[1] << 8 | size[2] << 16 | size[3] << 24) == map->body.size());
+            CHECK(map->etag != map->gzip_etag);
+            CHECK(PrecomputedBody{map->body}.etag == map->etag);
+        }
+    }
+}
+
+namespace {
+struct FrameCollector : StateFeed::Subscriber {
+    std::vector<StateFeed::Frame> frames;
+    void Push(StateFeed::Frame frame) override {
+        frames.push_back(std::move(frame));
+    }
+};
+}  // namespace
+
+SCENARIO("State push feed") {
+    GIVEN("a session with two subscribers") {
+        auto game = json_loader::LoadGame("../tests/config_test.json"sv);
+        App t_app{ *game, { 1, ""s } };
+        const auto body = R"({"userName": "Rex", "mapId": "map1"})"s;
+        auto* session = t_app.JoinTargetSession(body);
+        auto [text, err] = t_app.ResponseJoin(body);
+        REQUIRE(err == JoinError::None);
+        Token token{std::string(js::parse(text).at("authToken").as_string())};
+        session->Tick(0ms);
+
+        StateFeed feed;
+        auto first = std::make_shared<FrameCollector>();
+        auto second = std::make_shared<FrameCollector>();
+        feed.Subscribe(*session, first);
+        feed.Subscribe(*session, second);
+
+        THEN("subscribers get the current state at once") {
+            REQUIRE(first->frames.size() == 1);
+            CHECK(*first->frames.back() == App::GetStateBody(*session->GetSnapshot()));
+            CHECK(feed.GetSubscriberCount() == 2);
+        }
+        WHEN("the session state does not change") {
+            session->Tick(0ms);
+            feed.Publish();
+            THEN("nothing is pushed") {
+                CHECK(first->frames.size() == 1);
+            }
+        }
+        WHEN("a dog moves during a tick") {
+            session->PushMove(t_app.ResolveToken(token)->dog_id, model::Move::RIGHT);
+            session->Tick(10ms);
+            feed.Publish();
+            THEN("both subscribers get the same frame") {
+                REQUIRE(first->frames.size() == 2);
+                REQUIRE(second->frames.size() == 2);
+                CHECK(first->frames.back() == second->frames.back());
+                CHECK(*first->frames.back() == App::GetStateBody(*session->GetSnapshot()));
+            }
+        }
+        WHEN("a subscriber is gone") {
+            second.reset();
+            session->PushMove(t_app.ResolveToken(token)->dog_id, model::Move::UP);
+            session->Tick(10ms);
+            feed.Publish();
+            THEN("it is unsubscribed") {
+                CHECK(feed.GetSubscriberCount() == 1);
+                CHECK(first->frames.size() == 2);
+            }
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/async_log.h"
+
+using namespace server_logging;
+using namespace std::literals;
+using Catch::Matchers::ContainsSubstring;
+using Catch::Matchers::StartsWith;
+using Catch::Matchers::EndsWith;
+
+namespace {
+std::vector<std::string> Lines(const std::string& text) {
+    std::vector<std::string> lines;
+    std::istringstream in{text};
+    for (std::string line; std::getline(in, line);)
+        lines.push_back(line);
+    return lines;
+}
+
+// Поток журнала забирает записи только по Flush
+AsyncLogConfig ManualConfig(size_t records, Overflow overflow) {
+    AsyncLogConfig config;
+    config.buffer_records = records;
+    config.overflow = overflow;
+    config.sample_rate = 4;
+    config.flush_period = std::chrono::hours{1};
+    config.wake_on_half_full = false;
+    return config;
+}
+}  // namespace
+
+SCENARIO("Asynchronous log") {
+    GIVEN("a log writing to a string stream") {
+        std::ostringstream out;
+        AsyncLog log{ManualConfig(16, Overflow::Drop), out};
+        const auto address = net::ip::make_address("127.0.0.1");
+
+        WHEN("a request and a response are logged") {
+            log.Request(address, "/api/v1/maps?\"x\""sv, http::verb::get);
+            log.Response(15, 200, "application/json"sv);
+            log.Flush();
+            const auto lines = Lines(out.str());
+            THEN("the lines have the same JSON as the synchronous log") {
+                REQUIRE(lines.size() == 2);
+                CHECK_THAT(lines[0], StartsWith("{\"timestamp\":\""));
+                CHECK_THAT(lines[0], EndsWith("\",\"data\":{\"address\":\"127.0.0.1\","
+                    "\"URI\":\"/api/v1/maps?\\\"x\\\"\",\"method\":\"GET\"},\"message\":\"request received\"}"));
+                CHECK_THAT(lines[1], EndsWith("\"data\":{\"response_time\":15,\"code\":200,"
+                    "\"content_type\":\"application/json\"},\"message\":\"response sent\"}"));
+            }
+        }
+        WHEN("the data does not fit a record") {
+            const std::string uri(LogRecord::TEXT_CAPACITY + 1, 'a');
+            log.Request(address, uri, http::verb::post);
+            log.Line("{\"port\":8080}", "server started"sv);
+            log.Flush();
+            const auto lines = Lines(out.str());
+            THEN("it is written through the line queue") {
+                REQUIRE(lines.size() == 2);
+                CHECK_THAT(lines[0], ContainsSubstring(uri));
+                CHECK_THAT(lines[1], EndsWith("\"data\":{\"port\":8080},\"message\":\"server started\"}"));
+            }
+        }
+        WHEN("the buffer overflows") {
+            for (int i = 0; i < 20; ++i)
+                log.Response(i, 200, ""sv);
+            log.Flush();
+            const auto lines = Lines(out.str());
+            THEN("extra records are dropped and the loss is logged") {
+                CHECK(log.GetStats().written == 16);
+                CHECK(log.GetStats().dropped == 4);
+                REQUIRE(lines.size() == 17);
+                CHECK_THAT(lines[0], ContainsSubstring("\"content_type\":\"null\""));
+                CHECK_THAT(lines[16], EndsWith("\"data\":{\"dropped\":4,\"sampled\":0},"
+                    "\"message\":\"log records lost\"}"));
+            }
+        }
+    }
+    GIVEN("a log with the sample policy") {
+        std::ostringstream out;
+        AsyncLog log{ManualConfig(16, Overflow::Sample), out};
+        WHEN("the buffer fills up") {
+            for (int i = 0; i < 28; ++i)
+                log.Response(i, 200, "text/html"sv);
+            log.Flush();
+            THEN("records after 3/4 of the buffer are sampled") {
+                const auto stats = log.GetStats();
+                // 12 записей до порога и каждая 4-я из следующих 16
+                CHECK(stats.written == 16);
+                CHECK(stats.sampled == 12);
+                CHECK(stats.dropped == 0);
+            }
+        }
+    }
+}
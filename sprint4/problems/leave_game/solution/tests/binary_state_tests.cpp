@@ -0,0 +1,62 @@
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+
+#include "../src/binary_state.h"
+#include "../src/json_loader.h"
+
+using namespace app;
+using namespace std::literals;
+
+SCENARIO("Binary game state") {
+    GIVEN("a session with moving dogs and loot") {
+        auto game = json_loader::LoadGame("../tests/config_test.json"sv);
+        auto* session = game->FindOrAddGameSession(model::Map::Id{"map1"s});
+        auto rex = session->AddDog("Rex"s);
+        session->AddDog("Spot"s);
+        session->Tick(0ms);
+        session->PushMove(rex, model::Move::LEFT);
+        session->Tick(10s);
+        auto snapshot = session->GetSnapshot();
+
+        WHEN("the snapshot is encoded") {
+            const auto data = BinaryState::Encode(*snapshot);
+            THEN("records have fixed width") {
+                size_t bag_items = 0;
+                for (const auto& dog : snapshot->dogs)
+                    bag_items += dog.bag.size();
+                CHECK(data.size() == BinaryState::HEADER_SIZE
+                    + snapshot->dogs.size() * BinaryState::DOG_SIZE
+                    + bag_items * BinaryState::BAG_ITEM_SIZE
+                    + snapshot->loots.size() * BinaryState::LOOT_SIZE);
+            }
+            THEN("the reference decoder restores the state") {
+                const auto state = BinaryState::Decode(data);
+                CHECK(state.version == snapshot->version);
+                REQUIRE(state.dogs.size() == snapshot->dogs.size());
+                for (size_t i = 0; i < state.dogs.size(); ++i) {
+                    const auto& decoded = state.dogs[i];
+                    const auto& dog = snapshot->dogs[i];
+                    CHECK(decoded.id == dog.id);
+                    CHECK(decoded.pos == dog.pos);
+                    CHECK(decoded.speed == dog.speed);
+                    CHECK(decoded.dir == dog.dir);
+                    CHECK(decoded.score == dog.score);
+                    REQUIRE(decoded.bag.size() == dog.bag.size());
+                    for (size_t j = 0; j < dog.bag.size(); ++j) {
+                        CHECK(decoded.bag[j].id == dog.bag[j].id);
+                        CHECK(decoded.bag[j].type == dog.bag[j].type);
+                    }
+                }
+                REQUIRE(state.loots.size() == snapshot->loots.size());
+                for (size_t i = 0; i < state.loots.size(); ++i)
+                    CHECK(state.loots[i] == snapshot->loots[i].loot);
+            }
+            THEN("damaged data is rejected") {
+                CHECK_THROWS_AS(BinaryState::Decode(std::string_view{data}.substr(0, data.size() - 1)),
+                    std::invalid_argument);
+                CHECK_THROWS_AS(BinaryState::Decode(data + "x"s), std::invalid_argument);
+                CHECK_THROWS_AS(BinaryState::Decode("{}"sv), std::invalid_argument);
+            }
+        }
+    }
+}
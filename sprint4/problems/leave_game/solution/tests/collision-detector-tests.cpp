@@ -7,6 +7,7 @@
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include <catch2/catch_approx.hpp>
 #include <sstream>
+#include <random>
 
 #include "../src/model/collision_detector.h"
 
@@ -269,5 +270,73 @@ SCENARIO("Collision detector", "[Collision detector]") {
             }
         }
     }
-}   
+}
 
+namespace {
+// Случайная сцена: собиратели двигаются вдоль осей (как собаки по дорогам)
+// и по диагонали, часть стоит на месте
+ItemGatherer MakeRandomScene(size_t gatherers, size_t items, double map_size, unsigned seed) {
+    std::mt19937 gen{seed};
+    std::uniform_real_distribution<double> coord{0.0, map_size};
+    std::uniform_real_distribution<double> step{-3.0, 3.0};
+    std::uniform_int_distribution<int> kind{0, 3};
+    ItemGatherer scene;
+    for (size_t i = 0; i < items; ++i) {
+        scene.Add(Item{.position{coord(gen), coord(gen)}, .width = i % 5 == 0 ? 0.25 : 0.0});
+    }
+    for (size_t g = 0; g < gatherers; ++g) {
+        Point2D start{coord(gen), coord(gen)};
+        Point2D end = start;
+        switch (kind(gen)) {
+        case 0: end.x += step(gen); break;
+        case 1: end.y += step(gen); break;
+        case 2: end.x += step(gen); end.y += step(gen); break;
+        default: break;
+        }
+        scene.Add(Gatherer{.start_pos = start, .end_pos = end, .width = 0.3});
+    }
+    return scene;
+}
+}  // namespace
+
+SCENARIO("Grid broad phase matches brute force", "[Collision detector]") {
+    GIVEN("random scenes of different density") {
+        THEN("grid and brute force produce identical event lists") {
+            for (unsigned seed = 1; seed <= 20; ++seed) {
+                INFO("seed " << seed);
+                auto scene = MakeRandomScene(50 * seed, 40 * seed, 10.0 + 5.0 * seed, seed);
+                auto expected = FindGatherEventsBruteForce(scene);
+                auto grid = FindGatherEvents(scene);
+                auto coarse_grid = FindGatherEvents(scene, 7.5);
+                REQUIRE(grid.size() == expected.size());
+                REQUIRE(coarse_grid.size() == expected.size());
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    CHECK(grid[i].item_id == expected[i].item_id);
+                    CHECK(grid[i].gatherer_id == expected[i].gatherer_id);
+                    CHECK(grid[i].time == expected[i].time);
+                    CHECK(grid[i].sq_distance == expected[i].sq_distance);
+                    CHECK(coarse_grid[i].item_id == expected[i].item_id);
+                    CHECK(coarse_grid[i].gatherer_id == expected[i].gatherer_id);
+                }
+            }
+        }
+    }
+    AND_GIVEN("gatherers outside the items area") {
+        ItemGatherer scene;
+        scene.Set(one_item);
+        scene.Add(Gatherer{.start_pos{-100.0, -100.0}, .end_pos{-90.0, -100.0}, .width = 1.0});
+        scene.Add(Gatherer{.start_pos{0.0, 0.0}, .end_pos{10.0, 0.0}, .width = 1.0});
+        THEN("only the reachable item is gathered") {
+            auto events = FindGatherEvents(scene);
+            REQUIRE(events.size() == 1);
+            CHECK(events[0].gatherer_id == 1);
+            CHECK(events[0].item_id == 0);
+        }
+    }
+    AND_GIVEN("non-positive cell size") {
+        ItemGatherer scene;
+        THEN("it is rejected") {
+            CHECK_THROWS_AS(FindGatherEvents(scene, 0.0), std::invalid_argument);
+        }
+    }
+}
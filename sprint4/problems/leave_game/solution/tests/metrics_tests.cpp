@@ -0,0 +1,81 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../src/metrics.h"
+
+using namespace metrics;
+using namespace std::literals;
+using Catch::Matchers::ContainsSubstring;
+
+SCENARIO("Metrics registry") {
+    GIVEN("a histogram with fixed bounds") {
+        HistogramSet<2, 3> histogram{{10, 100, 1000}};
+        WHEN("values are observed") {
+            for (uint64_t value : {5, 10, 11, 100, 5000})
+                histogram.Observe(1, value);
+            THEN("each value falls into the first bucket not below it") {
+                const auto snapshot = histogram.Collect(1);
+                CHECK(snapshot.intervals == std::array<uint64_t, 4>{2, 2, 0, 1});
+                CHECK(snapshot.count == 5);
+                CHECK(snapshot.sum == 5126);
+                CHECK(histogram.Collect(0).count == 0);
+            }
+        }
+    }
+    GIVEN("counters updated from several threads") {
+        auto counters = std::make_unique<CounterSet<2>>();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 10'000; ++i) {
+                    counters->Add(0);
+                    counters->Add(1, 3);
+                    counters->Sub(1);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        THEN("the value is the sum over all shards") {
+            CHECK(counters->Value(0) == 80'000);
+            CHECK(counters->Value(1) == 160'000);
+        }
+    }
+    GIVEN("a registry") {
+        auto registry = std::make_unique<Registry>();
+        registry->ObserveRequest(defs::TypeRequest::Join, 200, 300us);
+        registry->ObserveRequest(defs::TypeRequest::Join, 200, 2ms);
+        registry->ObserveRequest(defs::TypeRequest::StaticFiles, 418, 50us);
+        registry->ConnectionOpened(Registry::Connection::Http);
+        registry->ConnectionOpened(Registry::Connection::Http);
+        registry->ConnectionClosed(Registry::Connection::Http);
+        registry->StrandQueued(Registry::Strand::Session);
+        registry->AddBytesSent(1024);
+        registry->ObserveTick(1500us);
+        const auto text = registry->Format();
+        THEN("it is exposed in the Prometheus text format") {
+            CHECK_THAT(text, ContainsSubstring("# TYPE game_server_request_duration_seconds histogram\n"));
+            CHECK_THAT(text, ContainsSubstring(
+                "game_server_request_duration_seconds_bucket{endpoint=\"join\",code=\"200\",le=\"0.00025\"} 0\n"));
+            CHECK_THAT(text, ContainsSubstring(
+                "game_server_request_duration_seconds_bucket{endpoint=\"join\",code=\"200\",le=\"0.0025\"} 2\n"));
+            CHECK_THAT(text, ContainsSubstring(
+                "game_server_request_duration_seconds_bucket{endpoint=\"join\",code=\"200\",le=\"+Inf\"} 2\n"));
+            CHECK_THAT(text, ContainsSubstring(
+                "game_server_request_duration_seconds_sum{endpoint=\"join\",code=\"200\"} 0.0023\n"));
+            CHECK_THAT(text, ContainsSubstring(
+                "game_server_request_duration_seconds_count{endpoint=\"static\",code=\"other\"} 1\n"));
+            CHECK_THAT(text, ContainsSubstring("game_server_open_connections{kind=\"http\"} 1\n"));
+            CHECK_THAT(text, ContainsSubstring("game_server_strand_queue_depth{strand=\"session\"} 1\n"));
+            CHECK_THAT(text, ContainsSubstring("game_server_sent_bytes_total 1024\n"));
+            CHECK_THAT(text, ContainsSubstring("game_server_tick_duration_seconds_bucket{le=\"0.0025\"} 1\n"));
+            CHECK_THAT(text, ContainsSubstring("game_server_tick_duration_seconds_count 1\n"));
+        }
+        THEN("series without requests are not listed") {
+            CHECK(text.find("endpoint=\"state\"") == std::string::npos);
+        }
+    }
+}
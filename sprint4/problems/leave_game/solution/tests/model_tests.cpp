@@ -1,4 +1,6 @@
 #include <cmath>
+#include <random>
+#include <thread>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
 #include <catch2/matchers/catch_matchers.hpp>
@@ -105,7 +107,7 @@ SCENARIO("Game model") {
 			AND_THEN("move dog") {
 				game->SetRandomizeSpawnPoints(false);
 				auto game_session = game->AddGameSession(map_id);
-				auto dog = game_session->AddDog("nop");
+				auto dog = game_session->FindDog(game_session->AddDog("nop"));
 				THEN("default direction") {
 					CHECK(dog->GetDirection() == "U");
 					CHECK_THAT(dog->GetPoint(), Is2D<geom::Point2D>({ 0.0, 0.0 }));
@@ -120,7 +122,7 @@ SCENARIO("Game model") {
 			AND_THEN("move dog tick") {
 				game->SetRandomizeSpawnPoints(false);
 				auto game_session = game->AddGameSession(map_id);
-				auto dog = game_session->AddDog("nop");
+				auto dog = game_session->FindDog(game_session->AddDog("nop"));
 				game_session->MoveDog(dog->GetId(), model::Move::RIGHT);
 				THEN("move") {
 					game->Tick(1000ms);
@@ -149,3 +151,378 @@ SCENARIO("Game model") {
 		}
 	}
 }
+
+SCENARIO("Dog store") {
+	using namespace model;
+	GIVEN("a store with three dogs") {
+		DogStore store;
+		for (uint64_t id = 0; id < 3; ++id) {
+			Dog dog{Dog::Id{id}, "dog"s + std::to_string(id), geom::Point2D{double(id), 0.0}};
+			dog.AddScore(static_cast<Score>(id * 10));
+			store.Add(std::move(dog));
+		}
+		WHEN("dogs are looked up by id") {
+			THEN("each dog is found with its data") {
+				REQUIRE(store.size() == 3);
+				auto dog = store.Find(Dog::Id{1});
+				REQUIRE(dog.has_value());
+				CHECK(dog->GetName() == "dog1"s);
+				CHECK(dog->GetScore() == 10);
+				CHECK_THAT(dog->GetPoint(), Is2D<geom::Point2D>({ 1.0, 0.0 }));
+			}
+		}
+		AND_WHEN("a dog in the middle is erased") {
+			store.Erase(Dog::Id{0});
+			THEN("remaining dogs keep their data") {
+				CHECK(store.size() == 2);
+				CHECK_FALSE(store.Contains(Dog::Id{0}));
+				auto dog = store.Find(Dog::Id{2});
+				REQUIRE(dog.has_value());
+				CHECK(dog->GetName() == "dog2"s);
+				CHECK(dog->GetScore() == 20);
+				CHECK_THAT(dog->GetPoint(), Is2D<geom::Point2D>({ 2.0, 0.0 }));
+			}
+		}
+		AND_WHEN("a dog with an existing id is added") {
+			THEN("it is rejected") {
+				CHECK_THROWS_AS(store.Add(Dog{Dog::Id{1}, "dup"s, {}}), std::invalid_argument);
+			}
+		}
+		AND_WHEN("loots are returned to the base") {
+			auto slot = *store.FindSlot(Dog::Id{2});
+			store.Bag(slot).Insert(Loot{ Loot::Id{0}, 1u, {} });
+			store.ReturnLoots(slot, LootsParam{ 5, 7 });
+			THEN("score is increased and the bag is empty") {
+				CHECK(store.Find(Dog::Id{2})->GetScore() == 27);
+				CHECK(store.Find(Dog::Id{2})->GetLoots().empty());
+			}
+		}
+	}
+}
+
+SCENARIO("Loots slot map") {
+	using namespace model;
+	GIVEN("session loots and an empty bag") {
+		Loots loots;
+		auto h0 = loots.Insert(Loot{ Loot::Id{0}, 0u, { 0.0, 0.0 } });
+		auto h1 = loots.Insert(Loot{ Loot::Id{1}, 1u, { 1.0, 0.0 } });
+		auto h2 = loots.Insert(Loot{ Loot::Id{2}, 0u, { 2.0, 0.0 } });
+		Loots bag;
+		WHEN("a loot is moved to the bag") {
+			auto moved = loots.MoveTo(h0, bag);
+			THEN("it leaves the session and its old handle becomes stale") {
+				REQUIRE(moved.has_value());
+				CHECK(loots.size() == 2);
+				CHECK_FALSE(loots.Contains(h0));
+				CHECK_FALSE(loots.MoveTo(h0, bag).has_value());
+				CHECK(bag.size() == 1);
+				CHECK(bag.Find(*moved)->id == Loot::Id{0});
+			}
+			THEN("remaining handles still address their loots") {
+				CHECK(loots.Find(h1)->id == Loot::Id{1});
+				CHECK(loots.Find(h2)->id == Loot::Id{2});
+			}
+			AND_WHEN("a new loot reuses the freed slot") {
+				auto h3 = loots.Insert(Loot{ Loot::Id{3}, 1u, { 3.0, 0.0 } });
+				THEN("the stale handle does not address it") {
+					CHECK(h3.index == h0.index);
+					CHECK_FALSE(loots.Contains(h0));
+					CHECK(loots.Find(h3)->id == Loot::Id{3});
+				}
+			}
+		}
+		WHEN("the storage is cleared") {
+			loots.clear();
+			THEN("all handles become stale") {
+				CHECK(loots.empty());
+				CHECK_FALSE(loots.Contains(h1));
+				CHECK_FALSE(loots.Contains(h2));
+			}
+		}
+	}
+}
+
+SCENARIO("Road index") {
+	using namespace model;
+	GIVEN("random overlapping roads") {
+		std::mt19937 gen{7};
+		std::uniform_int_distribution<Coord> coord{0, 30};
+		Map::Roads roads;
+		for (int i = 0; i < 60; ++i) {
+			Point start{ coord(gen), coord(gen) };
+			if (i % 2 == 0)
+				roads.emplace_back(Road::HORIZONTAL, start, coord(gen), 0.4);
+			else
+				roads.emplace_back(Road::VERTICAL, start, coord(gen), 0.4);
+		}
+		const RoadIndex index{ roads, 0.4 };
+		THEN("every cell is covered by the same roads as by a full scan") {
+			auto covers = [](const Road& road, Point cell) {
+				auto start = road.GetStart();
+				auto end = road.GetEnd();
+				if (road.IsHorizontal() && cell.y == start.y
+					&& cell.x >= std::min(start.x, end.x) && cell.x <= std::max(start.x, end.x))
+					return true;
+				return road.IsVertical() && cell.x == start.x
+					&& cell.y >= std::min(start.y, end.y) && cell.y <= std::max(start.y, end.y);
+			};
+			for (Coord x = -1; x <= 31; ++x) {
+				for (Coord y = -1; y <= 31; ++y) {
+					std::vector<std::tuple<double, double, double, double>> expected, found;
+					for (const auto& road : roads) {
+						if (road.IsHorizontal() && covers(road, { x, y }))
+							expected.push_back(road.GetRectangle());
+						// дорога нулевой длины одновременно горизонтальная и вертикальная
+						if (road.IsVertical() && covers(road, { x, y }))
+							expected.push_back(road.GetRectangle());
+					}
+					for (const auto& rect : index.RoadsAt({ x, y }))
+						found.push_back(rect.Get());
+					std::sort(expected.begin(), expected.end());
+					std::sort(found.begin(), found.end());
+					INFO("cell (" << x << ", " << y << ")");
+					CHECK(found == expected);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("Map index") {
+	GIVEN("a loaded game") {
+		auto game = json_loader::LoadGame("../tests/config_test.json"sv);
+		const auto& map = game->GetMaps().front();
+		THEN("the index is built at load time") {
+			auto map_index = game->FindMapIndex(map.GetId());
+			REQUIRE(map_index != nullptr);
+			CHECK(&map_index->GetMap() == &map);
+			CHECK(map_index->GetOfficeItems().size() == map.GetOffices().size());
+		}
+		WHEN("a game session is created and copied") {
+			auto game_session = game->AddGameSession(map.GetId());
+			model::GameSession copy = *game_session;
+			THEN("both reference the same index") {
+				CHECK(game_session->GetMapIndex() == game->FindMapIndex(map.GetId()));
+				CHECK(copy.GetMapIndex() == game_session->GetMapIndex());
+			}
+		}
+	}
+}
+
+SCENARIO("Move command queue") {
+	GIVEN("a queue fed by several producers") {
+		model::MpscQueue<std::pair<int, int>> queue;
+		constexpr int PRODUCERS = 4;
+		constexpr int COMMANDS = 10000;
+		{
+			std::vector<std::jthread> producers;
+			for (int p = 0; p < PRODUCERS; ++p) {
+				producers.emplace_back([&queue, p] {
+					for (int i = 0; i < COMMANDS; ++i)
+						queue.Push({ p, i });
+				});
+			}
+		}
+		THEN("a single drain returns every command in per-producer order") {
+			std::vector<int> next(PRODUCERS, 0);
+			size_t count = queue.Drain([&next](std::pair<int, int> command) {
+				REQUIRE(command.second == next[command.first]++);
+			});
+			CHECK(count == PRODUCERS * COMMANDS);
+			CHECK(queue.Empty());
+			CHECK(queue.Drain([](auto&&) {}) == 0);
+		}
+	}
+	GIVEN("a game session with two dogs") {
+		auto game = json_loader::LoadGame("../tests/config_test.json"sv);
+		auto session = game->AddGameSession(game->GetMaps().front().GetId());
+		auto rex = session->AddDog("Rex"sv);
+		auto bob = session->AddDog("Bob"sv);
+		WHEN("several moves are pushed to one dog within a tick") {
+			// последняя команда задаёт направление, отличное от исходного (NORTH)
+			session->PushMove(rex, model::Move::UP);
+			session->PushMove(rex, model::Move::LEFT);
+			session->PushMove(rex, model::Move::RIGHT);
+			THEN("nothing changes until the commands are applied") {
+				CHECK(session->FindDog(rex)->GetSpeed() == geom::Speed2D{});
+				CHECK(session->FindDog(rex)->GetDir() == model::Direction::NORTH);
+			}
+			THEN("the last pushed move wins at the tick boundary") {
+				session->Tick(0ms);
+				const auto speed = game->GetMaps().front().GetDogSpeed();
+				CHECK(session->FindDog(rex)->GetDir() == model::Direction::EAST);
+				CHECK(session->FindDog(rex)->GetSpeed() == geom::Speed2D{speed, 0.0});
+				CHECK(session->FindDog(bob)->GetSpeed() == geom::Speed2D{});
+			}
+		}
+		WHEN("the dog leaves before its command is applied") {
+			session->PushMove(bob, model::Move::DOWN);
+			session->DeleteDog(bob);
+			THEN("the command is ignored") {
+				CHECK_NOTHROW(session->ApplyPendingMoves());
+				CHECK(session->GetDogs().size() == 1);
+			}
+		}
+	}
+}
+
+SCENARIO("Session snapshot") {
+	GIVEN("a game session") {
+		auto game = json_loader::LoadGame("../tests/config_test.json"sv);
+		auto session = game->AddGameSession(game->GetMaps().front().GetId());
+		THEN("an empty snapshot is published on creation") {
+			auto snapshot = session->GetSnapshot();
+			REQUIRE(snapshot != nullptr);
+			CHECK(snapshot->dogs.empty());
+			CHECK(snapshot->roster->dogs.empty());
+		}
+		WHEN("a dog joins") {
+			auto rex = session->AddDog("Rex"sv);
+			auto snapshot = session->GetSnapshot();
+			THEN("the roster and the dog are published at once") {
+				REQUIRE(snapshot->dogs.size() == 1);
+				CHECK(snapshot->dogs.front().id == rex);
+				REQUIRE(snapshot->roster->dogs.size() == 1);
+				CHECK(snapshot->roster->dogs.front().second == "Rex"s);
+				CHECK(snapshot->loots.size() == session->GetLoots().size());
+			}
+			AND_WHEN("the dog moves and the session ticks") {
+				session->PushMove(rex, model::Move::RIGHT);
+				session->Tick(100ms);
+				auto next = session->GetSnapshot();
+				THEN("a new snapshot replaces the old one, which stays intact") {
+					CHECK(next != snapshot);
+					CHECK(snapshot->dogs.front().speed == geom::Speed2D{});
+					CHECK(next->dogs.front().speed != geom::Speed2D{});
+					CHECK(next->dogs.front().pos == session->FindDog(rex)->GetPoint());
+				}
+				THEN("the roster is shared while nobody joins or leaves") {
+					CHECK(next->roster == snapshot->roster);
+				}
+			}
+		}
+		WHEN("snapshots are read while the session ticks") {
+			for (int i = 0; i < 100; ++i)
+				session->MoveDog(session->AddDog("dog"sv), model::Move::RIGHT);
+			std::atomic<bool> stop = false;
+			std::atomic<size_t> reads = 0;
+			std::jthread reader([&] {
+				while (!stop) {
+					auto snapshot = session->GetSnapshot();
+					if (snapshot->dogs.size() == snapshot->roster->dogs.size())
+						++reads;
+				}
+			});
+			for (int i = 0; i < 200; ++i)
+				session->Tick(10ms);
+			stop = true;
+			reader.join();
+			THEN("every snapshot read is consistent") {
+				CHECK(reads > 0);
+			}
+		}
+	}
+}
+
+SCENARIO("Snapshot versions") {
+	GIVEN("a session with two dogs") {
+		auto game = json_loader::LoadGame("../tests/config_test.json"sv);
+		auto session = game->AddGameSession(game->GetMaps().front().GetId());
+		auto rex = session->AddDog("Rex"sv);
+		auto bob = session->AddDog("Bob"sv);
+		// собаки могли появиться прямо на трофеях и подобрать их на первом тике
+		session->Tick(0ms);
+		auto find = [](const auto& snapshot, model::Dog::Id id) {
+			return *std::find_if(snapshot->dogs.begin(), snapshot->dogs.end(),
+				[id](const auto& dog) { return dog.id == id; });
+		};
+		auto start = session->GetSnapshot();
+		WHEN("nothing changes during a tick") {
+			session->Tick(0ms);
+			THEN("the snapshot and its version are kept") {
+				CHECK(session->GetSnapshot() == start);
+			}
+		}
+		WHEN("one dog starts moving") {
+			session->PushMove(rex, model::Move::RIGHT);
+			session->Tick(10ms);
+			auto moved = session->GetSnapshot();
+			THEN("the version grows and only that dog is marked as changed") {
+				CHECK(moved->version == start->version + 1);
+				CHECK(find(moved, rex).changed_at == moved->version);
+				CHECK(find(moved, bob).changed_at == find(start, bob).changed_at);
+				CHECK(moved->CoversSince(start->version));
+			}
+		}
+		WHEN("a dog leaves") {
+			session->DeleteDog(bob);
+			auto after = session->GetSnapshot();
+			THEN("its removal is recorded with the new version") {
+				REQUIRE(after->removed_dogs.size() == 1);
+				CHECK(after->removed_dogs.front().id == bob);
+				CHECK(after->removed_dogs.front().version == after->version);
+			}
+		}
+		WHEN("more removals happen than the history keeps") {
+			const auto first = start->version;
+			for (size_t i = 0; i <= model::SessionSnapshot::MAX_REMOVALS; ++i)
+				session->DeleteDog(session->AddDog("dog"sv));
+			auto after = session->GetSnapshot();
+			THEN("old versions are no longer covered by the history") {
+				CHECK(after->removed_dogs.size() == model::SessionSnapshot::MAX_REMOVALS);
+				CHECK_FALSE(after->CoversSince(first));
+				CHECK(after->CoversSince(after->version - 1));
+			}
+		}
+	}
+}
+
+SCENARIO("Idle dogs queue") {
+	GIVEN("a game session with two dogs") {
+		auto game = json_loader::LoadGame("../tests/config_test.json"sv);
+		auto session = game->AddGameSession(game->GetMaps().front().GetId());
+		auto rex = session->AddDog("Rex"sv);
+		auto bob = session->AddDog("Bob"sv);
+		session->Tick(5s);
+		session->PushMove(rex, model::Move::RIGHT);
+		session->Tick(1s);
+		session->PushMove(rex, model::Move::STAND);
+		session->Tick(4s);
+		WHEN("the retirement time has passed since the dogs joined") {
+			auto idle = session->TakeIdleDogs(10s);
+			THEN("only the dog that never moved is taken") {
+				REQUIRE(idle.size() == 1);
+				CHECK(idle.front() == bob);
+			}
+			AND_WHEN("the moved dog stays idle long enough") {
+				session->DeleteDog(bob);
+				CHECK(session->TakeIdleDogs(10s).empty());
+				session->Tick(6s);
+				THEN("it is taken once") {
+					auto later = session->TakeIdleDogs(10s);
+					REQUIRE(later.size() == 1);
+					CHECK(later.front() == rex);
+					CHECK(session->TakeIdleDogs(10s).empty());
+				}
+			}
+		}
+		WHEN("a dog leaves before it is taken") {
+			session->DeleteDog(bob);
+			THEN("it is dropped from the queue") {
+				CHECK(session->TakeIdleDogs(10s).empty());
+			}
+		}
+		WHEN("dogs are restored into a new session") {
+			std::vector<model::Dog> dogs;
+			for (const auto& dog : session->GetDogs())
+				dogs.push_back(dog.ToDog());
+			auto restored = game->AddGameSession(game->GetMaps().front().GetId());
+			restored->SetDogs(std::move(dogs));
+			THEN("their idle time is kept") {
+				auto idle = restored->TakeIdleDogs(10s);
+				REQUIRE(idle.size() == 1);
+				CHECK(idle.front() == bob);
+			}
+		}
+	}
+}
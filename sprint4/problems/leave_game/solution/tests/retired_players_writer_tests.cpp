@@ -0,0 +1,106 @@
+#include <catch2/catch_test_macros.hpp>
+#include <mutex>
+#include <optional>
+
+#include "../src/db/retired_players_writer.h"
+
+using namespace app;
+using namespace std::literals;
+
+namespace {
+// Репозиторий в памяти, первые fail_count записей пакета завершаются ошибкой
+class MemoryRepository : public RetiredPlayerRepository {
+public:
+    explicit MemoryRepository(int fail_count = 0)
+        : fail_count_{fail_count} {
+    }
+    void Save(const RetiredPlayer& retired_player) override {
+        Save(RetiredPlayers{retired_player});
+    }
+    void Save(const RetiredPlayers& retired_players) override {
+        std::lock_guard lock{mutex_};
+        if (fail_count_ != 0) {
+            if (fail_count_ > 0)
+                --fail_count_;
+            throw std::runtime_error("connection lost");
+        }
+        batches_.push_back(retired_players.size());
+        saved_.insert(saved_.end(), retired_players.begin(), retired_players.end());
+    }
+    RetiredPlayers Get(unsigned, unsigned) override {
+        std::lock_guard lock{mutex_};
+        return saved_;
+    }
+    std::vector<size_t> GetBatches() {
+        std::lock_guard lock{mutex_};
+        return batches_;
+    }
+
+private:
+    std::mutex mutex_;
+    int fail_count_;
+    RetiredPlayers saved_;
+    std::vector<size_t> batches_;
+};
+
+RetiredPlayers MakePlayers(size_t count) {
+    RetiredPlayers players;
+    for (size_t i = 0; i < count; ++i)
+        players.emplace_back(PlayerId::New(), "dog"s + std::to_string(i),
+            static_cast<model::Score>(i), milliseconds{1000});
+    return players;
+}
+}  // namespace
+
+SCENARIO("Write-behind of retired players") {
+    GIVEN("a writer with batches of four players") {
+        MemoryRepository repository;
+        {
+            RetiredPlayersWriter writer{repository, {.max_batch = 4}};
+            WHEN("ten players are queued") {
+                writer.Push(MakePlayers(10));
+                THEN("flush waits until all of them are written in batches") {
+                    REQUIRE(writer.Flush(5s));
+                    const auto stats = writer.GetStats();
+                    CHECK(stats.written == 10);
+                    CHECK(stats.batches == 3);
+                    for (auto size : repository.GetBatches())
+                        CHECK(size <= 4);
+                    const auto saved = repository.Get(0, 100);
+                    REQUIRE(saved.size() == 10);
+                    CHECK(saved.back().GetName() == "dog9"s);
+                }
+            }
+        }
+    }
+    GIVEN("a database that fails twice") {
+        MemoryRepository repository{2};
+        RetiredPlayersWriter writer{repository, {.retry_min = 1ms, .retry_max = 2ms}};
+        writer.Push(MakePlayers(3));
+        THEN("the batch is retried until it is written") {
+            REQUIRE(writer.Flush(5s));
+            CHECK(writer.GetStats().failures == 2);
+            CHECK(repository.Get(0, 100).size() == 3);
+        }
+    }
+    GIVEN("an unavailable database") {
+        MemoryRepository repository{-1};
+        std::optional<RetiredPlayersWriter> writer{std::in_place, repository,
+            RetiredPlayersWriter::Config{.retry_min = 1ms, .retry_max = 2ms}};
+        writer->Push(MakePlayers(3));
+        THEN("flush gives up after the timeout") {
+            CHECK_FALSE(writer->Flush(20ms));
+            CHECK(writer->GetStats().written == 0);
+        }
+        THEN("the unwritten players stay pending for the state file") {
+            CHECK_FALSE(writer->Flush(20ms));
+            const auto pending = writer->GetPending();
+            REQUIRE(pending.size() == 3);
+            CHECK(pending.front().GetName() == "dog0"s);
+        }
+        THEN("stopping the writer does not hang") {
+            writer.reset();
+            CHECK(repository.GetBatches().empty());
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+#include "../src/request_handler/uri_api.h"
+
+using namespace uri_api;
+using namespace std::literals;
+
+namespace {
+// Владелец маршрутов: запоминает, какой обработчик и с чем вызван
+struct Recorder {
+    std::string called;
+
+    StringResponse Join(std::string_view body) {
+        called = "join:"s + std::string(body);
+        return StringResponse{http::status::ok, 11};
+    }
+    StringResponse Players(const security::Token& token, std::string_view) {
+        called = "players:"s + *token;
+        return StringResponse{http::status::ok, 11};
+    }
+    StringResponse Maps(std::string_view path) {
+        called = "maps:"s + std::string(path);
+        return StringResponse{http::status::ok, 11};
+    }
+    StringResponse State(const security::Token&, const RequestData& request) {
+        called = "state:"s + std::string(request.query) + ':' + std::string(request.if_none_match);
+        return StringResponse{http::status::ok, 11};
+    }
+};
+
+using TestRoutes = Router<Recorder,
+    Route<Endpoint::JOIN_GAME, TypeRequest::Join, Match::Exact,
+        PostOnly, NoAuthorization, BodyArg, &Recorder::Join>,
+    Route<Endpoint::PLAYERS_LIST, TypeRequest::Players, Match::Exact,
+        GetHead, BearerAuthorization, BodyArg, &Recorder::Players>,
+    Route<Endpoint::MAPS, TypeRequest::Maps, Match::Prefix,
+        GetHead, NoAuthorization, PathArg, &Recorder::Maps>,
+    Route<Endpoint::GAME_STATE, TypeRequest::State, Match::Exact,
+        GetHead, BearerAuthorization, RequestDataArg, &Recorder::State>
+>;
+
+// поиск выполняется и при компиляции
+static_assert(TestRoutes::Find(Endpoint::JOIN_GAME) == 0);
+static_assert(TestRoutes::Find("/api/v1/maps/map1"sv) == 2);
+static_assert(TestRoutes::Find("/api/v1/game/joinx"sv) == TestRoutes::NOT_FOUND);
+
+constexpr std::string_view TOKEN = "6516861d89ebfff147bf2eb2b5153ae1"sv;
+
+StringResponse Dispatch(Recorder& recorder, http::verb method, std::string_view target,
+        std::string_view body = ""sv, std::string_view authorization = ""sv) {
+    StringRequest req{method, target, 11};
+    req.body() = body;
+    if (!authorization.empty())
+        req.set(http::field::authorization, authorization);
+    return TestRoutes::Dispatch(recorder, req, RequestTarget{target});
+}
+}  // namespace
+
+SCENARIO("Compile-time route table") {
+    GIVEN("routes built from endpoint constants") {
+        THEN("every exact path maps to its own route") {
+            CHECK(TestRoutes::Find(Endpoint::JOIN_GAME) == 0);
+            CHECK(TestRoutes::Find(Endpoint::PLAYERS_LIST) == 1);
+            CHECK(TestRoutes::Find(Endpoint::MAPS) == 2);
+            CHECK(TestRoutes::Find(Endpoint::GAME_STATE) == 3);
+            CHECK(TestRoutes::GetType(3) == TypeRequest::State);
+        }
+        THEN("prefix routes match nested paths only") {
+            CHECK(TestRoutes::Find("/api/v1/maps/map1"sv) == 2);
+            CHECK(TestRoutes::Find("/api/v1/maps/"sv) == 2);
+            CHECK(TestRoutes::Find("/api/v1/mapsx"sv) == TestRoutes::NOT_FOUND);
+            CHECK(TestRoutes::Find("/api/v1/game/state/x"sv) == TestRoutes::NOT_FOUND);
+        }
+        THEN("unknown paths are not found") {
+            CHECK(TestRoutes::Find(""sv) == TestRoutes::NOT_FOUND);
+            CHECK(TestRoutes::Find("/api/v1/game/"sv) == TestRoutes::NOT_FOUND);
+            CHECK(TestRoutes::GetType(TestRoutes::NOT_FOUND) == TypeRequest::None);
+        }
+    }
+    GIVEN("a route owner") {
+        Recorder recorder;
+        WHEN("requests are dispatched") {
+            THEN("handlers get the argument chosen by the route policy") {
+                CHECK(Dispatch(recorder, http::verb::post, Endpoint::JOIN_GAME, "{}"sv).result()
+                    == http::status::ok);
+                CHECK(recorder.called == "join:{}"sv);
+                Dispatch(recorder, http::verb::get, "/api/v1/maps/map1"sv);
+                CHECK(recorder.called == "maps:/api/v1/maps/map1"sv);
+                Dispatch(recorder, http::verb::get, "/api/v1/game/state?since=5"sv, ""sv, "Bearer "s + std::string(TOKEN));
+                CHECK(recorder.called == "state:since=5:"sv);
+            }
+            THEN("the authorization policy passes the token") {
+                Dispatch(recorder, http::verb::get, Endpoint::PLAYERS_LIST, ""sv, "Bearer "s + std::string(TOKEN));
+                CHECK(recorder.called == "players:"s + std::string(TOKEN));
+            }
+            THEN("policy checks reject the request before the handler") {
+                CHECK(Dispatch(recorder, http::verb::get, Endpoint::JOIN_GAME).result()
+                    == http::status::method_not_allowed);
+                CHECK(Dispatch(recorder, http::verb::get, Endpoint::PLAYERS_LIST).result()
+                    == http::status::unauthorized);
+                CHECK(Dispatch(recorder, http::verb::get, "/api/v1/nothing"sv).result()
+                    == http::status::bad_request);
+                CHECK(recorder.called.empty());
+            }
+        }
+    }
+}
@@ -45,7 +45,7 @@ SCENARIO_METHOD(Fixture, "Dog Serialization") {
             Dog dog{Dog::Id{42}, "Pluto"s, geom::Point2D{42.2, 12.5}};
             dog.AddScore(42);
             Loots loots{ { Loot::Id{10}, 2u, Point2D{0.0, 0.0} } };
-            dog.PutTheLoot(loots, loots.begin());
+            dog.PutTheLoot(loots, loots.HandleAt(0));
             CHECK(dog.GetLoots().size() == 1);
             dog.SetDirection(Direction::EAST);
             dog.SetSpeed({2.3, -1.2});
@@ -102,7 +102,7 @@ SCENARIO_METHOD(Fixture, "Dog Serialization") {
                 InputArchive input_archive{strm};
                 serialization::GameSessionRepr repr;
                 input_archive >> repr;
-                auto game_session_r = repr.Restore(game->FindMap(repr.GetMapId()), 
+                auto game_session_r = repr.Restore(game->FindMapIndex(repr.GetMapId()), 
                     game->GetRandomizeSpawnPoints(), 
                     game->GetLootGeneratorConfig());
                 CHECK(game_session.MapId() == game_session_r.MapId());
@@ -157,3 +157,33 @@ SCENARIO_METHOD(Fixture, "Dog Serialization") {
         }
     }
 }
+
+SCENARIO_METHOD(Fixture, "State saved session by session") {
+    GIVEN("an app with a player") {
+        auto game_a = json_loader::LoadGame("../tests/config_test.json"sv);
+        App t_app{*game_a, { 1, ""s }};
+        const auto body = R"({"userName": "Rex", "mapId": "map1"})"sv;
+        REQUIRE(t_app.ResponseJoin(body).second == JoinError::None);
+        WHEN("a player joins after the sessions are collected but before the state is saved") {
+            std::vector<serialization::SessionStateRepr> sessions;
+            for (auto* session : game_a->GetGameSessionList())
+                sessions.emplace_back(*session, t_app);
+            REQUIRE(t_app.ResponseJoin(R"({"userName": "Late", "mapId": "map1"})"sv).second == JoinError::None);
+            {
+                serialization::AppRepr repr{std::move(sessions), t_app};
+                output_archive << repr;
+            }
+            THEN("the state restores with the players whose dogs were saved") {
+                InputArchive input_archive{strm};
+                serialization::AppRepr repr;
+                input_archive >> repr;
+                auto game_r = json_loader::LoadGame("../tests/config_test.json"sv);
+                App app_r{*game_r, { 1, ""s }};
+                REQUIRE_NOTHROW(repr.Restore(app_r));
+                CHECK(app_r.GetPlayers().GetPlayers().size() == 1);
+                CHECK(app_r.GetPlayerTokens().GetTokens().size() == 1);
+                CHECK(t_app.GetPlayers().GetPlayers().size() == 2);
+            }
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#include <catch2/catch_test_macros.hpp>
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+#include "../src/request_handler/base_request.h"
+#include "../src/request_handler/negotiation.h"
+#include "../src/request_handler/static_index.h"
+
+using namespace http_handler;
+using namespace std::literals;
+
+namespace {
+void WriteFile(const fs::path& path, std::string_view content) {
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    out << content;
+}
+
+struct TempDir {
+    fs::path path = fs::temp_directory_path() / ("static_index_" + std::to_string(::getpid()));
+    TempDir() {
+        fs::remove_all(path);
+        fs::create_directories(path / "Assets");
+    }
+    ~TempDir() {
+        fs::remove_all(path);
+    }
+};
+}  // namespace
+
+SCENARIO("Static file index") {
+    GIVEN("a www root with small and large files") {
+        TempDir root;
+        WriteFile(root.path / "index.html", "<html></html>"sv);
+        WriteFile(root.path / "Assets" / "Model.OBJ", "v 0 0 0"sv);
+        WriteFile(root.path / "Assets" / "big.js", std::string(100, 'x'));
+        auto index = std::make_shared<StaticIndex>(root.path, 64);
+
+        THEN("files are found by case-folded path") {
+            auto file = index->Find("/assets/model.obj"sv);
+            REQUIRE(file);
+            CHECK(index->Find("/ASSETS/Model.obj"sv) == file);
+            CHECK(file->path == root.path / "Assets" / "Model.OBJ");
+            CHECK(file->size == 7);
+            CHECK_FALSE(file->etag.empty());
+            CHECK_FALSE(index->Find("/assets"sv));
+            CHECK_FALSE(index->Find("/missing.html"sv));
+            CHECK(index->GetFileCount() == 3);
+        }
+        THEN("content type comes from the extension") {
+            CHECK(index->Find("/index.html"sv)->content_type == ContentType::TEXT_HTML);
+            CHECK(index->Find("/assets/big.js"sv)->content_type == ContentType::TEXT_JS);
+        }
+        THEN("only files under the limit are kept in memory") {
+            REQUIRE(index->Find("/index.html"sv)->data);
+            CHECK(*index->Find("/index.html"sv)->data == "<html></html>"sv);
+            CHECK_FALSE(index->Find("/assets/big.js"sv)->data);
+            auto gzip = index->Find("/assets/big.js"sv)->gzip;
+            REQUIRE(gzip);
+            CHECK(index->GetCachedBytes() == 13 + 7 + gzip->size);
+        }
+        THEN("compressible files get a gzip variant when it is smaller") {
+            auto file = index->Find("/assets/big.js"sv);
+            REQUIRE(file->gzip);
+            REQUIRE(file->gzip->data);
+            CHECK(file->gzip->data->starts_with("\x1f\x8b"sv));
+            CHECK(file->gzip->size < file->size);
+            CHECK(file->gzip->etag != file->etag);
+            CHECK(file->gzip->content_type == file->content_type);
+            // слишком маленький файл и двоичный тип не сжимаются
+            CHECK_FALSE(index->Find("/index.html"sv)->gzip);
+            CHECK_FALSE(index->Find("/assets/model.obj"sv)->gzip);
+        }
+        THEN("Last-Modified is an HTTP date of the file time") {
+            auto file = index->Find("/index.html"sv);
+            CHECK(Negotiation::ParseHttpDate(file->last_modified) == file->modified);
+            CHECK_FALSE(file->fingerprinted);
+        }
+        WHEN("the directory changes and the index is refreshed") {
+            auto unchanged = index->Find("/index.html"sv)->data;
+            WriteFile(root.path / "new.css", "a{}"sv);
+            fs::remove(root.path / "Assets" / "big.js");
+            index->Refresh();
+            THEN("new files appear, removed files disappear") {
+                CHECK(index->Find("/new.css"sv));
+                CHECK_FALSE(index->Find("/assets/big.js"sv));
+            }
+            THEN("unchanged cached files are not read again") {
+                CHECK(index->Find("/index.html"sv)->data == unchanged);
+            }
+        }
+        WHEN("a precompressed sibling is built next to the file") {
+            WriteFile(root.path / "Assets" / "big.js.gz", "prebuilt"sv);
+            index->Refresh();
+            THEN("it is used as the gzip variant") {
+                auto gzip = index->Find("/assets/big.js"sv)->gzip;
+                REQUIRE(gzip);
+                CHECK(gzip->path == root.path / "Assets" / "big.js.gz");
+                CHECK(*gzip->data == "prebuilt"sv);
+            }
+        }
+#ifdef __linux__
+        WHEN("the directory is watched and a burst of files is written") {
+            net::io_context ioc;
+            auto watched = std::make_shared<StaticIndex>(root.path, 64);
+            watched->Watch(ioc);
+            for (int i = 0; i < 20; ++i)
+                WriteFile(root.path / ("burst" + std::to_string(i) + ".css"), "a{}"sv);
+            THEN("the index is rebuilt in the background after a short delay") {
+                // события обрабатываются на ioc, перестроение - в потоке индекса
+                const auto deadline = std::chrono::steady_clock::now() + 5s;
+                while (!watched->Find("/burst19.css"sv) && std::chrono::steady_clock::now() < deadline)
+                    ioc.run_for(10ms);
+                CHECK(watched->Find("/burst0.css"sv));
+                CHECK(watched->Find("/burst19.css"sv));
+            }
+        }
+#endif
+    }
+}
+
+SCENARIO("Conditional and range request helpers") {
+    using Status = Negotiation::ByteRange::Status;
+    WHEN("a single byte range is parsed") {
+        THEN("explicit, open and suffix ranges are clamped to the size") {
+            auto range = Negotiation::ParseRange("bytes=10-19"sv, 100);
+            CHECK(range.status == Status::Satisfiable);
+            CHECK((range.first == 10 && range.last == 19));
+            range = Negotiation::ParseRange("bytes=90-"sv, 100);
+            CHECK((range.first == 90 && range.last == 99));
+            range = Negotiation::ParseRange("bytes=50-1000"sv, 100);
+            CHECK((range.first == 50 && range.last == 99));
+            range = Negotiation::ParseRange("bytes=-30"sv, 100);
+            CHECK((range.first == 70 && range.last == 99));
+            range = Negotiation::ParseRange("bytes=-300"sv, 100);
+            CHECK((range.first == 0 && range.last == 99));
+        }
+        THEN("a range past the end is unsatisfiable") {
+            CHECK(Negotiation::ParseRange("bytes=100-"sv, 100).status == Status::Unsatisfiable);
+            CHECK(Negotiation::ParseRange("bytes=-0"sv, 100).status == Status::Unsatisfiable);
+        }
+        THEN("malformed and multiple ranges are ignored") {
+            CHECK(Negotiation::ParseRange(""sv, 100).status == Status::None);
+            CHECK(Negotiation::ParseRange("items=0-1"sv, 100).status == Status::None);
+            CHECK(Negotiation::ParseRange("bytes=5-1"sv, 100).status == Status::None);
+            CHECK(Negotiation::ParseRange("bytes=a-b"sv, 100).status == Status::None);
+            CHECK(Negotiation::ParseRange("bytes=0-1,5-6"sv, 100).status == Status::None);
+        }
+    }
+    WHEN("HTTP dates are formatted and parsed") {
+        THEN("IMF-fixdate round-trips") {
+            CHECK(Negotiation::FormatHttpDate(784111777) == "Sun, 06 Nov 1994 08:49:37 GMT"sv);
+            CHECK(Negotiation::ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"sv) == 784111777);
+            CHECK_FALSE(Negotiation::ParseHttpDate("yesterday"sv));
+        }
+    }
+    WHEN("file names are checked for a content fingerprint") {
+        THEN("a long hex part between separators is a fingerprint") {
+            CHECK(StaticIndex::IsFingerprinted("app.3f9a2c1e.js"sv));
+            CHECK(StaticIndex::IsFingerprinted("logo-0d5c9a7b41.min.png"sv));
+            CHECK_FALSE(StaticIndex::IsFingerprinted("3f9a2c1e.js"sv));
+            CHECK_FALSE(StaticIndex::IsFingerprinted("app.js"sv));
+            CHECK_FALSE(StaticIndex::IsFingerprinted("app.deadbee.js"sv));
+            CHECK_FALSE(StaticIndex::IsFingerprinted("release-notes.html"sv));
+        }
+    }
+}
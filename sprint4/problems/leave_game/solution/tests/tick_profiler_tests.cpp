@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include "../src/tick_profiler.h"
+
+using namespace ticker;
+using namespace std::literals;
+using Catch::Matchers::ContainsSubstring;
+
+namespace {
+TickTimes MakeTick(nanoseconds total, nanoseconds move_dogs) {
+    TickTimes times;
+    times.stages[static_cast<size_t>(Stage::Total)] = total;
+    SessionTickTimes session;
+    session.session = "map1"s;
+    session.phases[static_cast<size_t>(model::TickPhase::MoveDogs)] = move_dogs;
+    session.retirement = 3us;
+    times.sessions.push_back(session);
+    return times;
+}
+}  // namespace
+
+SCENARIO("Tick profiler") {
+    GIVEN("a rolling window") {
+        RollingWindow window;
+        WHEN("it holds fewer samples than its size") {
+            for (int i = 1; i <= 100; ++i)
+                window.Add(microseconds{i});
+            THEN("percentiles are taken by rank") {
+                const auto percentiles = window.Get();
+                CHECK(percentiles.count == 100);
+                CHECK(percentiles.p50 == 50us);
+                CHECK(percentiles.p95 == 95us);
+                CHECK(percentiles.p99 == 99us);
+                CHECK(percentiles.max == 100us);
+            }
+        }
+        WHEN("it is overfilled") {
+            for (size_t i = 0; i < RollingWindow::SIZE; ++i)
+                window.Add(1ms);
+            for (size_t i = 0; i < RollingWindow::SIZE; ++i)
+                window.Add(2us);
+            THEN("only the latest samples are kept") {
+                const auto percentiles = window.Get();
+                CHECK(percentiles.count == 2 * RollingWindow::SIZE);
+                CHECK(percentiles.max == 2us);
+            }
+        }
+    }
+    GIVEN("a profiler with 10ms period") {
+        TickProfiler profiler{10ms};
+        WHEN("ticks take longer than the period") {
+            profiler.RecordTick(MakeTick(4ms, 1ms));
+            profiler.RecordTick(MakeTick(12ms, 9ms));
+            profiler.RecordCoalesced();
+            THEN("overruns and coalesced ticks are counted") {
+                const auto report = profiler.GetReport();
+                CHECK(report.counters.ticks == 2);
+                CHECK(report.counters.overruns == 1);
+                CHECK(report.counters.coalesced_ticks == 1);
+                CHECK(report.stages[static_cast<size_t>(Stage::Total)].max == 12ms);
+                CHECK(report.stages[static_cast<size_t>(Stage::Save)].count == 0);
+            }
+            THEN("session phases are reported by map") {
+                const auto report = profiler.GetReport();
+                REQUIRE(report.sessions.contains("map1"s));
+                const auto& phases = report.sessions.at("map1"s);
+                CHECK(phases[static_cast<size_t>(model::TickPhase::MoveDogs)].p99 == 9ms);
+                CHECK(phases[RETIRE_PHASE].max == 3us);
+                CHECK_THAT(boost::json::serialize(TickProfiler::ToJson(report)),
+                    ContainsSubstring("\"overruns\":1"));
+            }
+        }
+        WHEN("the timer fires late") {
+            profiler.RecordTimer(11ms);
+            profiler.RecordTimer(13ms);
+            profiler.RecordTimer(35ms);
+            THEN("late ticks and whole skipped periods are counted") {
+                const auto counters = profiler.GetReport().counters;
+                CHECK(counters.late_timer_ticks == 2);
+                CHECK(counters.skipped_periods == 2);
+            }
+        }
+    }
+    GIVEN("a profiler for ticks by API") {
+        TickProfiler profiler;
+        profiler.RecordTimer(1s);
+        profiler.RecordTick(MakeTick(1s, 1ms));
+        THEN("there is no period to overrun") {
+            const auto counters = profiler.GetReport().counters;
+            CHECK(counters.overruns == 0);
+            CHECK(counters.late_timer_ticks == 0);
+            CHECK(!profiler.SummaryDue(steady_clock::now() + 1h));
+        }
+    }
+}
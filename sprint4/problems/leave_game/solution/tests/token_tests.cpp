@@ -0,0 +1,25 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/util/token.h"
+
+using namespace security;
+using namespace std::literals;
+
+SCENARIO("Admin bearer token") {
+    GIVEN("a configured admin token") {
+        const auto expected = "s3cr3t-admin"sv;
+        THEN("only the exact token is accepted") {
+            CHECK(CheckBearer("Bearer s3cr3t-admin"sv, expected));
+            CHECK(CheckBearer("Bearer s3cr3t-admin  "sv, expected));
+            CHECK_FALSE(CheckBearer("Bearer s3cr3t-admiN"sv, expected));
+            CHECK_FALSE(CheckBearer("Bearer s3cr3t"sv, expected));
+            CHECK_FALSE(CheckBearer("s3cr3t-admin"sv, expected));
+            CHECK_FALSE(CheckBearer(""sv, expected));
+        }
+    }
+    GIVEN("no admin token") {
+        THEN("nothing is accepted") {
+            CHECK_FALSE(CheckBearer("Bearer "sv, ""sv));
+        }
+    }
+}
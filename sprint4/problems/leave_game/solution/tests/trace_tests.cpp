@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <thread>
+
+#include "../src/util/trace.h"
+
+using namespace util;
+using namespace std::literals;
+using Catch::Matchers::ContainsSubstring;
+
+SCENARIO("Trace recorder") {
+    auto& tracer = TRACER();
+    tracer.SetBufferEvents(Tracer::DEFAULT_BUFFER_EVENTS);
+    tracer.Enable();
+    tracer.Disable();
+    GIVEN("disabled tracing") {
+        {
+            TraceSpan span{"handler"sv, "http"sv};
+        }
+        THEN("spans are not recorded") {
+            CHECK(tracer.Collect().empty());
+        }
+    }
+    GIVEN("enabled tracing") {
+        tracer.Enable();
+        {
+            TraceRequestScope scope{42};
+            TraceSpan outer{"handler"sv, "http"sv};
+            TraceSpan inner{"serialize_state"sv, "serialize"sv};
+        }
+        std::thread{[] {
+            TraceSpan span{"move_dogs"sv, "tick"sv};
+        }}.join();
+        tracer.Disable();
+        THEN("spans of every thread are collected") {
+            const auto events = tracer.Collect();
+            REQUIRE(events.size() == 3);
+            CHECK(events[0].second.name == "handler"sv);
+            CHECK(events[0].second.request == 42);
+            CHECK(events[1].second.name == "serialize_state"sv);
+            CHECK(events[2].second.request == 0);
+            CHECK(events[0].first != events[2].first);
+        }
+        THEN("the dump is in the Chrome Trace Event format") {
+            const auto dump = tracer.Dump();
+            CHECK_THAT(dump, ContainsSubstring("{\"traceEvents\":[{\"name\":\"handler\",\"cat\":\"http\",\"ph\":\"X\""));
+            CHECK_THAT(dump, ContainsSubstring("\"args\":{\"request\":42}}"));
+            CHECK_THAT(dump, ContainsSubstring("\"name\":\"move_dogs\",\"cat\":\"tick\""));
+        }
+    }
+    GIVEN("a buffer smaller than the number of spans") {
+        tracer.SetBufferEvents(4);
+        tracer.Enable();
+        const auto start = Tracer::Clock::now();
+        for (int i = 0; i < 10; ++i)
+            tracer.Record(i < 6 ? "old"sv : "new"sv, "test"sv, start + i * 1us, start + i * 1us);
+        tracer.Disable();
+        THEN("the oldest spans are overwritten") {
+            const auto events = tracer.Collect();
+            REQUIRE(events.size() == 4);
+            for (const auto& [thread, event] : events)
+                CHECK(event.name == "new"sv);
+            CHECK(events.front().second.start == start + 6us);
+        }
+    }
+}